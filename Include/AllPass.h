@@ -78,6 +78,28 @@ public:
 		//prevY = val - (prevY * amp);
 		//return out + (prevY * amp);
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// @param in input values
+	/// @param out output values
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		AmpValue g = amp;
+		AmpValue x1 = prevX;
+		AmpValue y1 = prevY;
+		for (int i = 0; i < n; i++)
+		{
+			AmpValue val = in[i];
+			y1 = (g * val) + x1 - (g * y1);
+			x1 = val;
+			out[i] = y1;
+		}
+		prevX = x1;
+		prevY = y1;
+	}
 };
 
 //@}
@@ -3,6 +3,7 @@
 #include <SynthList.h>
 #include <SynthFile.h>
 #include <SynthMutex.h>
+#include <SynthSIMD.h>
 #include <WaveTable.h>
 #include <WaveFile.h>
 
@@ -14,6 +15,7 @@
 
 #include <EnvGen.h>
 #include <EnvGenSeg.h>
+#include <GenCtl.h>
 
 #include <BiQuad.h>
 #include <AllPass.h>
@@ -31,6 +33,7 @@
 #include <MIDIControl.h>
 #include <Instrument.h>
 #include <Sequencer.h>
+#include <VoicePolicy.h>
 #include <SequenceFile.h>
 #include <MIDIInput.h>
 
@@ -162,6 +162,41 @@ public:
 		//dlyOut1 = tmp;
 		return out * gain;
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// @param in input values
+	/// @param out output values
+	/// @param n number of values
+	virtual void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		AmpValue a0 = ampIn0;
+		AmpValue a1 = ampIn1;
+		AmpValue a2 = ampIn2;
+		AmpValue b1 = ampOut1;
+		AmpValue b2 = ampOut2;
+		AmpValue g = gain;
+		AmpValue x1 = dlyIn1;
+		AmpValue x2 = dlyIn2;
+		AmpValue y1 = dlyOut1;
+		AmpValue y2 = dlyOut2;
+		for (int i = 0; i < n; i++)
+		{
+			AmpValue vin = in[i];
+			AmpValue val = (a0 * vin) + (a1 * x1) + (a2 * x2)
+			             - (b1 * y1) - (b2 * y2);
+			y2 = y1;
+			y1 = val;
+			x2 = x1;
+			x1 = vin;
+			out[i] = val * g;
+		}
+		dlyIn1 = x1;
+		dlyIn2 = x2;
+		dlyOut1 = y1;
+		dlyOut2 = y2;
+	}
 };
 
 /// BiQuadFilter optimized for Bandpass.
@@ -182,6 +217,35 @@ public:
 		dlyIn1 = vin;
 		return out * gain;
 	}
+
+	using GenUnit::Samples;
+
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		AmpValue a0 = ampIn0;
+		AmpValue b1 = ampOut1;
+		AmpValue b2 = ampOut2;
+		AmpValue g = gain;
+		AmpValue x1 = dlyIn1;
+		AmpValue x2 = dlyIn2;
+		AmpValue y1 = dlyOut1;
+		AmpValue y2 = dlyOut2;
+		for (int i = 0; i < n; i++)
+		{
+			AmpValue vin = in[i];
+			AmpValue val = (a0 * (vin - x2))
+			             - (b1 * y1) - (b2 * y2);
+			y2 = y1;
+			y1 = val;
+			x2 = x1;
+			x1 = vin;
+			out[i] = val * g;
+		}
+		dlyIn1 = x1;
+		dlyIn2 = x2;
+		dlyOut1 = y1;
+		dlyOut2 = y2;
+	}
 };
 
 ///////////////////////////////////////////////////////////
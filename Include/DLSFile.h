@@ -366,8 +366,10 @@ public:
 	/// The caller is responsible for deleteing the returned object.
 	/// @param fname path to the file
 	/// @param pre preload all samples
+	/// @param cb preload progress callback, or NULL
+	/// @param usr caller data for the callback
 	/// @returns pointer to SoundBank object.
-	SoundBank *LoadSoundBank(const char *fname, int pre = 1);
+	SoundBank *LoadSoundBank(const char *fname, int pre = 1, SBLoadCB cb = 0, Opaque usr = 0);
 
 	/// Get the info records.
 	/// @returns pointer to file info.
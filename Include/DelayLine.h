@@ -19,6 +19,8 @@
 #ifndef _DELAYLINE_H_
 #define _DELAYLINE_H_
 
+#include "SynthSIMD.h"
+
 /// Basic delay line. Delay lines store the input sample and return
 /// a sample delayed by some number of sample times. The decay
 /// setting applies an attenuator to the output of the delay line.
@@ -40,7 +42,7 @@ protected:
 	{
 		if (delayBuf)
 		{
-			delete delayBuf;
+			delete[] delayBuf;
 			delayBuf = NULL;
 			delayPos = NULL;
 			delayEnd = NULL;
@@ -105,17 +107,22 @@ public:
 	}
 
 	/// Initialize the delay line.
+	/// The buffer is reused when the length does not change.
 	/// @param dlyTm delay time
 	/// @param decay amplitude attenuation
 	virtual void InitDL(FrqValue dlyTm, AmpValue decay = 1)
 	{
-		ReleaseBuffers();
+		int len = (int) (dlyTm * synthParams.sampleRate);
+		if (len <= 0)
+			len = 1;
+		if (delayBuf == NULL || len != delayLen)
+		{
+			ReleaseBuffers();
+			delayBuf = new AmpValue[len];
+		}
 		delayTime = dlyTm;
 		decayFactor = decay;
-		delayLen = (int) (delayTime * synthParams.sampleRate);
-		if (delayLen <= 0)
-			delayLen = 1;
-		delayBuf = new AmpValue[delayLen];
+		delayLen = len;
 		delayEnd = delayBuf + delayLen;
 		Clear();
 	}
@@ -224,6 +231,50 @@ public:
 		SetIn(inval + out);
 		return out;
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// The block is split where the delay buffer wraps. Each part
+	/// is no longer than the delay, thus the samples in the part
+	/// do not depend on each other and the SIMD kernel can be used.
+	/// @param in input values
+	/// @param out output values (may be the same as in)
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		Block(synthSIMD.Comb, in, out, n);
+	}
+
+	/// Process a block of samples and add the output.
+	/// @param in input values
+	/// @param out accumulated output values
+	/// @param n number of values
+	void SamplesAdd(const AmpValue *in, AmpValue *out, int n)
+	{
+		Block(synthSIMD.CombAdd, in, out, n);
+	}
+
+protected:
+	/// Apply a delay kernel to a block, one buffer run at a time.
+	void Block(void (*fn)(AmpValue*, AmpValue*, const AmpValue*, AmpValue, int),
+		const AmpValue *in, AmpValue *out, int n)
+	{
+		if (delayBuf == NULL)
+			return;
+		while (n > 0)
+		{
+			int cnt = (int) (delayEnd - delayPos);
+			if (cnt > n)
+				cnt = n;
+			fn(out, delayPos, in, decayFactor, cnt);
+			if ((delayPos += cnt) >= delayEnd)
+				delayPos = delayBuf;
+			in += cnt;
+			out += cnt;
+			n -= cnt;
+		}
+	}
 };
 
 /// Variable delay tap delay line.
@@ -315,6 +366,17 @@ public:
 		SetIn(vn);
 		return vm + (vn * decayFactor);
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// @param in input values
+	/// @param out output values (may be the same as in)
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		Block(synthSIMD.AllPass, in, out, n);
+	}
 };
 
 /// All-pass delay line (2).
@@ -397,8 +459,8 @@ public:
 		DelayLine::ReleaseBuffers();
 		if (delayTaps)
 		{
-			delete delayTaps;
-			delete decayTaps;
+			delete[] delayTaps;
+			delete[] decayTaps;
 			delayTaps = NULL;
 			decayTaps = NULL;
 		}
@@ -423,6 +485,13 @@ public:
 	/// Initialize the delay line length and number of taps
 	void InitDLT(FrqValue dlyTm, int taps, AmpValue decay = 1)
 	{
+		if (delayTaps)
+		{
+			delete[] delayTaps;
+			delete[] decayTaps;
+			delayTaps = NULL;
+			decayTaps = NULL;
+		}
 		DelayLine::InitDL(dlyTm, decay);
 
 		numTaps = taps;
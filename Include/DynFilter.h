@@ -79,6 +79,17 @@ public:
 		return BiQuadFilter::Sample(in);
 	}
 
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// The coefficients can change on each sample, so this
+	/// only avoids the virtual call.
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		for (int i = 0; i < n; i++)
+			out[i] = DynFilterLP::Sample(in[i]);
+	}
+
 	void SetStart(AmpValue val)  { env.SetStart(val); }
 	void SetAtkRt(FrqValue val)  { env.SetAtkRt(val); }
 	void SetAtkLvl(AmpValue val) { env.SetAtkLvl(val); }
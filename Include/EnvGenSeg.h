@@ -171,6 +171,26 @@ public:
 		return value;
 	}
 
+	/// Generate values to the end of the segment.
+	/// This produces the same values as calling Gen() until
+	/// IsFinished() returns true, but stops after n values.
+	/// Derived classes override this to avoid a virtual call
+	/// for each value.
+	/// @param dst output values
+	/// @param n maximum number of values
+	/// @return number of values generated
+	virtual int GenRun(AmpValue *dst, int n)
+	{
+		int m = 0;
+		while (m < n)
+		{
+			dst[m++] = value;
+			if (--count <= 0)
+				break;
+		}
+		return m;
+	}
+
 	/// Test if the envelope segment is finished. When the segment reaches the
 	/// end, this return true. This is used by multi-segment generators to
 	/// determine when to move to the next segment. It is also used 
@@ -223,6 +243,23 @@ public:
 		return end;
 	}
 
+	/// @copydoc EnvSeg::GenRun()
+	virtual int GenRun(AmpValue *dst, int n)
+	{
+		int m = 0;
+		while (m < n)
+		{
+			if (--count > 0)
+				dst[m++] = value += incr;
+			else
+			{
+				dst[m++] = end;
+				break;
+			}
+		}
+		return m;
+	}
+
 };
 
 ///////////////////////////////////////////////////////////
@@ -296,6 +333,26 @@ public:
 		}
 		return end;
 	}
+
+	/// @copydoc EnvSeg::GenRun()
+	virtual int GenRun(AmpValue *dst, int n)
+	{
+		int m = 0;
+		while (m < n)
+		{
+			if (--count > 0)
+			{
+				value *= incr;
+				dst[m++] = ((value - bias) * range) + offs;
+			}
+			else
+			{
+				dst[m++] = end;
+				break;
+			}
+		}
+		return m;
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -350,6 +407,26 @@ public:
 		}
 		return end;
 	}
+
+	/// @copydoc EnvSeg::GenRun()
+	virtual int GenRun(AmpValue *dst, int n)
+	{
+		int m = 0;
+		while (m < n)
+		{
+			if (--count > 0)
+			{
+				value *= incr;
+				dst[m++] = ((1.0 - (value - bias)) * range) + offs;
+			}
+			else
+			{
+				dst[m++] = end;
+				break;
+			}
+		}
+		return m;
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -400,6 +477,26 @@ public:
 		}
 		return end;
 	}
+
+	/// @copydoc EnvSeg::GenRun()
+	virtual int GenRun(AmpValue *dst, int n)
+	{
+		int m = 0;
+		while (m < n)
+		{
+			if (--count > 0)
+			{
+				value += incr;
+				dst[m++] = start + (range * (value * value));
+			}
+			else
+			{
+				dst[m++] = end;
+				break;
+			}
+		}
+		return m;
+	}
 };
 
 /// Structure to hold values for an envelope segment.
@@ -583,7 +680,13 @@ struct EnvDef
 	/// @param dp source object
 	void Copy(EnvDef *dp)
 	{
-		Alloc(dp->nsegs, dp->start, dp->suson);
+		if (segs && nsegs == dp->nsegs)
+		{
+			start = dp->start;
+			suson = 1;
+		}
+		else
+			Alloc(dp->nsegs, dp->start, dp->suson);
 		if (nsegs > 0)
 			memcpy(segs, dp->segs, nsegs*sizeof(SegVals));
 	}
@@ -620,6 +723,16 @@ public:
 	/// returned until Reset() is called.
 	virtual AmpValue Gen() { return 0.0; }
 
+	/// Generate a block of values.
+	/// This produces the same values as calling Gen() n times.
+	/// @param dst output values
+	/// @param n number of values
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		while (--n >= 0)
+			*dst++ = Gen();
+	}
+
 	/// Generate the next value and multiply by the
 	/// current sample value.
 	/// @param in current sample amplitude value
@@ -883,6 +996,12 @@ public:
 		return segStart; 
 	}
 
+	/// Get the most recent value returned by Gen().
+	inline AmpValue GetValue()
+	{
+		return lastVal;
+	}
+
 	/// Get the rate for a segment.
 	/// @param segn segment number
 	inline FrqValue GetRate(int segn)
@@ -1144,6 +1263,53 @@ public:
 		return lastVal;
 	}
 
+	/// @copydoc EnvGenUnit::GenBlock()
+	/// Each segment generates a run of values with one call,
+	/// and the sustain and end levels are filled in directly.
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		int m;
+		while (n > 0)
+		{
+			switch (state)
+			{
+			case 0:
+				m = seg->GenRun(dst, n);
+				lastVal = dst[m-1];
+				if (seg->IsFinished())
+				{
+					if (index == relSeg)
+						state = 1;
+					else
+						NextSeg();
+				}
+				break;
+			case 2:
+				m = seg->GenRun(dst, n);
+				lastVal = dst[m-1];
+				if (seg->IsFinished())
+					state = 3;
+				break;
+			case 1:
+				if (!susOn)
+				{
+					NextSeg();
+					state = 2;
+					*dst = lastVal = seg->Gen();
+					m = 1;
+					break;
+				}
+				// fall through - hold the sustain level
+			default:
+				for (m = 0; m < n; m++)
+					dst[m] = lastVal;
+				break;
+			}
+			dst += m;
+			n -= m;
+		}
+	}
+
 	/// Begin the envelope release.
 	/// If the envelope is already in the release phase no action is taken. Otherwise,
 	/// the segment is moved to the release segment regardless of the current segment.
@@ -1527,6 +1693,12 @@ public:
 	{
 		return state == 3;
 	}
+
+	/// @copydoc EnvGenSeg::GetValue
+	inline AmpValue GetValue()
+	{
+		return lastVal;
+	}
 };
 
 ///////////////////////////////////////////////////////////
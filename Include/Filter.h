@@ -242,6 +242,30 @@ public:
 		return delayY;
 
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// @param in input values
+	/// @param out output values
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		AmpValue a0 = inAmp0;
+		AmpValue a1 = inAmp1;
+		AmpValue b1 = dlyAmp;
+		AmpValue x1 = delayX;
+		AmpValue y1 = delayY;
+		for (int i = 0; i < n; i++)
+		{
+			AmpValue val = in[i];
+			y1 = (val * a0) + (a1 * x1) + (y1 * b1);
+			x1 = val;
+			out[i] = y1;
+		}
+		delayX = x1;
+		delayY = y1;
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -297,6 +321,17 @@ public:
 		dlyAmp2 = out2;
 	}
 
+	/// Get the coefficients.
+	/// @param in0 input sample coefficient (a0)
+	/// @param out1 delayed sample coefficient (b1)
+	/// @param out2 delayed sample coefficient (b2)
+	void GetCoef(AmpValue& in0, AmpValue& out1, AmpValue& out2)
+	{
+		in0 = inAmp0;
+		out1 = dlyAmp1;
+		out2 = dlyAmp2;
+	}
+
 	/// Calculate coefficients. The coefficients are calculate to produce the indicated
 	/// cutoff frequency for a band-pass filter with resonance Q
 	/// @param fc cutoff frequency
@@ -334,6 +369,102 @@ public:
 	}
 };
 
+///////////////////////////////////////////////////////////
+/// Two-pole recursive filter with interpolated coefficients.
+/// This is used when the cutoff frequency is modulated.
+/// Rather than calculating the coefficients on every sample,
+/// the caller sets a new cutoff at a control rate with
+/// MoveCoef(). The coefficients move in a straight line
+/// to the new values over the given number of samples.
+/// Each step is a mix of two stable filters, and thus
+/// the filter remains stable during the move.
+///////////////////////////////////////////////////////////
+class FilterIIR2pI : public FilterIIR2p
+{
+protected:
+	AmpValue endAmp0;
+	AmpValue endAmp1;
+	AmpValue endAmp2;
+	AmpValue incAmp0;
+	AmpValue incAmp1;
+	AmpValue incAmp2;
+	bsInt32 steps;
+public:
+	FilterIIR2pI()
+	{
+		endAmp0 = 0;
+		endAmp1 = 0;
+		endAmp2 = 0;
+		incAmp0 = 0;
+		incAmp1 = 0;
+		incAmp2 = 0;
+		steps = 0;
+	}
+
+	/// Reset the filter. This clears the delay buffer
+	/// and stops any coefficient move in progress.
+	/// @param initPhs not used
+	void Reset(float initPhs = 0)
+	{
+		FilterIIR2p::Reset(initPhs);
+		if (steps > 0)
+		{
+			InitFilter(endAmp0, endAmp1, endAmp2);
+			steps = 0;
+		}
+	}
+
+	/// Move to a new cutoff frequency.
+	/// @param fc cutoff frequency
+	/// @param q  1/bandwidth
+	/// @param count number of samples for the move, 1 to change immediately
+	void MoveCoef(FrqValue fc, FrqValue q, bsInt32 count)
+	{
+		AmpValue cur0 = inAmp0;
+		AmpValue cur1 = dlyAmp1;
+		AmpValue cur2 = dlyAmp2;
+		CalcCoef(fc, q);
+		if (count <= 1)
+		{
+			steps = 0;
+			return;
+		}
+		endAmp0 = inAmp0;
+		endAmp1 = dlyAmp1;
+		endAmp2 = dlyAmp2;
+		AmpValue scl = 1.0 / (AmpValue) count;
+		incAmp0 = (endAmp0 - cur0) * scl;
+		incAmp1 = (endAmp1 - cur1) * scl;
+		incAmp2 = (endAmp2 - cur2) * scl;
+		inAmp0 = cur0;
+		dlyAmp1 = cur1;
+		dlyAmp2 = cur2;
+		steps = count;
+	}
+
+	/// Process the current sample.
+	/// @param val current sample value
+	AmpValue Sample(AmpValue val)
+	{
+		if (steps > 0)
+		{
+			if (--steps == 0)
+			{
+				inAmp0 = endAmp0;
+				dlyAmp1 = endAmp1;
+				dlyAmp2 = endAmp2;
+			}
+			else
+			{
+				inAmp0 += incAmp0;
+				dlyAmp1 += incAmp1;
+				dlyAmp2 += incAmp2;
+			}
+		}
+		return FilterIIR2p::Sample(val);
+	}
+};
+
 ///////////////////////////////////////////////////////////
 /// FIR impulse response filter. This filter implements
 /// convolution of the input with an impulse response:
@@ -723,6 +854,29 @@ public:
 		return (lowPass * lpOut) + (hiPass * hpOut) + (bandPass * bpOut) /*+ notch * brOut) */;
 	}
 
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// @param in input values
+	/// @param out output values
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		AmpValue lp = lowPass;
+		AmpValue hp = hiPass;
+		AmpValue bp = bandPass;
+		for (int i = 0; i < n; i++)
+		{
+			lp += a * bp;
+			hp = in[i] - (lp + (b * bp));
+			bp += a * hp;
+			out[i] = (lp * lpOut) + (hp * hpOut) + (bp * bpOut);
+		}
+		lowPass = lp;
+		hiPass = hp;
+		bandPass = bp;
+	}
+
 	/// Return the low pass output alone.
 	inline AmpValue LowPass()  { return lowPass; }
 	/// Return the high pass output alone.
@@ -765,6 +919,26 @@ public:
 		bandPass += a * (in - (lowPass + (b * bandPass)));
 		return lowPass;
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// @param in input values
+	/// @param out output values
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		AmpValue lp = lowPass;
+		AmpValue bp = bandPass;
+		for (int i = 0; i < n; i++)
+		{
+			lp += a * bp;
+			bp += a * (in[i] - (lp + (b * bp)));
+			out[i] = lp;
+		}
+		lowPass = lp;
+		bandPass = bp;
+	}
 };
 
 //@}
@@ -119,6 +119,18 @@ public:
 		dlv.SetDelay(dlyCenter + (dlyRange * wv.Gen()));
 		return (inval * dlyLvl) + dlv.Sample(inval);
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// @param in input values
+	/// @param out output values
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		for (int i = 0; i < n; i++)
+			out[i] = Flanger::Sample(in[i]);
+	}
 };
 //@}
 #endif
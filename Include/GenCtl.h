@@ -0,0 +1,156 @@
+/////////////////////////////////////////////////////////////////////
+// BasicSynth control rate modulation
+//
+/// @file GenCtl.h Control rate ramp for modulation sources
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL 
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////////
+/// @addtogroup grpGeneral
+//@{
+#ifndef _GENCTL_H_
+#define _GENCTL_H_
+
+/// Control rate ramp.
+/// Modulation sources such as LFOs, pitch bend and modulation
+/// envelopes change slowly compared to the audio signal. GenCtl lets
+/// an instrument evaluate a source once every \e rate samples and
+/// produce a value for each sample by moving in a straight line
+/// from one control value to the next. Start() reads the first
+/// value from the source so that each ramp runs from the value
+/// at the start of the period to the value at the end, and the
+/// output does not lag the source.
+///
+/// The source must be set up to advance \e rate samples on each
+/// call, usually by scaling its frequency up, or its times down,
+/// by the rate. The LFO, PitchBend and PitchBendWT classes do this
+/// with their SetCtlRate() method.
+///
+/// With a rate of 1, the source is evaluated on every sample and
+/// the output is exactly the source value.
+/// @code
+/// lfo.SetCtlRate(synthParams.ctlRate);
+/// lfo.Reset();
+/// ctl.Init(synthParams.ctlRate);
+/// ctl.Start(lfo);
+/// ...
+/// val = ctl.Gen(lfo);
+/// @endcode
+/// @sa SynthConfig::ctlRate
+class GenCtl : public GenUnit
+{
+protected:
+	AmpValue value;  // current output
+	AmpValue incr;   // change per sample
+	AmpValue scale;  // 1/rate
+	bsInt32 rate;    // samples per control period
+	bsInt32 count;   // samples left in the current period
+
+public:
+	GenCtl()
+	{
+		value = 0;
+		incr = 0;
+		scale = 1;
+		rate = 1;
+		count = 0;
+	}
+
+	/// Initialize the ramp.
+	/// The first call to Gen() or Next() starts a new period.
+	/// @param r samples per control period
+	/// @param v initial output value
+	void Init(bsInt32 r, AmpValue v = 0)
+	{
+		rate = r < 1 ? 1 : r;
+		scale = 1.0 / (AmpValue) rate;
+		value = v;
+		incr = 0;
+		count = 0;
+	}
+
+	/// Initialize the ramp.
+	/// @param n number of values (1 or 2)
+	/// @param v v[0] = rate, v[1] = initial value
+	void Init(int n, float *v)
+	{
+		if (n > 0)
+			Init((bsInt32) v[0], n > 1 ? AmpValue(v[1]) : 0);
+	}
+
+	/// Start the ramp at the first value of the source.
+	/// Call this after the source is reset. With a rate of 1
+	/// nothing is read, and the first call to Gen() reads the
+	/// same value that calling the source directly returns.
+	/// @param src modulation source with a Gen() method
+	template<class G> void Start(G& src)
+	{
+		incr = 0;
+		count = 0;
+		if (rate > 1)
+			value = src.Gen();
+	}
+
+	/// Restart the ramp at the current output value.
+	/// @param initPhs not used
+	void Reset(float initPhs = 0)
+	{
+		incr = 0;
+		count = 0;
+	}
+
+	/// Get the number of samples per control period.
+	bsInt32 GetRate()
+	{
+		return rate;
+	}
+
+	/// Check if a new control value is needed.
+	/// When this returns true, the caller must call Target()
+	/// before the next call to Gen().
+	int Next()
+	{
+		return --count <= 0;
+	}
+
+	/// Set the value for the end of the next period.
+	/// @param v new control value
+	void Target(AmpValue v)
+	{
+		count = rate;
+		if (rate > 1)
+			incr = (v - value) * scale;
+		else
+			value = v;
+	}
+
+	/// Get the output for the current sample.
+	/// The first sample of a period is the value at the
+	/// start of the ramp.
+	AmpValue Gen()
+	{
+		AmpValue v = value;
+		value += incr;
+		return v;
+	}
+
+	/// Get the output for the current sample,
+	/// evaluating the source at the start of each period.
+	/// @param src modulation source with a Gen() method
+	template<class G> AmpValue Gen(G& src)
+	{
+		if (--count <= 0)
+			Target(src.Gen());
+		return Gen();
+	}
+
+	/// @copydoc GenUnit::Sample
+	AmpValue Sample(AmpValue in)
+	{
+		return Gen() * in;
+	}
+};
+//@}
+#endif
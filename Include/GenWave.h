@@ -133,6 +133,18 @@ public:
 	/// output should override this method.
 	/// @return sample value for the current phase
 	virtual AmpValue2 Gen2() { return (AmpValue2) Gen(); }
+
+	/// Generate a block of samples.
+	/// This produces the same values as calling Gen() n times.
+	/// Generators that can produce samples more efficiently
+	/// in a batch should override this method.
+	/// @param dst output samples
+	/// @param n number of samples
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		while (--n >= 0)
+			*dst++ = Gen();
+	}
 };
 
 /// Like GenWave, but high-precision.
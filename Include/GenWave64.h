@@ -88,6 +88,18 @@ public:
 		i64Index = (i64Index + i64IndexIncr) & i64IndexMask;
 		return v;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 //@}
 #endif
@@ -244,6 +244,18 @@ public:
 		osc[3].index += osc[3].indexIncr;
 		return 1.0;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 
 
@@ -363,6 +375,18 @@ public:
 		index2 += indexIncr;
 		return out;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 
 
@@ -515,6 +539,18 @@ public:
 		index2 += indexIncr2;
 		return out;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -648,6 +684,18 @@ public:
 		index2 += indexIncr2;
 		return out;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -793,6 +841,18 @@ public:
 			return ampScale * ((a / b) - 1.0);
 		return 1.0;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 
 //@}
@@ -21,6 +21,7 @@
 
 #include "WaveTable.h"
 #include "GenWave.h"
+#include "SynthSIMD.h"
 
 /// Generic wavetable based generator (oscillator).
 /// The wave tables are stored in the global \ref wtSet object
@@ -147,6 +148,72 @@ public:
 		index += indexIncr;
 		return waveTable[n];
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	/// The phase is accumulated one sample at a time,
+	/// exactly as in Gen(), then the table lookups are
+	/// done with the \ref synthSIMD kernels.
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		bsInt32 ndx[SIMD_BLKSIZE];
+		while (n > 0)
+		{
+			int cnt = n > SIMD_BLKSIZE ? SIMD_BLKSIZE : n;
+			for (int i = 0; i < cnt; i++)
+			{
+				index = PhaseWrapWT(index);
+				ndx[i] = (bsInt32) (index + 0.5);
+				index += indexIncr;
+			}
+			synthSIMD.Lookup(dst, waveTable, ndx, cnt);
+			dst += cnt;
+			n -= cnt;
+		}
+	}
+
+	/// Generate a block of samples with phase modulation.
+	/// This produces the same values as calling PhaseModWT()
+	/// followed by Gen() for each sample.
+	/// @param dst output samples
+	/// @param phs wavetable index delta for each sample
+	/// @param n number of samples
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		bsInt32 ndx[SIMD_BLKSIZE];
+		while (n > 0)
+		{
+			int cnt = n > SIMD_BLKSIZE ? SIMD_BLKSIZE : n;
+			for (int i = 0; i < cnt; i++)
+			{
+				index = PhaseWrapWT(index + *phs++);
+				ndx[i] = (bsInt32) (index + 0.5);
+				index += indexIncr;
+			}
+			synthSIMD.Lookup(dst, waveTable, ndx, cnt);
+			dst += cnt;
+			n -= cnt;
+		}
+	}
+
+protected:
+	/// Block generation for derived classes that override Gen().
+	/// Derived classes that implement Gen() with something other than
+	/// a single table lookup must override GenBlock() and GenBlockPM()
+	/// and call these.
+	void GenBlockAny(AmpValue *dst, int n)
+	{
+		GenWave::GenBlock(dst, n);
+	}
+
+	/// @copydoc GenBlockAny()
+	void GenBlockAnyPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		while (--n >= 0)
+		{
+			PhaseModWT(*phs++);
+			*dst++ = Gen();
+		}
+	}
 };
 
 
@@ -175,6 +242,43 @@ public:
 		AmpValue2 v2 = (AmpValue2) waveTable[intIndex+1];
 		return (v1 + ((v2 - v1) * fract));
 	}
+
+	/// @copydoc GenWaveWT::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockI(dst, 0, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockI(dst, phs, n);
+	}
+
+protected:
+	/// Common code for GenBlock() and GenBlockPM().
+	void GenBlockI(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		bsInt32 ndx[SIMD_BLKSIZE];
+		PhsAccum fr[SIMD_BLKSIZE];
+		while (n > 0)
+		{
+			int cnt = n > SIMD_BLKSIZE ? SIMD_BLKSIZE : n;
+			for (int i = 0; i < cnt; i++)
+			{
+				if (phs)
+					index += *phs++;
+				index = PhaseWrapWT(index);
+				int intIndex = (int) index;
+				fr[i] = index - (PhsAccum) intIndex;
+				ndx[i] = intIndex;
+				index += indexIncr;
+			}
+			synthSIMD.LookupI(dst, waveTable, ndx, fr, cnt);
+			dst += cnt;
+			n -= cnt;
+		}
+	}
 };
 
 /// Fast wavetable generator. 
@@ -234,6 +338,31 @@ public:
 		i32Index = (i32Index + i32IndexIncr) & i32IndexMask;
 		return v; 
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		i32Index = synthSIMD.Lookup32(dst, waveTable, i32Index, i32IndexIncr, i32IndexMask, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		bsInt32 ndx[SIMD_BLKSIZE];
+		while (n > 0)
+		{
+			int cnt = n > SIMD_BLKSIZE ? SIMD_BLKSIZE : n;
+			for (int i = 0; i < cnt; i++)
+			{
+				i32Index += (bsInt32) (PhaseWrapWT(*phs++) * 65536.0) & i32IndexMask;
+				ndx[i] = (i32Index + 0x8000) >> 16;
+				i32Index = (i32Index + i32IndexIncr) & i32IndexMask;
+			}
+			synthSIMD.Lookup(dst, waveTable, ndx, cnt);
+			dst += cnt;
+			n -= cnt;
+		}
+	}
 };
 
 /// Specialized wavetable oscillator for sample playback.
@@ -261,6 +390,9 @@ class GenWaveWTLoop : public GenUnit
 {
 protected:
 	AmpValue *wavetable;
+	const bsInt16 *wavetable16;
+	const bsUint8 *wavetableLSB;
+	bsInt32 tableLen16;
 	PhsAccum phase;
 	PhsAccum phsIncr;
 	PhsAccum period;
@@ -285,6 +417,9 @@ public:
 		tableEnd = 0.0;
 		phase = 0.0;
 		loopMode = 0;
+		wavetable16 = 0;
+		wavetableLSB = 0;
+		tableLen16 = 0;
 	}
 
 	void SetFrequency(FrqValue f)
@@ -295,6 +430,23 @@ public:
 	void SetWavetable(AmpValue *wt)
 	{
 		wavetable = wt;
+		wavetable16 = 0;
+	}
+
+	/// Set a 16-bit integer wavetable.
+	/// The values are converted to float as they are read.
+	/// This allows playing sample data in place, e.g., directly
+	/// from a memory mapped file. The table does not need guard
+	/// points; values past the end are taken as zero.
+	/// @param wt 16-bit samples
+	/// @param lsb optional low byte for 24-bit samples (SF2 sm24)
+	/// @param len number of samples in the table
+	void SetWavetable16(const bsInt16 *wt, const bsUint8 *lsb, bsInt32 len)
+	{
+		wavetable = 0;
+		wavetable16 = wt;
+		wavetableLSB = lsb;
+		tableLen16 = len;
 	}
 
 	/// Initialize from an array of values.
@@ -334,6 +486,7 @@ public:
 		loopLen = loopEnd - loopStart;
 		loopMode = lm;
 		wavetable = wt;
+		wavetable16 = 0;
 		phase = ts;
 		Reset(0);
 	}
@@ -395,11 +548,34 @@ public:
 		ii = (int) phase;
 		fr = phase - (PhsAccum) ii;
 		phase += phsIncr;
-		AmpValue v1 = wavetable[ii];
-		AmpValue v2 = wavetable[ii+1];
+		AmpValue v1;
+		AmpValue v2;
+		if (wavetable16)
+		{
+			v1 = Value16(ii);
+			v2 = Value16(ii+1);
+		}
+		else
+		{
+			v1 = wavetable[ii];
+			v2 = wavetable[ii+1];
+		}
 		return v1 + ((v2 - v1) * fr);
 	}
 
+	/// Convert one value from the integer wavetable.
+	/// This produces the same value as converting the whole table to float.
+	inline AmpValue Value16(int n)
+	{
+		if (n >= tableLen16)
+			return 0;
+		// 24-bit values are exact in a float, so this is the same as
+		// adding the converted LSB to the converted 16-bit value.
+		if (wavetableLSB)
+			return (AmpValue) (((bsInt32) wavetable16[n] * 256) + wavetableLSB[n]) / 8388608.0;
+		return (AmpValue) wavetable16[n] / 32768.0;
+	}
+
 	/// Determine if the wavetable end has been reached.
 	/// For wavetables with values past the loop end, you must call
 	/// Release() to transition past the loop end.
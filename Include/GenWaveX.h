@@ -235,6 +235,18 @@ public:
 		}
 		return val / scale;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 
 
@@ -363,6 +375,18 @@ public:
 
 		return valCar;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 
 /// Amplitude modulation (AM) Generator (2-quadrant multiply)
@@ -444,6 +468,18 @@ public:
 		modIndex += modIncr;
 		return out;
 	}
+
+	/// @copydoc GenWave::GenBlock()
+	virtual void GenBlock(AmpValue *dst, int n)
+	{
+		GenBlockAny(dst, n);
+	}
+
+	/// @copydoc GenWaveWT::GenBlockPM()
+	virtual void GenBlockPM(AmpValue *dst, const PhsAccum *phs, int n)
+	{
+		GenBlockAnyPM(dst, phs, n);
+	}
 };
 
 /// Ring modulation (RM) generator (i.e. 4-quadrant multiply)
@@ -16,6 +16,11 @@
 class InstrManager; // forward reference for type defs below
 class Sequencer;
 
+/// Maximum number of frames passed to Instrument::TickBlock().
+/// The sequencer splits larger blocks so that instruments
+/// can use fixed size buffers on the stack.
+#define MAX_TICKBLOCK 256
+
 ///////////////////////////////////////////////////////////
 /// Base class for instruments. This class defines
 /// the common methods needed by the instrument manager and
@@ -63,12 +68,63 @@ public:
 	/// set by the instrument factory function.
 	virtual void Tick() { }
 
+	/// Produce a block of samples.
+	/// This method is called by the sequencer in block mode
+	/// in place of Tick(). The instrument generates the next
+	/// frames samples and passes them to the instrument manager
+	/// through OutputBlock(), Output2Block() or FxSendBlock().
+	/// The frames value is never more than MAX_TICKBLOCK.
+	/// When the sequencer renders with multiple threads, TickBlock()
+	/// is called on a worker thread. It must only change the state
+	/// of this instrument and must only output through the block
+	/// output methods.
+	/// Block rendering is optional. The default returns 0 to
+	/// indicate the instrument only supports Tick(), and the
+	/// sequencer then calls Tick() once for each sample.
+	/// @param frames number of samples to generate
+	/// @return non-zero if the block was generated
+	virtual int TickBlock(int frames) { return 0; }
+
+	/// Get the key for batch rendering.
+	/// Voices that return the same non-zero key can be rendered
+	/// together by TickBatch(). The key is usually the address
+	/// of something shared by instruments with the same setup.
+	/// The default returns 0 to indicate batching is not supported.
+	/// @return batch key, or 0
+	virtual Opaque BatchKey() { return 0; }
+
+	/// Generate a block of samples for several voices at once.
+	/// In block mode, the sequencer calls this on one voice with a list
+	/// of voices (including this one) that have the same BatchKey().
+	/// The instrument generates frames samples for each voice and keeps
+	/// them in the voice. The sequencer then calls TickBlock(frames) on
+	/// each voice in the usual order, and the voice outputs the saved
+	/// samples rather than generating them again. Voices that were not
+	/// batched generate the block in TickBlock() as usual.
+	/// @param voices voices to generate
+	/// @param count number of voices
+	/// @param frames number of samples to generate
+	/// @return non-zero if the voices were generated
+	virtual int TickBatch(Instrument **voices, int count, int frames) { return 0; }
+
 	/// Test for output complete.
 	/// IsFinished is called for each sample after Stop has been sent
 	/// to determine if the instrument can be removed from
 	/// the active list. 
 	virtual int  IsFinished() { return 1; }
 
+	/// Get the current output level.
+	/// This is an estimate of the amplitude of the note, in the range
+	/// [0,1], used by a voice allocation policy to choose a note to remove
+	/// when too many are active, and by the sequencer to remove notes
+	/// in release that are no longer audible. The default returns 1.
+	virtual AmpValue GetLevel() { return 1.0; }
+
+	/// Get the exclusive note group.
+	/// The value is the index passed to InstrManager::ExclNoteOn(),
+	/// or -1 if the note is not exclusive.
+	virtual int GetExclGroup() { return -1; }
+
 	/// Destroy the instance.
 	/// By default, this deletes the instance. However, an
 	/// instrument may cache instrument instances, or
@@ -77,6 +133,24 @@ public:
 	/// this method would not actually delete the instance.
 	virtual void Destroy() { delete this; }
 
+	/// Prepare a finished instance for reuse.
+	/// When a note started by the sequencer ends, the instance
+	/// is offered back to its instrument configuration. If Recycle
+	/// returns non-zero, the instance is kept on a free list
+	/// and handed out again by Reinit instead of manufacturing
+	/// a new instance. An instrument that returns non-zero must
+	/// also implement Reinit.
+	/// @return non-zero if the instance can be reused
+	virtual int Recycle() { return 0; }
+
+	/// Reinitialize a recycled instance.
+	/// Reinit must restore the instance to the state of a newly
+	/// manufactured instance built from the template. Start is
+	/// called afterwards as usual.
+	/// @param tmplt instrument template
+	/// @return 0 on success, non-zero to discard the instance
+	virtual int Reinit(Opaque tmplt) { return -1; }
+
 	/// Load instrument settings.
 	/// Called to load the instrument configuration from an XML file
 	virtual int Load(XmlSynthElem *parent) { return -1; }
@@ -251,6 +325,12 @@ public:
 /// type. The instance entry contains references to the
 /// type and a template used to construct instrument
 /// instances for playback.
+///
+/// Instances that finish playing are kept in a pool and
+/// reused by Allocate when the instrument implements
+/// Instrument::Recycle and Instrument::Reinit. All of the
+/// note instruments do. MixerControl is not recycled; it
+/// plays only a few events per score.
 ///////////////////////////////////////////////////////////
 class InstrConfig : public SynthList<InstrConfig>
 {
@@ -261,12 +341,18 @@ public:
 	bsString desc;  ///< Instrument description
 	Opaque instrTmplt; ///< Template to create new instance.
 	InstrMapEntry *instrType; ///< Instrument type entry
+	Instrument **pool; ///< Recycled instances
+	bsInt32 poolCount; ///< Number of instances in the pool
+	bsInt32 poolSize;  ///< Allocated size of the pool
 
 	InstrConfig()
 	{
 		inum = -1;
 		instrType = 0;
 		instrTmplt = 0;
+		pool = 0;
+		poolCount = 0;
+		poolSize = 0;
 	}
 
 	InstrConfig(bsInt16 in, InstrMapEntry *type, Opaque tmplt)
@@ -274,10 +360,14 @@ public:
 		inum = in;
 		instrType = type;
 		instrTmplt = tmplt;
+		pool = 0;
+		poolCount = 0;
+		poolSize = 0;
 	}
 
 	~InstrConfig()
 	{
+		ClearPool();
 		if (instrType && instrType->dumpTmplt && instrTmplt)
 			instrType->dumpTmplt(instrTmplt);
 	}
@@ -292,6 +382,55 @@ public:
 		return new Instrument;
 	}
 
+	/// Allocate an instance, reusing a recycled one when possible.
+	/// @param im instrument manager
+	/// @return pointer to the instrument
+	Instrument *Allocate(InstrManager *im)
+	{
+		while (poolCount > 0)
+		{
+			Instrument *ip = pool[--poolCount];
+			if (ip->Reinit(instrTmplt) == 0)
+				return ip;
+			ip->Destroy();
+		}
+		return MakeInstance(im);
+	}
+
+	/// Return an instance that is no longer playing.
+	/// The instance is kept for reuse if it supports recycling,
+	/// otherwise it is destroyed.
+	/// @param ip pointer to the instrument
+	void Recycle(Instrument *ip)
+	{
+		if (!ip->Recycle())
+		{
+			ip->Destroy();
+			return;
+		}
+		if (poolCount >= poolSize)
+		{
+			bsInt32 newSize = poolSize ? poolSize * 2 : 16;
+			Instrument **newPool = new Instrument*[newSize];
+			for (bsInt32 n = 0; n < poolCount; n++)
+				newPool[n] = pool[n];
+			delete[] pool;
+			pool = newPool;
+			poolSize = newSize;
+		}
+		pool[poolCount++] = ip;
+	}
+
+	/// Destroy all recycled instances.
+	void ClearPool()
+	{
+		while (poolCount > 0)
+			pool[--poolCount]->Destroy();
+		delete[] pool;
+		pool = 0;
+		poolSize = 0;
+	}
+
 	/// Create an event object for this instrument.
 	/// @return pointer to the event.
 	SeqEvent *MakeEvent()
@@ -342,6 +481,101 @@ public:
 	}
 };
 
+///////////////////////////////////////////////////////////
+/// Captured block output from one voice.
+/// When the sequencer renders voices on multiple threads,
+/// the block output methods of InstrManager record the
+/// output here rather than sending it to the mixer.
+/// The sequencer replays each capture into the mixer
+/// in the order of the active voice list so that the
+/// mix is identical for any number of threads.
+///////////////////////////////////////////////////////////
+class BlockCapture
+{
+private:
+	struct CaptureRec
+	{
+		bsInt16 type;   ///< 0 = Output, 1 = Output2, 2 = FxSend
+		bsInt16 ch;     ///< mixer channel or effects unit
+		bsInt32 pos;    ///< block position
+		bsInt32 frames; ///< number of frames
+		bsInt32 ofs;    ///< offset into data
+	};
+	CaptureRec *recs;
+	bsInt32 numRecs;
+	bsInt32 maxRecs;
+	AmpValue *data;
+	bsInt32 dataLen;
+	bsInt32 dataMax;
+	bsInt32 blkPos;
+
+	AmpValue *Add(int type, int ch, int frames, int count);
+
+public:
+	BlockCapture()
+	{
+		recs = 0;
+		numRecs = 0;
+		maxRecs = 0;
+		data = 0;
+		dataLen = 0;
+		dataMax = 0;
+		blkPos = 0;
+	}
+
+	~BlockCapture()
+	{
+		delete[] recs;
+		delete[] data;
+	}
+
+	/// Discard captured output.
+	void Clear()
+	{
+		numRecs = 0;
+		dataLen = 0;
+		blkPos = 0;
+	}
+
+	/// @copydoc InstrManager::SetBlockPos
+	void SetBlockPos(int pos)
+	{
+		blkPos = pos;
+	}
+
+	/// @copydoc InstrManager::OutputBlock
+	void OutputBlock(int ch, const AmpValue *val, int frames)
+	{
+		memcpy(Add(0, ch, frames, 1), val, frames*sizeof(AmpValue));
+	}
+
+	/// @copydoc InstrManager::Output2Block
+	void Output2Block(int ch, const AmpValue *lft, const AmpValue *rgt, int frames)
+	{
+		AmpValue *dp = Add(1, ch, frames, 2);
+		memcpy(dp, lft, frames*sizeof(AmpValue));
+		memcpy(dp+frames, rgt, frames*sizeof(AmpValue));
+	}
+
+	/// @copydoc InstrManager::FxSendBlock
+	void FxSendBlock(int unit, const AmpValue *val, int frames)
+	{
+		memcpy(Add(2, unit, frames, 1), val, frames*sizeof(AmpValue));
+	}
+
+	/// Send the captured output to the mixer.
+	/// @param mix mixer
+	void Replay(Mixer *mix);
+
+	/// Get the capture object for the calling thread.
+	/// @return capture object, or NULL if output goes to the mixer
+	static BlockCapture *Current();
+
+	/// Set the capture object for the calling thread.
+	/// @param cap capture object, or NULL to send output to the mixer
+	static void SetCurrent(BlockCapture *cap);
+};
+
 ///////////////////////////////////////////////////////////
 /// Instrument manager class.
 //
@@ -614,7 +848,7 @@ public:
 	virtual Instrument *Allocate(InstrConfig *in)
 	{
 		if (in)
-			return in->MakeInstance(this);
+			return in->Allocate(this);
 		return new Instrument;
 	}
 
@@ -623,7 +857,7 @@ public:
 	virtual Instrument *Allocate(SeqEvent *evt)
 	{
 		if (evt->im)
-			return evt->im->MakeInstance(this);
+			return evt->im->Allocate(this);
 		return Allocate(FindInstr(evt->inum));
 	}
 
@@ -634,6 +868,19 @@ public:
 		ip->Destroy();
 	}
 
+	/// Deallocate an instrument instance allocated for a configuration.
+	/// The instance is returned to the configuration for reuse
+	/// when the instrument supports recycling.
+	/// @param ip pointer to the instrument object
+	/// @param in instrument configuration used to allocate the instance
+	virtual void Deallocate(Instrument *ip, InstrConfig *in)
+	{
+		if (in)
+			in->Recycle(ip);
+		else
+			Deallocate(ip);
+	}
+
 	/// Allocate a new event for an instrument.
 	/// @param inum instrument number
 	virtual SeqEvent *ManufEvent(bsInt16 inum)
@@ -689,6 +936,62 @@ public:
 		wvf->Output2(outLft, outRgt);
 	}
 
+	/// TickBlock is called by the sequencer in block mode
+	/// in place of calling Tick() for each sample when no active
+	/// instrument requires per-sample processing. The mixer
+	/// output for the block is produced with one call
+	/// to Mixer::OutBlock(). A derived class that overrides
+	/// Tick() must also override this method.
+	/// @param frames number of samples to output
+	virtual void TickBlock(int frames)
+	{
+		if (mix == 0)
+		{
+			while (--frames >= 0)
+				Tick();
+			return;
+		}
+		AmpValue outLft[MAX_TICKBLOCK];
+		AmpValue outRgt[MAX_TICKBLOCK];
+		while (frames > 0)
+		{
+			int cnt = frames > MAX_TICKBLOCK ? MAX_TICKBLOCK : frames;
+			mix->OutBlock(outLft, outRgt, cnt);
+			for (int n = 0; n < cnt; n++)
+				wvf->Output2(outLft[n], outRgt[n]);
+			frames -= cnt;
+		}
+	}
+
+	/// Set the block size for block output.
+	/// The sequencer calls this before playback when block mode is
+	/// enabled, and again with a value of 0 when playback ends.
+	/// Derived classes that do not use the mixer for output must
+	/// override this and the other block output methods,
+	/// or return -1 to indicate block output is not supported.
+	/// @param frames number of samples in a block, 0 for none
+	/// @return 0 on success, -1 if block output is not available
+	virtual int SetBlockSize(int frames)
+	{
+		if (mix == 0)
+			return -1;
+		mix->SetBlockSize(frames);
+		return 0;
+	}
+
+	/// Set the block position for the next block output.
+	/// Block output from instruments is added to the current
+	/// block starting at this position.
+	/// @param pos offset in samples from the start of the block
+	virtual void SetBlockPos(int pos)
+	{
+		BlockCapture *cap = BlockCapture::Current();
+		if (cap)
+			cap->SetBlockPos(pos);
+		else
+			mix->SetBlockPos(pos);
+	}
+
 	/// Direct output to effects units. This bypasses the
 	/// normal input channel volume, pan, and fx send values.
 	/// @param unit effects unit number
@@ -720,6 +1023,48 @@ public:
 		mix->ChannelIn2(ch, lft, rgt);
 	}
 
+	/// Direct output of a block of samples to effects units.
+	/// @param unit effects unit number
+	/// @param val amplitude values to send
+	/// @param frames number of values
+	virtual void FxSendBlock(int unit, const AmpValue *val, int frames)
+	{
+		BlockCapture *cap = BlockCapture::Current();
+		if (cap)
+			cap->FxSendBlock(unit, val, frames);
+		else
+			mix->FxInBlock(unit, val, frames);
+	}
+
+	/// Output a block of samples on the indicated channel.
+	/// This is the block mode equivalent of Output().
+	/// @param ch mixer input channel
+	/// @param val amplitude values
+	/// @param frames number of values
+	virtual void OutputBlock(int ch, const AmpValue *val, int frames)
+	{
+		BlockCapture *cap = BlockCapture::Current();
+		if (cap)
+			cap->OutputBlock(ch, val, frames);
+		else
+			mix->ChannelInBlock(ch, val, frames);
+	}
+
+	/// Output a block of left/right samples on the indicated channel.
+	/// This is the block mode equivalent of Output2().
+	/// @param ch mixer input channel
+	/// @param lft left output amplitude values
+	/// @param rgt right output amplitude values
+	/// @param frames number of values
+	virtual void Output2Block(int ch, const AmpValue *lft, const AmpValue *rgt, int frames)
+	{
+		BlockCapture *cap = BlockCapture::Current();
+		if (cap)
+			cap->Output2Block(ch, lft, rgt, frames);
+		else
+			mix->ChannelIn2Block(ch, lft, rgt, frames);
+	}
+
 	/// Controller change (MIDI).
 	/// Sets the current controller value.
 	/// @param chnl channel number
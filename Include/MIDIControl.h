@@ -70,14 +70,27 @@ public:
 /// The instrument manager inherits from this class and implements
 /// the VolumeChange(), PitchbendChange() and ControlChange() functions
 /// to send changes to the mixer and active voices.
+///
+/// When a soundbank loader is set, program change and bank select
+/// messages queue the selected instrument for loading.
+class SoundBankLoader;
+
 class MIDIControl
 {
 public:
 	MIDIChannelStatus channel[16];  ///< Channel status information
 	bsInt16 switchLevel;
+	SoundBankLoader *prefetch;      ///< loader for program changes
 
 	MIDIControl();
 
+	/// Set the loader that prefetches instruments on program change.
+	/// @param ldr soundbank loader or NULL for none
+	void SetPrefetch(SoundBankLoader *ldr)
+	{
+		prefetch = ldr;
+	}
+
 	/// Process an event from the sequencer.
 	virtual void ProcessEvent(SeqEvent *evt, bsInt16 flags);
 	/// Process a MIDI message.
@@ -153,6 +153,8 @@ public:
 	AmpValue *fxlvl; // one for each input channel
 	AmpValue value;  // total input
 	AmpValue fxmix;  // output level
+	AmpValue *blkVal; // block input
+	int blkLen;
 	Panner   pan;
 	int init;
 
@@ -163,11 +165,14 @@ public:
 		fxlvl = 0;
 		value = 0;
 		fxmix = 0;
+		blkVal = 0;
+		blkLen = 0;
 	}
 
 	~FxChannel()
 	{
 		delete[] fxlvl;
+		delete[] blkVal;
 	}
 
 	/// Effects in from input channel.
@@ -186,6 +191,79 @@ public:
 		value += val;
 	}
 
+	/// Effects in direct, block of values.
+	/// @param pos position in the input block
+	/// @param val input amplitude values
+	/// @param n number of values
+	void FxInBlock(int pos, const AmpValue *val, int n)
+	{
+		AmpValue *bp = &blkVal[pos];
+		while (--n >= 0)
+			*bp++ += *val++;
+	}
+
+	/// Move one value from the block input to the current input.
+	/// @param pos position in the input block
+	void BlockIn(int pos)
+	{
+		value += blkVal[pos];
+		blkVal[pos] = 0;
+	}
+
+	/// Move the current input into the block input.
+	/// This is the reverse of BlockIn and is used before
+	/// processing a block so that per-sample input is not lost.
+	/// @param pos position in the input block
+	void BlockFold(int pos)
+	{
+		blkVal[pos] += value;
+		value = 0;
+	}
+
+	/// Effects in from input channel, block of values.
+	/// @param ch input channel sending the values
+	/// @param pos position in the input block
+	/// @param val input amplitude values
+	/// @param n number of values
+	void FxSendBlock(int ch, int pos, const AmpValue *val, int n)
+	{
+		synthSIMD.MulAdd(&blkVal[pos], val, fxlvl[ch], n);
+	}
+
+	/// Effects output for a block. Applies internal panning.
+	/// This is the block equivalent of FxOut.
+	/// @param pos position in the input block
+	/// @param lft left output values
+	/// @param rgt right output values
+	/// @param tmp work buffer of n values
+	/// @param n number of values
+	void FxOutBlock(int pos, AmpValue *lft, AmpValue *rgt, AmpValue *tmp, int n)
+	{
+		AmpValue *bp = &blkVal[pos];
+		if (fx)
+		{
+			fx->Samples(bp, tmp, n);
+			synthSIMD.Mul(tmp, tmp, fxmix, n);
+			synthSIMD.MulAdd(lft, tmp, pan.panlft, n);
+			synthSIMD.MulAdd(rgt, tmp, pan.panrgt, n);
+		}
+		memset(bp, 0, n*sizeof(AmpValue));
+	}
+
+	/// Allocate the block input buffer.
+	/// @param n block length, 0 for none
+	void SetBlockSize(int n)
+	{
+		delete[] blkVal;
+		blkVal = 0;
+		blkLen = n;
+		if (n > 0)
+		{
+			blkVal = new AmpValue[n];
+			memset(blkVal, 0, n*sizeof(AmpValue));
+		}
+	}
+
 	/// Effects output. Applies internall panning
 	/// @param lft left output value
 	/// @param rgt right output value
@@ -267,6 +345,8 @@ public:
 	void Clear()
 	{
 		value = 0;
+		if (blkLen > 0)
+			memset(blkVal, 0, blkLen*sizeof(AmpValue));
 		if (fx)
 			fx->Reset();
 	}
@@ -305,9 +385,12 @@ private:
 	AmpValue right;
 	AmpValue volume;
 	AmpValue panset;
+	AmpValue *blkLft;
+	AmpValue *blkRgt;
 	Panner pan;
 	int   method;
 	int   on;
+	int   blkLen;
 
 public:
 	MixChannel()
@@ -318,6 +401,15 @@ public:
 		right = 0;
 		panset = 0;
 		method = 0;
+		blkLft = 0;
+		blkRgt = 0;
+		blkLen = 0;
+	}
+
+	~MixChannel()
+	{
+		delete[] blkLft;
+		delete[] blkRgt;
 	}
 
 	/// Set channel on/off
@@ -382,6 +474,102 @@ public:
 		right += rgt;
 	}
 
+	/// Add a block of values to the block input buffer.
+	/// Panning is applied here.
+	/// @param pos position in the input block
+	/// @param val sample values
+	/// @param n number of values
+	void InBlock(int pos, const AmpValue *val, int n)
+	{
+		AmpValue *lp = &blkLft[pos];
+		AmpValue *rp = &blkRgt[pos];
+		while (--n >= 0)
+		{
+			AmpValue v = *val++;
+			*lp++ += v * pan.panlft;
+			*rp++ += v * pan.panrgt;
+		}
+	}
+
+	/// Add a block of values to the block input buffer directly.
+	/// This bypasses internal panning.
+	/// @param pos position in the input block
+	/// @param lft left amplitude values
+	/// @param rgt right amplitude values
+	/// @param n number of values
+	void In2Block(int pos, const AmpValue *lft, const AmpValue *rgt, int n)
+	{
+		AmpValue *lp = &blkLft[pos];
+		AmpValue *rp = &blkRgt[pos];
+		while (--n >= 0)
+		{
+			*lp++ += *lft++;
+			*rp++ += *rgt++;
+		}
+	}
+
+	/// Move one value from the block input to the current input.
+	/// @param pos position in the input block
+	void BlockIn(int pos)
+	{
+		left += blkLft[pos];
+		right += blkRgt[pos];
+		blkLft[pos] = 0;
+		blkRgt[pos] = 0;
+	}
+
+	/// Move a block of values from the block input to the current input.
+	/// This is used when the channel is off and thus is not output.
+	/// @param pos position in the input block
+	/// @param n number of values
+	void BlockIn(int pos, int n)
+	{
+		while (--n >= 0)
+			BlockIn(pos++);
+	}
+
+	/// Get the output for a block of values.
+	/// This is the block equivalent of BlockIn, Level and Out.
+	/// @param pos position in the input block
+	/// @param lval left output values, added to
+	/// @param rval right output values, added to
+	/// @param lvl monophonic level for effects, or NULL
+	/// @param n number of values
+	void OutBlock(int pos, AmpValue *lval, AmpValue *rval, AmpValue *lvl, int n)
+	{
+		AmpValue *lp = &blkLft[pos];
+		AmpValue *rp = &blkRgt[pos];
+		// include any per-sample input
+		lp[0] += left;
+		rp[0] += right;
+		left = 0;
+		right = 0;
+		if (lvl)
+			synthSIMD.AddMul(lvl, lp, rp, volume, n);
+		synthSIMD.MulAdd(lval, lp, volume, n);
+		synthSIMD.MulAdd(rval, rp, volume, n);
+		memset(lp, 0, n*sizeof(AmpValue));
+		memset(rp, 0, n*sizeof(AmpValue));
+	}
+
+	/// Allocate the block input buffers.
+	/// @param n block length, 0 for none
+	void SetBlockSize(int n)
+	{
+		delete[] blkLft;
+		delete[] blkRgt;
+		blkLft = 0;
+		blkRgt = 0;
+		blkLen = n;
+		if (n > 0)
+		{
+			blkLft = new AmpValue[n];
+			blkRgt = new AmpValue[n];
+			memset(blkLft, 0, n*sizeof(AmpValue));
+			memset(blkRgt, 0, n*sizeof(AmpValue));
+		}
+	}
+
 	/// Get the current level as monophonic value
 	AmpValue Level()
 	{
@@ -405,6 +593,11 @@ public:
 	{
 		left = 0;
 		right = 0;
+		if (blkLen > 0)
+		{
+			memset(blkLft, 0, blkLen*sizeof(AmpValue));
+			memset(blkRgt, 0, blkLen*sizeof(AmpValue));
+		}
 	}
 };
 
@@ -425,12 +618,26 @@ public:
 /// get the final output samples. The Out method combines inputs
 /// and applies Fx units, before applying the final master output
 /// level. 
+///
+/// For block rendering, SetBlockSize() allocates a block buffer
+/// on each input and effects channel. The ChannelInBlock(),
+/// ChannelIn2Block() and FxInBlock() methods add a block of values
+/// starting at the position set with SetBlockPos(). Each call
+/// to Out() moves the next sample from the block buffers into
+/// the inputs, thus block and per-sample input can be mixed.
+/// When all input for a block is in the block buffers,
+/// OutBlock() produces the same output as calling Out() for
+/// each sample, but processes each channel over the whole block.
 ///////////////////////////////////////////////////////////////
 class Mixer
 {
 private:
 	int mixInputs;
 	int fxUnits;
+	int blkLen;
+	int blkIn;
+	int blkOut;
+	AmpValue *blkTmp;
 	MixChannel *inBuf;
 	FxChannel *fxBuf;
 	AmpValue lvol;
@@ -449,6 +656,10 @@ public:
 		rpeak = 0.0;
 		inBuf = 0;
 		fxBuf = 0;
+		blkLen = 0;
+		blkIn = 0;
+		blkOut = 0;
+		blkTmp = 0;
 	}
 
 	~Mixer()
@@ -457,6 +668,7 @@ public:
 			delete[] inBuf;
 		if (fxBuf)
 			delete[] fxBuf;
+		delete[] blkTmp;
 	}
 
 	/// Set the master volume values.
@@ -482,7 +694,14 @@ public:
 		}
 		mixInputs = nchnl;
 		if (nchnl > 0)
+		{
 			inBuf = new MixChannel[nchnl];
+			if (blkLen > 0)
+			{
+				for (int n = 0; n < nchnl; n++)
+					inBuf[n].SetBlockSize(blkLen);
+			}
+		}
 	}
 
 	/// Get the number of input channels.
@@ -539,6 +758,66 @@ public:
 		inBuf[ch].In2(lft, rgt);
 	}
 
+	/// Set the block size.
+	/// This allocates the block input buffers on all
+	/// input and effects channels. A value of 0 removes
+	/// the block buffers.
+	/// @param n number of samples in a block
+	void SetBlockSize(int n)
+	{
+		if (n < 0)
+			n = 0;
+		blkLen = n;
+		blkIn = 0;
+		blkOut = 0;
+		delete[] blkTmp;
+		blkTmp = 0;
+		if (n > 0)
+			blkTmp = new AmpValue[n*2];
+		int ch;
+		for (ch = 0; ch < mixInputs; ch++)
+			inBuf[ch].SetBlockSize(n);
+		for (ch = 0; ch < fxUnits; ch++)
+			fxBuf[ch].SetBlockSize(n);
+	}
+
+	/// Get the block size.
+	int GetBlockSize()
+	{
+		return blkLen;
+	}
+
+	/// Set the position for block input.
+	/// @param pos offset from the start of the block
+	void SetBlockPos(int pos)
+	{
+		blkIn = pos;
+	}
+
+	/// Send a block of samples to an input channel.
+	/// The block is added at the current block position and
+	/// must not extend past the end of the block.
+	/// @param ch channel number
+	/// @param val sample amplitude values
+	/// @param n number of values
+	void ChannelInBlock(int ch, const AmpValue *val, int n)
+	{
+		// warning - no runtime range check here...
+		inBuf[ch].InBlock(blkIn, val, n);
+	}
+
+	/// Send a block of samples to an input channel, direct.
+	/// This bypasses channel panning.
+	/// @param ch channel number
+	/// @param lft left sample amplitude values
+	/// @param rgt right sample amplitude values
+	/// @param n number of values
+	void ChannelIn2Block(int ch, const AmpValue *lft, const AmpValue *rgt, int n)
+	{
+		// warning - no runtime range check here...
+		inBuf[ch].In2Block(blkIn, lft, rgt, n);
+	}
+
 	/// Set the number of effects channels.
 	/// This should be called before beginning output.
 	/// Unlike SetChannels, effects channels are optional.
@@ -552,7 +831,14 @@ public:
 		}
 		fxUnits = n;
 		if (n > 0)
+		{
 			fxBuf = new FxChannel[n];
+			if (blkLen > 0)
+			{
+				for (int f = 0; f < n; f++)
+					fxBuf[f].SetBlockSize(blkLen);
+			}
+		}
 	}
 
 	/// Get the number of effects channels.
@@ -613,6 +899,16 @@ public:
 			fxBuf[f].FxIn(val);
 	}
 
+	/// Effects input direct, block of values.
+	/// @param f effects channel
+	/// @param val sample values
+	/// @param n number of values
+	void FxInBlock(int f, const AmpValue *val, int n)
+	{
+		if (f >= 0 && f < fxUnits)
+			fxBuf[f].FxInBlock(blkIn, val, n);
+	}
+
 	/// Get the mixed output.
 	/// This is the main output of the mixer. All input channels
 	/// and effects are combined into the left and right values.
@@ -625,6 +921,16 @@ public:
 		AmpValue rvalOut = 0;
 		FxChannel *fx, *fxe;
 		MixChannel *pin = inBuf;
+		if (blkLen > 0)
+		{
+			// Move the next sample from the block buffers.
+			for (n = 0; n < fxUnits; n++)
+				fxBuf[n].BlockIn(blkOut);
+			for (n = 0; n < mixInputs; n++)
+				inBuf[n].BlockIn(blkOut);
+			if (++blkOut >= blkLen)
+				blkOut = 0;
+		}
 		// Add inputs and send to fx units.
 		for (n = 0; n < mixInputs; n++)
 		{
@@ -664,6 +970,75 @@ public:
 			rpeak = *rval;
 	}
 
+	/// Get a block of mixed output.
+	/// This is the block equivalent of calling Out() n times.
+	/// Input sent with ChannelIn(), ChannelIn2() and FxIn()
+	/// only applies to the first sample.
+	/// @param lval left output values
+	/// @param rval right output values
+	/// @param n number of values
+	void OutBlock(AmpValue *lval, AmpValue *rval, int n)
+	{
+		if (blkLen <= 0)
+		{
+			while (--n >= 0)
+				Out(lval++, rval++);
+			return;
+		}
+		while (n > 0)
+		{
+			int cnt = blkLen - blkOut;
+			if (cnt > n)
+				cnt = n;
+			MixBlock(blkOut, lval, rval, cnt);
+			if ((blkOut += cnt) >= blkLen)
+				blkOut = 0;
+			lval += cnt;
+			rval += cnt;
+			n -= cnt;
+		}
+	}
+
+private:
+	void MixBlock(int pos, AmpValue *lval, AmpValue *rval, int n)
+	{
+		int ch;
+		int f;
+		AmpValue *lvl = fxUnits > 0 ? blkTmp : 0;
+		memset(lval, 0, n*sizeof(AmpValue));
+		memset(rval, 0, n*sizeof(AmpValue));
+		for (f = 0; f < fxUnits; f++)
+			fxBuf[f].BlockFold(pos);
+		// Add inputs and send to fx units.
+		MixChannel *pin = inBuf;
+		for (ch = 0; ch < mixInputs; ch++)
+		{
+			if (pin->IsOn())
+			{
+				pin->OutBlock(pos, lval, rval, lvl, n);
+				for (f = 0; f < fxUnits; f++)
+					fxBuf[f].FxSendBlock(ch, pos, lvl, n);
+			}
+			else
+				pin->BlockIn(pos, n);
+			pin++;
+		}
+		// Add outputs from fx units
+		for (f = 0; f < fxUnits; f++)
+			fxBuf[f].FxOutBlock(pos, lval, rval, &blkTmp[blkLen], n);
+
+		synthSIMD.Mul(lval, lval, lvol, n);
+		synthSIMD.Mul(rval, rval, rvol, n);
+		for (int i = 0; i < n; i++)
+		{
+			if (lval[i] > lpeak)
+				lpeak = lval[i];
+			if (rval[i] > rpeak)
+				rpeak = rval[i];
+		}
+	}
+
+public:
 	/// Get the peak value.
 	/// The peak value is reset to zero
 	/// @param lval left channel peak
@@ -687,6 +1062,8 @@ public:
 			fxBuf[n].Clear();
 		lpeak = 0.0;
 		rpeak = 0.0;
+		blkIn = 0;
+		blkOut = 0;
 	}
 
 	/// Get a reference to an input channel object.
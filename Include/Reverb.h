@@ -66,6 +66,18 @@ public:
 			delayPos = delayBuf;
 		return out;
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// @param in input values
+	/// @param out output values
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		for (int i = 0; i < n; i++)
+			out[i] = Reverb1::Sample(in[i]);
+	}
 };
 
 /// Schroeder reverb.
@@ -161,6 +173,41 @@ public:
 		AmpValue out = dlr[0].Sample(vin) + dlr[1].Sample(vin) + dlr[2].Sample(vin) + dlr[3].Sample(vin);
 		return ap[1].Sample(ap[0].Sample(out));
 	}
+
+	using GenUnit::Samples;
+
+	/// Process a block of samples.
+	/// Each comb filter runs over the whole block and the outputs
+	/// are summed in the same order as Sample(), followed by the
+	/// all-pass cascade. The results are identical to Sample().
+	/// Very short blocks are processed one sample at a time.
+	/// @param in input values
+	/// @param out output values (may be the same as in)
+	/// @param n number of values
+	void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
+		if (n < 8)
+		{
+			for (int i = 0; i < n; i++)
+				out[i] = Reverb2::Sample(in[i]);
+			return;
+		}
+		AmpValue vin[SIMD_BLKSIZE];
+		while (n > 0)
+		{
+			int cnt = n > SIMD_BLKSIZE ? SIMD_BLKSIZE : n;
+			synthSIMD.Mul(vin, in, atten, cnt);
+			dlr[0].Samples(vin, out, cnt);
+			dlr[1].SamplesAdd(vin, out, cnt);
+			dlr[2].SamplesAdd(vin, out, cnt);
+			dlr[3].SamplesAdd(vin, out, cnt);
+			ap[0].Samples(out, out, cnt);
+			ap[1].Samples(out, out, cnt);
+			in += cnt;
+			out += cnt;
+			n -= cnt;
+		}
+	}
 };
 
 //@}
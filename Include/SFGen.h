@@ -17,9 +17,46 @@
 #define SFGEN_H
 
 /// Oscillator that initializes directly from a SBZone.
+/// For a streamed sample, frames that are not resident
+/// are read from the stream set with SetStream(), or
+/// are zero if there is no stream.
 class GenWaveSB : public GenWaveWTLoop
 {
+protected:
+	SBSample *streamSamp;
+	SBStream *stream;
+
+	inline AmpValue StreamValue(int n)
+	{
+		if (n < streamSamp->residentLen)
+			return streamSamp->sample[n];
+		SBSampleRange *rng = streamSamp->loopRange;
+		if (rng && n >= rng->first && n < rng->last)
+		{
+			// While in the resident section, the next frame needed
+			// from the stream is the one after it. This lets the
+			// streamer read the release segment during the loop.
+			if (stream)
+				stream->readPos = rng->last;
+			return rng->data[n - rng->first];
+		}
+		if (stream == 0 || n >= streamSamp->sampleLen)
+			return 0;
+		return stream->Value(n);
+	}
+
 public:
+	GenWaveSB()
+	{
+		streamSamp = 0;
+		stream = 0;
+	}
+
+	~GenWaveSB()
+	{
+		CloseStream();
+	}
+
 	/// Init the wavetable oscillator.
 	/// @param zone sample information.
 	/// @param pi frequency in phase increment
@@ -40,7 +77,58 @@ public:
 		loopMode = zone->mode;
 		if (skipAttack && loopMode == 1)
 			phase = loopStart;
-		wavetable = zone->sample->sample;
+		SBSample *samp = zone->sample;
+		if (samp->sample16)
+			SetWavetable16(samp->sample16, samp->sampleLSB, samp->sampleLen);
+		else if (samp->mapped)
+			SetWavetable16(samp->mapped, samp->mappedLSB, samp->sampleLen);
+		else
+			SetWavetable(samp->sample);
+		CloseStream();
+		streamSamp = samp->IsStreamed() ? samp : 0;
+	}
+
+	/// Get the first frame that will be played.
+	inline bsInt32 GetStartFrame()
+	{
+		return (bsInt32) phase;
+	}
+
+	/// Set the stream for a streamed sample.
+	/// The stream is closed when the oscillator is deleted.
+	void SetStream(SBStream *s)
+	{
+		CloseStream();
+		stream = s;
+	}
+
+	void CloseStream()
+	{
+		if (stream)
+		{
+			stream->Close();
+			stream = 0;
+		}
+	}
+
+	/// Generate the next sample.
+	AmpValue Gen()
+	{
+		if (streamSamp == 0)
+			return GenWaveWTLoop::Gen();
+
+		if (phase < 0)
+			phase += period;
+		if (loopMode && phase >= loopEnd)
+			phase -= loopLen;
+		else if (phase >= tableEnd)
+			return 0.0;
+		ii = (int) phase;
+		fr = phase - (PhsAccum) ii;
+		phase += phsIncr;
+		AmpValue v1 = StreamValue(ii);
+		AmpValue v2 = StreamValue(ii+1);
+		return v1 + ((v2 - v1) * fr);
 	}
 
 	inline void UpdatePhaseIncr(PhsAccum p)
@@ -154,6 +242,11 @@ public:
 		return segNdx;
 	}
 
+	inline AmpValue GetLevel()
+	{
+		return curLevel;
+	}
+
 	inline void Reset(float initPhs)
 	{
 		if (initPhs >= 0)
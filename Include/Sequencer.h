@@ -59,16 +59,22 @@ typedef void (*SeqTickCB)(bsInt32 count, Opaque usr);
 #define SEQ_AE_REL  2 // indicates we are waiting on IsFinished
 #define SEQ_AE_TM   1 // indicates 'count' is valid
 #define SEQ_AE_KEEP 2 // keep the active event for possible restart (not currently used)
+#define SEQ_AE_TICK 4 // instrument does not support TickBlock, call Tick on each sample
+
+#define SEQ_BATCH_MAX  8 // maximum voices rendered with one call to TickBatch
+#define SEQ_BATCH_KEYS 4 // maximum different batch keys in one block segment
 
 struct ActiveEvent : public SynthList<ActiveEvent>
 {
 	Instrument *ip;
+	InstrConfig *ic; ///< configuration the instance was allocated from
 	bsInt32 count;  ///< number of samples left to play (duration)
 	bsInt32 evid;   ///< id of the event that activated this event
 	bsInt16 ison;   ///< SEQ_AE_REL after stop is sent to the instrument
 	bsInt16 flags;  ///< event options
 	bsInt16 chnl;   ///< output channel
 	bsInt16 trk;    ///< track number
+	bsInt32 quiet;  ///< samples the note has been below the silence level
 };
 
 ///////////////////////////////////////////////////////////
@@ -94,6 +100,42 @@ public:
 	virtual void Tick() = 0;
 };
 
+///////////////////////////////////////////////////////////
+/// Voice allocation policy interface.
+///
+/// When a policy is set, the sequencer does not apply the
+/// maximum note count itself. Instead, after each note starts,
+/// the policy is asked which voice to remove, repeatedly, until
+/// it returns NULL. A policy that limits polyphony by render
+/// time can also ask the sequencer to time the voice rendering.
+/// @sa VoicePolicy
+//////////////////////////////////////////////////////////
+class SeqVoicePolicy
+{
+public:
+	virtual ~SeqVoicePolicy() { }
+
+	/// Select a voice to remove.
+	/// @param head first active voice
+	/// @param tail end of the active list (not a voice)
+	/// @param act the voice just started, which must not be selected
+	/// @param count number of active voices, including act
+	/// @return voice to remove, or NULL to keep all voices
+	virtual ActiveEvent *Select(ActiveEvent *head, ActiveEvent *tail, ActiveEvent *act, bsInt32 count) = 0;
+
+	/// Determine if the sequencer should time the voice rendering.
+	/// @return non-zero to call StartRender() and EndRender()
+	virtual int Timed() { return 0; }
+
+	/// Voice rendering for a block is about to begin.
+	virtual void StartRender() { }
+
+	/// Voice rendering for a block has finished.
+	/// @param frames number of samples rendered for each voice
+	/// @param voices number of voices rendered
+	virtual void EndRender(bsInt32 frames, bsInt32 voices) { }
+};
+
 /// SeqState defines the sequencer state.
 /// These are combinations of bit-flags that control sequencer operations:
 /// 0x01 - sequence (track events are executed)
@@ -119,15 +161,19 @@ typedef int SeqState;
 /// to automatically start over when the end time is reached.
 /// Track 0 is the main track and is started automatically.
 /// All other tracks must be started by an event on track 0.
-/// Tracks are evaluated at tickRes intervals.
+/// Tracks are evaluated at tickRes intervals. Events that start
+/// between ticks are found with NextOffset() so that the sequencer
+/// can start them on the exact sample.
 //////////////////////////////////////////////////////////
 class SeqTrack : public SynthList<SeqTrack>
 {
 protected:
-	SeqEvent *evtHead;   ///< event list head
-	SeqEvent *evtTail;   ///< event list tail
-	SeqEvent *evtLast;   ///< last used event list position
-	SeqEvent *evtPlay;   ///< next event to play
+	SeqEvent **evtList;  ///< events sorted by start time
+	SeqEvent *evtTail;   ///< end of list marker, always at evtList[evtCount]
+	bsInt32 evtCount;    ///< number of events
+	bsInt32 evtAlloc;    ///< allocated size of evtList
+	bsInt32 evtPlay;     ///< index of the next event to play
+	bsInt16 sorted;      ///< events are in time order
 	bsInt32 loopCount;   ///< number of times to repeat the track
 	bsInt32 startTime;   ///< time (in samples) of first event
 	bsInt32 seqLength;   ///< time (in samples) of the track
@@ -146,25 +192,21 @@ public:
 		seqLength = 0;
 		seqResLen = 0;
 		tickRes = 1;
-		evtHead = new SeqEvent;
 		evtTail = new SeqEvent;
-		//evtHead->Insert(evtTail);
-		evtHead->next = evtTail;
-		evtHead->prev = evtTail;
-		evtTail->next = evtHead;
-		evtTail->prev = evtHead;
-		evtLast = evtHead;
-		evtHead->start = 0;
 		evtTail->start = 0x7FFFFFFFL;
-		evtHead->evid = -1;
 		evtTail->evid = -2;
-		evtPlay = evtTail;
+		evtCount = 0;
+		evtAlloc = 0;
+		evtList = 0;
+		Grow();
+		evtPlay = 0;
+		sorted = 1;
 	}
 
 	~SeqTrack()
 	{
 		Reset();
-		delete evtHead;
+		delete[] evtList;
 		delete evtTail;
 	}
 
@@ -184,9 +226,8 @@ public:
 		tickRes = res;
 		// round up to integer multipler of res
 		seqResLen = ((seqLength / res) + 1) * res;
-		evtPlay = evtHead->next;
-		while (evtPlay != evtTail && evtPlay->start < st)
-			evtPlay = evtPlay->next;
+		SortIfNeeded();
+		evtPlay = FindEvent(st);
 	}
 
 	/// Stop the track.
@@ -214,7 +255,7 @@ public:
 				else
 				{
 					startTime -= seqResLen;
-					evtPlay = evtHead->next;
+					evtPlay = 0;
 				}
 			}
 		}
@@ -228,21 +269,60 @@ public:
 	/// @returns next event to play, or NULL
 	inline SeqEvent *NextEvent()
 	{
-		if (enable && evtPlay->start <= startTime)
-		{
-			SeqEvent *evt = evtPlay;
-			evtPlay = evt->next;
-			return evt;
-		}
+		return NextEvent(0);
+	}
+
+	/// Get the next event ready at a position within the tick.
+	/// @param offset samples from the start of the current tick
+	/// @returns next event to play, or NULL
+	inline SeqEvent *NextEvent(bsInt32 offset)
+	{
+		// N.B. evtTail is always after the last event
+		if (enable && evtList[evtPlay]->start <= startTime + offset)
+			return evtList[evtPlay++];
 		return 0;
 	}
 
+	/// Get the position of the next event within the tick.
+	/// @param limit samples remaining to check
+	/// @returns offset of the next event from the start
+	/// of the current tick, or limit if no event is before that
+	inline bsInt32 NextOffset(bsInt32 limit)
+	{
+		bsInt32 ofs = evtList[evtPlay]->start - startTime;
+		if (enable && ofs < limit)
+			return ofs;
+		return limit;
+	}
+
 	/// Reset to clear all events.
 	void Reset();
 	/// Add a new event.
+	/// Events are appended and sorted by start time when
+	/// the sequencer starts, thus events can be added in any order.
+	/// Events with the same start time play in the order added.
 	void AddEvent(SeqEvent *evt);
+	/// Sort events by start time.
+	void Sort();
+	/// Sort events if any were added since the last sort.
+	inline void SortIfNeeded()
+	{
+		if (!sorted)
+			Sort();
+	}
+	/// Find the first event at or after a time.
+	/// The events must be sorted.
+	/// @param st time in samples
+	/// @returns index of the event
+	bsInt32 FindEvent(bsInt32 st);
+
+protected:
+	void Grow();
 };
 
+class SeqRenderPool;
+template<class T> class SynthQueueMPSC;
+
 ///////////////////////////////////////////////////////////
 /// Sequencer class.
 ///
@@ -273,17 +353,37 @@ protected:
 	bsInt32 tickWrap;
 	bsInt32 tickRes;
 	bsInt32 maxNote;    ///< maximum number of active notes
+	AmpValue silentLevel; ///< level below which a released note is silent, 0 for none
+	bsInt32 silentFrames; ///< samples a note must be silent before it is removed
+	SeqVoicePolicy *voicePolicy; ///< voice allocation policy, or NULL
 	bsInt32 evtActive;  ///< number of active notes
 	bsInt32 trkActive;  ///< number of active tracks
 	Opaque  tickArg;
 	bsInt32 wrapCount;
+	bool blkMode;       ///< block mode requested
+	bool blkActive;     ///< block mode in use for the current playback
+	bsInt32 numThreads; ///< number of threads for offline block rendering
+	SeqRenderPool *pool; ///< worker threads for the current playback
+	bsInt32 blkPos;     ///< start of the current block segment
+	bsInt32 blkFrames;  ///< length of the current block segment
 
 	ActiveEvent *actHead;
 	ActiveEvent *actTail;
+	ActiveEvent *actArena;  ///< preallocated active events
+	ActiveEvent *actFree;   ///< free list of arena entries
+	bsInt32 actArenaSize;   ///< number of entries in the arena
+	bsInt32 statActive;     ///< number of entries on the active list
+	bsInt32 statPeak;       ///< maximum of statActive since playback started
+	double statVoiceFrames; ///< sum of active entries times frames generated
+	bsInt32 statSilent;     ///< notes removed because they were silent
 
 	// v 1.2 - add immediate events
+	// Immediate events are passed through a lock-free queue.
+	// The list is only used when the queue overflows.
+	SynthQueueMPSC<SeqEvent*> *immQueue;
 	SeqEvent *immHead;
 	SeqEvent *immTail;
+	volatile long immOverflow;
 
 	SynthMutex critMutex;
 	SynthSignal pauseSignal;
@@ -294,9 +394,25 @@ protected:
 
 	virtual void ProcessEvent(SeqEvent *evt, bsInt16 flags);
 	virtual int Tick();
+	virtual int TickBlock(bsInt32 pos, bsInt32 frames);
+	int TickFrames(bsInt32 pos, bsInt32 frames);
 	virtual void Wait();
 
 	void ClearActive();
+	void ProcessImmediate(bool discard);
+	void InitActive();
+	void SortTracks();
+	ActiveEvent *NewActive();
+	void FreeActive(ActiveEvent *act);
+	void StartBlock(bool offline);
+	void StopBlock();
+	int RenderBlock(ActiveEvent *act, int pos, int frames);
+	void BlockVoice(ActiveEvent *act);
+	void BatchVoices();
+	void StealVoices(ActiveEvent *act);
+	void RemoveSilent(bsInt32 frames);
+
+	friend class SeqRenderPool;
 
 public:
 	Sequencer();
@@ -333,11 +449,110 @@ public:
 		return count;
 	}
 
+	/// Set the maximum number of active notes.
+	/// Active note entries are preallocated to this size
+	/// when the next sequence starts.
 	virtual void SetMaxNotes(bsInt32 n)
 	{
 		maxNote = n;
 	}
 
+	/// Set the voice allocation policy.
+	/// When set, the policy decides which notes to remove when
+	/// too many are active, and maxNote only sets the number of
+	/// preallocated active note entries.
+	/// The policy must remain valid while the sequencer plays.
+	/// @param p policy, or NULL to remove the oldest note above maxNote
+	virtual void SetVoicePolicy(SeqVoicePolicy *p)
+	{
+		voicePolicy = p;
+	}
+
+	/// Get the voice allocation policy.
+	virtual SeqVoicePolicy *GetVoicePolicy()
+	{
+		return voicePolicy;
+	}
+
+	/// Set the silence threshold.
+	/// A note in release is removed before the instrument
+	/// reports IsFinished() when Instrument::GetLevel() stays
+	/// below the level for the given time. Instruments that
+	/// do not know their level return 1 and are never removed.
+	/// The level is checked at the start of each tick segment.
+	/// @param lvl amplitude level, 0 to disable
+	/// @param secs time the level must stay below the threshold
+	virtual void SetSilence(AmpValue lvl, FrqValue secs)
+	{
+		silentLevel = lvl;
+		silentFrames = (bsInt32) (secs * synthParams.sampleRate);
+	}
+
+	/// Get the number of notes removed because they were silent.
+	/// The value is cleared when playback starts.
+	virtual bsInt32 GetSilentCount()
+	{
+		return statSilent;
+	}
+
+	/// Set block mode.
+	/// In block mode, each active instrument generates a block of tickRes
+	/// samples with one call to Instrument::TickBlock() rather than one
+	/// call to Instrument::Tick() per sample. Instruments that do not
+	/// support block rendering are still called on each sample.
+	/// Block mode is only used if the instrument manager supports
+	/// block output. Instruments are checked for completion at the
+	/// start of each block, so larger tickRes values are faster
+	/// but may generate a few extra samples of silence at the end
+	/// of each note.
+	/// @param on true to enable block mode
+	virtual void SetBlockMode(bool on)
+	{
+		blkMode = on;
+	}
+
+	/// Get block mode setting.
+	virtual bool GetBlockMode()
+	{
+		return blkMode;
+	}
+
+	/// Set the number of rendering threads.
+	/// When block mode is active and the sequence is not played
+	/// live, the active voices in each block are divided among
+	/// this many threads (including the caller's thread).
+	/// Each voice writes its block output into a separate buffer,
+	/// and the buffers are added into the mixer in the order of
+	/// the active voice list. Thus the output does not depend on
+	/// the number of threads. Instruments that do not support
+	/// block rendering are always called on the sequencer thread.
+	/// The worker threads spin briefly while waiting for the next
+	/// block and then block on a signal. No more threads are used
+	/// than there are CPUs.
+	/// @param n number of threads, 1 or less to render on the caller's thread only
+	virtual void SetThreads(int n)
+	{
+		numThreads = n;
+	}
+
+	/// Get the number of rendering threads.
+	virtual int GetThreads()
+	{
+		return numThreads;
+	}
+
+	/// Get playback statistics.
+	/// The values are cleared when playback starts and
+	/// are valid during and after playback.
+	/// @param peak maximum number of notes active at once
+	/// @param voiceFrames sum over all ticks of the number of
+	/// active notes times the samples generated in the tick
+	virtual void GetStats(bsInt32& peak, double& voiceFrames)
+	{
+		peak = statPeak;
+		voiceFrames = statVoiceFrames;
+	}
+
 	/// Set the tick callback function. 
 	/// @param cb callback function
 	/// @param wrap number of ticks between callbacks
@@ -401,6 +616,9 @@ public:
 	/// Add the event for immediate playback.
 	/// The caller is responsible for setting
 	/// valid values for inum, type and event id where appropriate.
+	/// This may be called from any thread. Events are passed to the
+	/// sequencer through a lock-free queue and processed at the start
+	/// of the next block of tickRes samples.
 	/// @param evt the event to schedule
 	virtual void AddImmediate(SeqEvent *evt);
 
@@ -455,6 +673,9 @@ public:
 	/// The tick resolution determines how many samples
 	/// are generated before checking the tracks for
 	/// new events. Higher settings allow better performance.
+	/// Sequenced events still start on the exact sample
+	/// since each tick is split at the events inside it.
+	/// Immediate events are processed at the start of a tick.
 	/// @param res resolution in seconds
 	virtual void SetResolution(FrqValue res)
 	{
@@ -203,22 +203,64 @@ public:
 
 };
 
+/// @brief Resident section of a streamed sample.
+/// A new, larger section replaces the current one when another zone
+/// needs more of the sample. The replaced section may still be in use
+/// by a playing voice, so it is kept until the sample is deleted.
+class SBSampleRange
+{
+public:
+	AmpValue *data;      ///< sample values for [first,last)
+	bsInt32 first;       ///< first frame
+	bsInt32 last;        ///< one past the last frame
+	SBSampleRange *prev; ///< replaced section
+
+	SBSampleRange(bsInt32 f, bsInt32 l, SBSampleRange *p)
+	{
+		first = f;
+		last = l;
+		prev = p;
+		data = new AmpValue[l - f];
+	}
+
+	~SBSampleRange()
+	{
+		delete[] data;
+		delete prev;
+	}
+};
+
 /// @brief SBSample contains a block of samples read from the file.
 /// For SF2 files, there is only one block holding all
 /// samples. However, we divide that one block into smaller blocks.
 /// DLS files have multiple blocks, potentially one for each region.
 /// The filepos member is included to allow for incremental loading of sample information.
 /// (@sa SoundBank::GetSample())
+/// When the soundbank file is memory mapped, 16-bit and 24-bit mono samples
+/// are not copied. The mapped member points at the sample data in the file
+/// and the oscillator converts values as it reads them.
+/// When streaming is enabled, only the first part of a long mono sample
+/// (residentLen frames) and the loop section are kept in memory. The
+/// remainder is read by the SoundBankStreamer while the sample plays.
+/// When native samples are enabled, 16-bit and 24-bit mono samples are
+/// kept in their original form in sample16 (and sampleLSB) instead of
+/// being converted to float.
 class SBSample : public SynthList<SBSample>
 {
 public:
 	AmpValue *sample;    ///< mono sample
 	AmpValue *linked;    ///< second array for 2 channel
+	const bsInt16 *mapped;    ///< 16-bit samples in the mapped file
+	const bsUint8 *mappedLSB; ///< LSB in the mapped file for SF2 24-bit format
+	bsInt16 *sample16;   ///< native 16-bit samples
+	bsUint8 *sampleLSB;  ///< native LSB for SF2 24-bit format
 	SBSample *linkSamp;  ///< linked, phase-locked sample object
+	SBSampleRange *loopRange; ///< resident loop section of a streamed sample
 	bsUint32  filepos;   ///< file offset for samples
 	bsUint32  filepos2;  ///< offset for LSB in SF2 24-bit format
 	bsInt32   rate;      ///< recording sample rate
 	bsInt32   sampleLen; ///< total length of 'samples'
+	bsInt32   residentLen; ///< frames in 'sample' when streamed, 0 = all
 	bsInt32   index;     ///< index/id number
 	bsInt16   format;    ///< 0 = 8-bit, 1=16-bit, 2=IEEE float, 3=SF2 24-bit
 	bsInt16   channels;  ///< 1 = mono, 2 = stero (others not supported)
@@ -228,8 +270,14 @@ public:
 		index = n;
 		sample = 0;
 		linked = 0;
+		mapped = 0;
+		mappedLSB = 0;
+		sample16 = 0;
+		sampleLSB = 0;
 		linkSamp = 0;
+		loopRange = 0;
 		sampleLen = 0;
+		residentLen = 0;
 		rate = 44100;
 		filepos = 0;
 		filepos2 = 0;
@@ -239,8 +287,104 @@ public:
 
 	~SBSample()
 	{
-		delete sample;
-		delete linked;
+		delete[] sample;
+		delete[] linked;
+		delete[] sample16;
+		delete[] sampleLSB;
+		delete loopRange;
+	}
+
+	/// Determine if sample data is available, either loaded or mapped.
+	int IsLoaded()
+	{
+		return sample != 0 || mapped != 0 || sample16 != 0;
+	}
+
+	/// Get the number of bytes of sample data held in memory.
+	/// Mapped samples are not counted.
+	bsUint32 MemSize()
+	{
+		bsUint32 bytes = 0;
+		if (sample)
+			bytes += (residentLen ? residentLen : sampleLen + 2) * sizeof(AmpValue);
+		if (linked)
+			bytes += (sampleLen + 2) * sizeof(AmpValue);
+		if (sample16)
+			bytes += sampleLen * sizeof(bsInt16);
+		if (sampleLSB)
+			bytes += sampleLen;
+		SBSampleRange *rng;
+		for (rng = loopRange; rng; rng = rng->prev)
+			bytes += (rng->last - rng->first) * sizeof(AmpValue);
+		return bytes;
+	}
+
+	/// Determine if only part of the sample is resident.
+	int IsStreamed()
+	{
+		return residentLen > 0;
+	}
+};
+
+class SoundBank;
+
+/// @brief Playback stream for one voice.
+/// @details The stream holds a ring buffer with the frames of a
+/// streamed sample that are not resident. The stream is filled by the
+/// SoundBankStreamer thread and read by the oscillator. Frame n is
+/// at buf[n & mask]. The reader sets readPos to the frame it reads
+/// and the writer sets fillPos past the last frame written.
+class SBStream
+{
+public:
+	SBSample *samp;         ///< sample to stream
+	SoundBank *bnk;         ///< soundbank that holds the sample
+	AmpValue *buf;          ///< ring buffer
+	bsInt32 mask;           ///< ring buffer size - 1
+	bsInt32 avail;          ///< reader's copy of fillPos
+	volatile long readPos;  ///< frame last read
+	volatile long fillPos;  ///< frames before this are filled
+	volatile long state;    ///< 0 = free, 1 = opening, 2 = playing, 3 = closing
+	long underruns;         ///< frames not ready when read
+	FileReadBuf file;       ///< file used by the writer
+	SoundBank *fileBank;    ///< soundbank of the open file
+
+	SBStream()
+	{
+		samp = 0;
+		bnk = 0;
+		buf = 0;
+		mask = 0;
+		avail = 0;
+		readPos = 0;
+		fillPos = 0;
+		state = 0;
+		underruns = 0;
+		fileBank = 0;
+	}
+
+	~SBStream()
+	{
+		delete[] buf;
+	}
+
+	/// Get the current fill position from the writer.
+	bsInt32 Available();
+
+	/// Release the stream. Call this when the voice ends.
+	void Close();
+
+	/// Read one streamed frame. Frames that have not been
+	/// filled yet return zero. Frames must be read in order.
+	inline AmpValue Value(bsInt32 n)
+	{
+		readPos = n;
+		if (n >= avail && n >= (avail = Available()))
+		{
+			underruns++;
+			return 0;
+		}
+		return buf[n & mask];
 	}
 };
 
@@ -291,6 +435,20 @@ public:
 	}
 };
 
+/// @brief Envelope times and level derived from SBEnv.
+/// Times are in seconds. A time that is scaled by key number or
+/// velocity depends on the note and is calculated at note-on.
+class SBEnvRates
+{
+public:
+	FrqValue  delay;
+	FrqValue  attack;
+	FrqValue  hold;
+	FrqValue  decay;
+	FrqValue  release;
+	AmpValue  sustain;  ///< sustain level (0-1)
+};
+
 /// @brief SBZone represents a wavetable for a range of keys.
 /// The zone includes a pointer to the wavetable, loop points,
 /// frequency, and envelope information. The key and velocity
@@ -366,6 +524,23 @@ public:
 	bsUint32  genFlags;  ///< flags indicating default modulator connections
 	AmpValue  peak;      ///< peak amplitude of loop
 
+	/// @name Derived values
+	/// These are calculated from the values above by Precompute()
+	/// so that the player does not repeat the conversions on every note.
+	/// They are only valid for the sample rate in derivedRate.
+	/// @{
+	FrqValue  derivedRate; ///< output sample rate for the derived values, 0 if not calculated
+	FrqValue  rateCents;   ///< wavetable sample rate relative to the output rate (cents)
+	FrqValue  vibLfoHz;    ///< vibrato LFO frequency
+	FrqValue  modLfoHz;    ///< modulation LFO frequency
+	bsInt32   vibDelayN;   ///< vibrato LFO delay (samples)
+	bsInt32   modDelayN;   ///< modulation LFO delay (samples)
+	SBEnvRates volRt;      ///< volume envelope
+	SBEnvRates modRt;      ///< modulation envelope
+	AmpValue  filtGainQ;   ///< filter resonance (linear gain)
+	AmpValue  filtCoef[3]; ///< filter coefficients at filtFreq
+	/// @}
+
 	SBZone()
 	{
 		Init();
@@ -425,8 +600,14 @@ public:
 		chorus = 0;
 
 		genFlags = 0;
+		derivedRate = 0;
 	}
 
+	/// @brief Calculate the derived values.
+	/// This also sets the SBGEN_FILTERX and SBGEN_FILTERD
+	/// flags in genFlags from the filter settings.
+	void Precompute();
+
 	/// @brief Check this zone for a match to key and velocity.
 	inline int Match(int key, int vel)
 	{
@@ -685,6 +866,16 @@ public:
 /// All soundbank objects should be attached to the static
 /// SoundBankList member and located using FindBank.
 //////////////////////////////////////////////////////////////
+class SoundBankLoader;
+class SoundBankStreamer;
+
+/// @brief Progress callback for PreloadSamples().
+/// @param done number of samples loaded so far
+/// @param total number of samples in the soundbank
+/// @param secs time since the preload started, in seconds
+/// @param usr caller data
+typedef void (*SBLoadCB)(bsInt32 done, bsInt32 total, double secs, Opaque usr);
+
 class SoundBank : public SynthList<SoundBank>
 {
 private:
@@ -699,6 +890,27 @@ public:
 	SBSample *samples;             ///< list of sample blocks
 	FileReadBuf sampleFile;        ///< file for on-demand loading of samples
 	int sampleFileOpen;
+	FileReadMap sampleMap;         ///< mapped file for in-place samples
+	int sampleMapOpen;             ///< 0 = not tried, 1 = mapped, -1 = failed
+	SoundBankLoader *loader;       ///< background loader, if attached
+	SoundBankStreamer *streamer;   ///< sample streamer, if attached
+	/// Map sample data rather than loading it. This applies to banks
+	/// loaded after the value is set. Mapped banks share one copy of
+	/// the sample data between all processes that load the same file.
+	static int mapSamples;
+	/// Stream long samples from the file, keeping this many milliseconds
+	/// of the start and the loop section resident. Zero disables streaming.
+	/// This applies to samples loaded after the value is set.
+	static int streamMillisec;
+	/// Keep 16-bit and 24-bit mono samples in their native format rather
+	/// than converting them to float. This uses half the memory for 16-bit
+	/// samples and the oscillator converts values as it reads them.
+	/// This applies to samples loaded after the value is set.
+	static int nativeSamples;
+	/// Number of threads used to preload samples when a soundbank
+	/// file is loaded with preload set. Values less than 2 load
+	/// all samples on the caller's thread.
+	static int preloadThreads;
 
 	static SoundBank SoundBankList; ///< List of loaded soundbanks
 	static void DeleteBankList();  ///< Remove all soundbanks
@@ -783,6 +995,9 @@ public:
 	SoundBank()
 	{
 		sampleFileOpen = 0;
+		sampleMapOpen = mapSamples ? 0 : -1;
+		loader = 0;
+		streamer = 0;
 		lockCount = 0;
 		samples = 0;
 		chnls = 0xffff;
@@ -819,11 +1034,10 @@ public:
 		}
 	}
 
-	/// Optimize the zone lookup.
-	void Optimize()
-	{
-		// no longer needed
-	}
+	/// Calculate derived values for all zones.
+	/// The loaders call this after the sound bank is built.
+	/// @sa SBZone::Precompute
+	void Optimize();
 
 	/// @name SoundBank locking.
 	/// A SoundBank object is likely shared by multiple instruments
@@ -913,6 +1127,15 @@ public:
 		return in;
 	}
 
+	/// @brief Locate an instrument without waiting on file I/O.
+	/// @details When a background loader is attached, an instrument
+	/// that is not loaded is queued for the loader and NULL is returned.
+	/// Otherwise, this is the same as GetInstr().
+	/// @param bank bank number
+	/// @param prog patch number
+	/// @return pointer to loaded instrument definition, or null
+	SBInstr *RequestInstr(bsInt16 bank, bsInt16 prog);
+
 	/// @brief Add a sample block.
 	/// @param ndx index (id) for this sample
 	/// @return pointer to empty sample
@@ -940,7 +1163,7 @@ public:
 		{
 			if (samp->index == ndx)
 			{
-				if (samp->sample == 0 && load)
+				if (!samp->IsLoaded() && load)
 					LoadSample(samp);
 				return samp;
 			}
@@ -952,11 +1175,21 @@ public:
 	/// @name Sample Loading
 	/// Load sample data from the original file.
 	/// If the sample cannot be loaded, a block of zeros is allocated.
+	/// When mapSamples was set, mono 16-bit and 24-bit samples
+	/// are mapped instead (@sa MapSample()). Otherwise, when
+	/// nativeSamples was set, they are kept as integers (@sa ReadNative()).
 	/// @param samp pointer to sample block object.
 	/// @param f already open file
 	/// @return 0 on success, non-zero on failure.
 	/// @{
 	int OpenSampleFile();
+	int MapSample(SBSample *samp);
+	int StreamSample(SBSample *samp, FileReadBuf& f);
+	int AddResident(SBSample *samp, FileReadBuf& f, bsInt32 first, bsInt32 last);
+	int ReadFrames(SBSample *samp, FileReadBuf& f, bsInt32 first, bsInt32 count, AmpValue *sp);
+	int ReadNative(SBSample *samp, FileReadBuf& f);
+	int ReadPCM(SBSample *samp, FileReadAt& f);
+	bsInt32 StreamHead(SBSample *samp);
 	int LoadSample(SBSample *samp);
 	int LoadSample(SBSample *samp, FileReadBuf& f);
 	int LoadInstr(SBInstr *instr);
@@ -964,6 +1197,28 @@ public:
 	int ReadSamples1(SBSample *samp, FileReadBuf& f);
 	int ReadSamples2(SBSample *samp, FileReadBuf& f);
 	/// @}
+
+	/// @brief Load all samples that are not loaded.
+	/// @details The sample list is divided between the caller's
+	/// thread and up to threads-1 worker threads. Each thread reads
+	/// with its own file handle. Mono 16-bit and 24-bit samples are
+	/// read with positional reads and converted with the vector kernel
+	/// (@sa ReadPCM()); other samples are loaded with LoadSample().
+	/// The callback is invoked on the caller's thread as samples
+	/// complete, and once more at the end with done equal to total.
+	/// Each instrument is then loaded with LoadInstr(), so that the
+	/// loops of streamed samples are resident before the first note.
+	/// @param threads number of threads, including the caller's
+	/// @param cb progress callback, or NULL
+	/// @param usr caller data for the callback
+	/// @return 0 on success, non-zero if any sample failed to load
+	int PreloadSamples(int threads, SBLoadCB cb = 0, Opaque usr = 0);
+
+	/// @brief Open a playback stream for a streamed sample.
+	/// @param samp sample, which must be streamed
+	/// @param start first frame to play
+	/// @return stream or NULL if no streamer is attached or none is free
+	SBStream *OpenStream(SBSample *samp, bsInt32 start);
 };
 
 #endif
@@ -0,0 +1,90 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file SoundBankCache.h Binary cache of a built soundbank.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+/// @addtogroup grpSoundbank
+//@{
+
+#ifndef SOUNDBANKCACHE_H
+#define SOUNDBANKCACHE_H
+
+#define SBCACHE_VERSION 1
+
+/// @brief Cache file header.
+/// @details The header is followed by flat arrays of records,
+/// one for each object in the soundbank, and a string table.
+/// References between objects are stored as record numbers
+/// and converted back to pointers when the cache is read.
+/// Record sizes are saved so that a cache written by a different
+/// build is detected and rebuilt.
+struct sbcHeader
+{
+	char magic[4];          ///< 'BSBC'
+	bsUint32 version;       ///< SBCACHE_VERSION
+	bsUint32 byteOrder;     ///< 0x01020304 in native order
+	bsUint32 recSize[5];    ///< size of sample, instr, group, zone and mod records
+	bsUint32 srcSize;       ///< size of the soundbank file
+	bsUint32 srcTime;       ///< modification time of the soundbank file
+	bsUint32 secOffs[7];    ///< file offset of each section
+	bsUint32 secCount[7];   ///< number of records in each section
+	bsInt16  fileVer[4];    ///< SBInfo version numbers
+	bsUint32 infoStr[8];    ///< SBInfo strings
+	bsUint16 chnls;
+	bsUint16 pad;
+};
+
+/// @brief Read and write soundbank cache files.
+/// @details Parsing a large SF2 or DLS file, building the zones
+/// and applying the generators and modulators can take seconds.
+/// The cache holds the result in a form that is quick to read.
+/// The cache for a soundbank file is the same path with ".bsc"
+/// appended. It is written the first time the soundbank is loaded and
+/// used thereafter as long as the soundbank file size and time do not
+/// change. Sample data is not cached; samples are loaded from the
+/// soundbank file as usual.
+///
+/// Use LoadSoundBank() in place of SFFile::LoadSoundBank() or
+/// DLSFile::LoadSoundBank().
+class SoundBankCache
+{
+public:
+	/// Read and write cache files. When cleared, LoadSoundBank()
+	/// always loads the soundbank file.
+	static int useCache;
+
+	/// @brief Load a soundbank, using the cache if it is valid.
+	/// @param fname SF2 or DLS file
+	/// @param pre preload all samples
+	/// @param cb preload progress callback, or NULL
+	/// @param usr caller data for the callback
+	/// @return soundbank or NULL on error
+	static SoundBank *LoadSoundBank(const char *fname, int pre = 1, SBLoadCB cb = 0, Opaque usr = 0);
+
+	/// @brief Get the cache file name for a soundbank file.
+	static void CacheName(const char *fname, bsString& cname);
+
+	/// @brief Read a cache file.
+	/// @param cname cache file
+	/// @param fname soundbank file for sample data
+	/// @param pre preload all samples
+	/// @param cb preload progress callback, or NULL
+	/// @param usr caller data for the callback
+	/// @return soundbank or NULL if the cache is missing or out of date
+	static SoundBank *ReadCache(const char *cname, const char *fname, int pre, SBLoadCB cb = 0, Opaque usr = 0);
+
+	/// @brief Write a cache file.
+	/// @param bnk soundbank, loaded from fname
+	/// @param cname cache file
+	/// @param fname soundbank file
+	/// @return 0 on success
+	static int WriteCache(SoundBank *bnk, const char *cname, const char *fname);
+};
+
+//@}
+#endif
@@ -0,0 +1,137 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file SoundBankLoader.h Background loading of soundbank instruments.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+/// @addtogroup grpSoundbank
+//@{
+
+#ifndef SOUNDBANKLOADER_H
+#define SOUNDBANKLOADER_H
+
+#define SBLOADER_QUEUE 64
+#define SBLOADER_BANKS 8
+
+/// @brief Loader statistics.
+/// Latency is the time from the request until the
+/// instrument samples are available, in seconds.
+class SBLoaderStats
+{
+public:
+	long requests;     ///< requests queued
+	long loaded;       ///< instruments loaded
+	long dropped;      ///< requests discarded on a full queue
+	long queueDepth;   ///< requests currently waiting
+	long queuePeak;    ///< maximum requests waiting
+	double latencyAvg; ///< average latency
+	double latencyMax; ///< maximum latency
+
+	SBLoaderStats()
+	{
+		requests = 0;
+		loaded = 0;
+		dropped = 0;
+		queueDepth = 0;
+		queuePeak = 0;
+		latencyAvg = 0;
+		latencyMax = 0;
+	}
+};
+
+/// @brief Background loader for soundbank instruments.
+/// @details A soundbank normally loads the samples for an instrument
+/// the first time the instrument is located, and that happens when
+/// a note starts. With live MIDI input, the first note after a
+/// program change then stalls the audio while the file is read.
+/// The loader moves the file reads to a separate thread.
+///
+/// A soundbank attached to the loader does not load instruments
+/// from SoundBank::RequestInstr(). Instead, the instrument is queued
+/// for the loader and NULL is returned, so the note is silent
+/// until the samples arrive. MIDIControl calls Prefetch() on program
+/// change and bank select so that the samples are usually loaded before
+/// the first note. All loads for attached banks are serialized by the
+/// loader, including direct calls to SoundBank::LoadInstr().
+class SoundBankLoader : public SynthThread
+{
+private:
+	struct LoadRequest
+	{
+		SoundBank *bnk;  // NULL = all attached banks
+		bsInt16 bank;
+		bsInt16 prog;
+		double time;
+	};
+
+	LoadRequest queue[SBLOADER_QUEUE];
+	int queueHead;
+	int queueCount;
+	SoundBank *banks[SBLOADER_BANKS];
+	SBLoaderStats stats;
+	double latencySum;
+	volatile long running;
+	SynthMutex queueLock;
+	SynthMutex loadLock;
+	SynthSignal wakeup;
+
+	int Enqueue(SoundBank *bnk, bsInt16 bank, bsInt16 prog);
+	int Dequeue(LoadRequest& req);
+	void Load(SoundBank *bnk, bsInt16 bank, bsInt16 prog, double time);
+
+public:
+	SoundBankLoader();
+	~SoundBankLoader();
+
+	/// Start the loader thread.
+	/// @return 0 on success, -1 on failure
+	int Start();
+	/// Stop the loader thread. Requests still queued are discarded.
+	void Stop();
+	/// Determine if the loader thread is running.
+	int IsRunning() { return (int) running; }
+
+	/// Attach a soundbank. The soundbank is locked until detached.
+	/// @param bnk soundbank
+	/// @return 0 on success, -1 if too many banks are attached.
+	int Attach(SoundBank *bnk);
+	/// Detach a soundbank. Queued requests for the bank are discarded.
+	/// @param bnk soundbank
+	void Detach(SoundBank *bnk);
+
+	/// Queue loading of one instrument.
+	/// This does not block on file I/O and may be called from the
+	/// render thread. Duplicate requests are ignored.
+	/// @param bnk soundbank
+	/// @param bank bank number
+	/// @param prog program (patch) number
+	/// @return 0 if queued, -1 if the queue is full
+	int Request(SoundBank *bnk, bsInt16 bank, bsInt16 prog);
+	/// Queue loading of an instrument in all attached soundbanks.
+	/// @param bank bank number
+	/// @param prog program (patch) number
+	/// @return 0 if queued, -1 if the queue is full
+	int Prefetch(bsInt16 bank, bsInt16 prog);
+
+	/// @name Load serialization
+	/// SoundBank holds the load lock while reading samples
+	/// for a bank attached to this loader.
+	/// @{
+	void LockLoad() { loadLock.Enter(); }
+	void UnlockLoad() { loadLock.Leave(); }
+	/// @}
+
+	/// Get loader statistics.
+	/// @param st returned statistics
+	void GetStats(SBLoaderStats& st);
+	/// Clear loader statistics.
+	void ResetStats();
+
+	int ThreadProc();
+};
+#endif
+//@}
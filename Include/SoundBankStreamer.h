@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file SoundBankStreamer.h Disk streaming of soundbank samples.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+/// @addtogroup grpSoundbank
+//@{
+
+#ifndef SOUNDBANKSTREAMER_H
+#define SOUNDBANKSTREAMER_H
+
+/// @brief Streamer statistics.
+class SBStreamStats
+{
+public:
+	long opened;      ///< streams opened
+	long failed;      ///< opens that found no free stream
+	long active;      ///< streams currently playing
+	long activePeak;  ///< maximum streams playing
+	long underruns;   ///< frames that were not ready when played
+	double bytesRead; ///< sample bytes read from files
+
+	SBStreamStats()
+	{
+		opened = 0;
+		failed = 0;
+		active = 0;
+		activePeak = 0;
+		underruns = 0;
+		bytesRead = 0;
+	}
+};
+
+/// @brief Disk streaming for long soundbank samples.
+/// @details When SoundBank::streamMillisec is set, only the start
+/// and the loop section of long samples are loaded. A voice that plays
+/// such a sample opens a stream with SoundBank::OpenStream(), and
+/// the streamer thread reads the rest of the sample into the stream
+/// ahead of the playback position. Memory use then depends on the
+/// number of voices rather than the size of the soundbank.
+///
+/// The streams are allocated when the streamer is created so that
+/// opening a stream on the render thread does not allocate memory.
+/// If all streams are in use, the voice plays only the resident part.
+///
+/// The streamer must be stopped only after playback has ended.
+class SoundBankStreamer : public SynthThread
+{
+private:
+	SBStream *streams;
+	int numStreams;
+	bsInt32 bufFrames;
+	volatile long running;
+	volatile long opened;
+	volatile long failed;
+	long activePeak;
+	long underruns;
+	double bytesRead;
+	SynthMutex statLock;
+	SynthSignal wakeup;
+
+	int Fill(SBStream *s);
+
+public:
+	/// Create the streamer.
+	/// @param n maximum number of streams (voices)
+	/// @param frames ring buffer size for each stream, rounded up to a power of 2
+	SoundBankStreamer(int n = 64, bsInt32 frames = 16384);
+	~SoundBankStreamer();
+
+	/// Start the streamer thread.
+	/// @return 0 on success, -1 on failure
+	int Start();
+	/// Stop the streamer thread. All streams are released.
+	void Stop();
+	/// Determine if the streamer thread is running.
+	int IsRunning() { return (int) running; }
+
+	/// Use this streamer for a soundbank.
+	void Attach(SoundBank *bnk) { bnk->streamer = this; }
+	/// Stop using this streamer for a soundbank.
+	void Detach(SoundBank *bnk) { if (bnk->streamer == this) bnk->streamer = 0; }
+
+	/// Open a stream. This does not block and may be
+	/// called from the render thread.
+	/// @param bnk soundbank that holds the sample
+	/// @param samp streamed sample
+	/// @param start first frame to play
+	/// @return stream or NULL if none is free
+	SBStream *Open(SoundBank *bnk, SBSample *samp, bsInt32 start);
+
+	/// Get streamer statistics.
+	/// @param st returned statistics
+	void GetStats(SBStreamStats& st);
+
+	int ThreadProc();
+};
+#endif
+//@}
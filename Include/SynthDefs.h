@@ -111,6 +111,10 @@ public:
 	bsString wvPath;
 	/// cB value table
 	AmpValue cbVals[MAX_AMPCB];
+	/// samples per control period for modulation sources (see GenCtl).
+	/// 1 evaluates modulators on every sample; larger values
+	/// trade accuracy for speed. Instruments read this at note start.
+	bsInt32 ctlRate;
 
 	/// Constructor. The constructor for \p SynthConfig initializes
 	/// member variables to default values by calling \p Init().
@@ -119,6 +123,7 @@ public:
 	SynthConfig()
 	{
 		Init();
+		ctlRate = 1;
 
 		size_t sampleBits = (sizeof(SampleValue) * 8) - 1; // -1 because a sample is a signed value.
 		sampleScale = (AmpValue) ((1 << sampleBits) - 1);
@@ -328,13 +333,29 @@ public:
 	virtual AmpValue Sample(AmpValue in) { return 0; }
 
 	/// Return a block of samples.
-	/// A convienience function that will call Sample to return a block of values
+	/// A convienience function that will call Samples() to return a block of values
 	/// @param block structure to hold a block of samples, initialized by the caller.
 	virtual void Samples(SampleBlock *block)
 	{
-		int n = block->size;
-		AmpValue *in = block->in;
-		AmpValue *out = block->out;
+		Samples(block->in, block->out, block->size);
+	}
+
+	/// Process a block of samples.
+	/// The result is the same as calling Sample() for each value.
+	/// The default calls Sample() in a loop. Filters and delay lines
+	/// override this to keep their state in local variables for the
+	/// whole block and avoid one virtual call per sample.
+	/// A derived class that overrides Sample() must also override
+	/// this method if the base class has overridden it.
+	/// A class that overrides this method should also declare
+	/// \c using \c GenUnit::Samples so that Samples(SampleBlock*)
+	/// is not hidden.
+	/// The in and out buffers may be the same.
+	/// @param in input values
+	/// @param out output values
+	/// @param n number of values
+	virtual void Samples(const AmpValue *in, AmpValue *out, int n)
+	{
 		while (--n >= 0)
 			*out++ = Sample(*in++);
 	}
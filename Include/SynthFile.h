@@ -129,15 +129,103 @@ public:
 	int FileClose();
 };
 
+/// Read-only memory mapped file. The whole file is mapped
+/// into the address space and shared with any other process
+/// that maps the same file. This is used for the sample data
+/// of large soundbanks, which can then be read in place
+/// rather than copied into memory.
+class FileReadMap
+{
+private:
+	const bsUint8 *data;
+	size_t size;
+
+public:
+	FileReadMap();
+	~FileReadMap();
+
+	/// Map a file.
+	/// @param fname path name to the file
+	/// @return 0 on success, a negative value on errors
+	int FileOpen(const char *fname);
+
+	/// Unmap the file. Any pointers into the data become invalid.
+	int FileClose();
+
+	/// Get the mapped file contents.
+	/// @return pointer to the first byte or NULL if not mapped
+	const bsUint8 *FileData() { return data; }
+
+	/// Get the size of the mapped file.
+	/// @return size in bytes
+	size_t FileSize() { return size; }
+};
+
+/// Unbuffered file read at an explicit position. Reads do not
+/// use or change a shared file position, so several threads
+/// can read from one object at the same time.
+/// This is used to load soundbank samples in parallel.
+class FileReadAt
+{
+private:
+#if defined(WIN32)
+	HANDLE fh;
+#endif
+#if defined(UNIX)
+	int fd;
+#endif
+
+public:
+	FileReadAt();
+	~FileReadAt();
+
+	/// Open a file.
+	/// @param fname path name to the file
+	/// @return 0 on success, a negative value on errors
+	int FileOpen(const char *fname);
+
+	/// Read from the file. Up to \e rdsiz bytes are read
+	/// starting at byte offset \e pos.
+	/// @param rdbuf buffer for input
+	/// @param rdsiz number of bytes to read
+	/// @param pos file position in bytes
+	/// @return the number of bytes actually read or -1 on error.
+	int FileRead(void *rdbuf, int rdsiz, bsUint32 pos);
+
+	/// Close the file.
+	int FileClose();
+};
+
 /// Check for existence of a file or directory.
 /// @param fname full path to the file or directory.
 int SynthFileExists(const char *fname);
 
+/// Get the size and modification time of a file.
+/// The time is only useful to compare with another value from this function.
+/// @param fname full path to the file
+/// @param size returns file size in bytes
+/// @param modtime returns last modification time
+/// @return 0 on success, -1 if the file does not exist
+int SynthFileInfo(const char *fname, bsUint32& size, bsUint32& modtime);
+
 /// Copy a file
 /// @param oldName full path to existing file
 /// @param newName full path to copied file
 int SynthCopyFile(const char *oldName, const char *newName);
 
+/// Rename a file, replacing any file with the new name.
+/// On Unix, a process that has the old file open or mapped
+/// keeps the old content.
+/// @param oldName full path to existing file
+/// @param newName full path to new name
+/// @return 0 on success, -1 on error
+int SynthRenameFile(const char *oldName, const char *newName);
+
+/// Delete a file
+/// @param fname full path to the file
+/// @return 0 on success, -1 on error
+int SynthDeleteFile(const char *fname);
+
 /// Create a file
 /// @param fname full path to new file
 /// @param data optional initial content
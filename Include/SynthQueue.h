@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////
+/// @file SynthQueue.h Bounded lock-free queues.
+//
+// Copyright 2010 Daniel R. Mitchell, All Rights Reserved
+// License: Creative Commons/GNU-GPL 
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+///////////////////////////////////////////////////////////
+/// @addtogroup grpGeneral
+///@{
+#if !defined(_SYNTHQUEUE_H)
+#define _SYNTHQUEUE_H
+
+/// @brief Single producer, single consumer queue.
+/// @details This is a fixed size ring buffer that can be
+/// written by one thread and read by another without locking.
+/// Only one thread may call Put() and only one thread may
+/// call Get(). The size is rounded up to a power of two.
+/// Requires SynthThread.h for the memory barrier.
+template<class T> class SynthQueueSPSC
+{
+private:
+	T *items;
+	long mask;
+	volatile long head;
+	volatile long tail;
+
+public:
+	SynthQueueSPSC(long n = 1024)
+	{
+		long size = 1;
+		while (size < n)
+			size <<= 1;
+		items = new T[size];
+		mask = size - 1;
+		head = 0;
+		tail = 0;
+	}
+
+	~SynthQueueSPSC()
+	{
+		delete[] items;
+	}
+
+	/// @brief Add an item to the queue (producer).
+	/// @param val item to add
+	/// @return 1 if added, 0 if the queue is full
+	int Put(T val)
+	{
+		long t = tail;
+		if (t - head > mask)
+			return 0;
+		items[t & mask] = val;
+		SynthThread::MemoryFence();
+		tail = t + 1;
+		return 1;
+	}
+
+	/// @brief Remove an item from the queue (consumer).
+	/// @param val receives the item
+	/// @return 1 if an item was removed, 0 if the queue is empty
+	int Get(T& val)
+	{
+		long h = head;
+		if (h == tail)
+			return 0;
+		SynthThread::MemoryFence();
+		val = items[h & mask];
+		SynthThread::MemoryFence();
+		head = h + 1;
+		return 1;
+	}
+
+	/// @brief Test for an empty queue.
+	int Empty()
+	{
+		return head == tail;
+	}
+};
+
+/// @brief Multiple producer, single consumer queue.
+/// @details This is a fixed size ring buffer that can be
+/// written by any number of threads and read by one thread
+/// without locking. Each slot carries a sequence number
+/// so that a producer can claim a slot with a single
+/// compare-and-swap and the consumer can tell when the
+/// slot has been filled. The size is rounded up to a power of two.
+/// Requires SynthThread.h for the atomic operations.
+template<class T> class SynthQueueMPSC
+{
+private:
+	struct Slot
+	{
+		volatile long seq;
+		T val;
+	};
+	Slot *slots;
+	long mask;
+	long head;
+	volatile long tail;
+
+public:
+	SynthQueueMPSC(long n = 1024)
+	{
+		long size = 1;
+		while (size < n)
+			size <<= 1;
+		slots = new Slot[size];
+		for (long i = 0; i < size; i++)
+			slots[i].seq = i;
+		mask = size - 1;
+		head = 0;
+		tail = 0;
+	}
+
+	~SynthQueueMPSC()
+	{
+		delete[] slots;
+	}
+
+	/// @brief Add an item to the queue (any producer).
+	/// @param val item to add
+	/// @return 1 if added, 0 if the queue is full
+	int Put(T val)
+	{
+		for (;;)
+		{
+			long t = tail;
+			Slot *sp = &slots[t & mask];
+			long d = sp->seq - t;
+			if (d == 0)
+			{
+				if (SynthThread::AtomicCAS(&tail, t, t + 1) == t)
+				{
+					sp->val = val;
+					SynthThread::MemoryFence();
+					sp->seq = t + 1;
+					return 1;
+				}
+			}
+			else if (d < 0)
+				return 0;
+		}
+	}
+
+	/// @brief Remove an item from the queue (consumer).
+	/// @param val receives the item
+	/// @return 1 if an item was removed, 0 if the queue is empty
+	int Get(T& val)
+	{
+		Slot *sp = &slots[head & mask];
+		if (sp->seq != head + 1)
+			return 0;
+		SynthThread::MemoryFence();
+		val = sp->val;
+		SynthThread::MemoryFence();
+		sp->seq = head + mask + 1;
+		head++;
+		return 1;
+	}
+};
+
+#endif
+///@}
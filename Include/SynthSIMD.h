@@ -0,0 +1,226 @@
+/////////////////////////////////////////////////////
+/// @file SynthSIMD.h Vector (SIMD) kernels for block processing
+//
+// Copyright 2010 Daniel R. Mitchell, All Rights Reserved
+// License: Creative Commons/GNU-GPL 
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////
+/// @addtogroup grpGeneral
+///@{
+#ifndef _SYNTHSIMD_H
+#define _SYNTHSIMD_H
+
+/// Scalar code only
+#define SIMD_NONE 0
+/// SSE2 instructions
+#define SIMD_SSE2 1
+/// AVX2 instructions
+#define SIMD_AVX2 2
+
+/// Number of samples generators process at once
+/// when building index arrays for the kernels.
+#define SIMD_BLKSIZE 64
+
+/// Number of voices (lanes) processed together by SynthSIMD::PhaseMod3.
+#define SIMD_LANES 8
+
+/// @name PhaseMod3 routing flags
+///@{
+#define SIMD_PM_21   1 ///< oscillator 2 modulates oscillator 1
+#define SIMD_PM_31   2 ///< oscillator 3 modulates oscillator 1
+#define SIMD_PM_32   4 ///< oscillator 3 modulates oscillator 2
+#define SIMD_PM_ADD2 8 ///< oscillator 2 is added to the output of oscillator 1
+///@}
+
+/// Oscillator state for SynthSIMD::PhaseMod3.
+/// Each array holds one value for each lane.
+struct SynthPM3Lanes
+{
+	PhsAccum index[3][SIMD_LANES];     ///< wavetable index
+	PhsAccum incr[3][SIMD_LANES];      ///< index increment
+	const AmpValue *wt[3][SIMD_LANES]; ///< wavetable
+	AmpValue mult[3][SIMD_LANES];      ///< multiplier for the phase input
+};
+
+/// Vector kernels for block processing.
+/// The kernels operate on arrays of samples and are selected
+/// at run-time based on what the processor supports. The
+/// scalar versions are always available and are used on
+/// processors without SSE2/AVX2 or when the level is forced
+/// to SIMD_NONE (useful for A/B comparison).
+///
+/// The kernels do not change the order of floating point
+/// operations and thus produce the same values as the
+/// equivalent per-sample code. The one exception is when
+/// the compiler is allowed to contract multiply-add into
+/// FMA instructions (e.g., -march with FMA and -ffp-contract=fast).
+/// The scalar code may then round differently, typically by
+/// one unit in the last place.
+///
+/// A single global instance, \ref synthSIMD, is defined in the library.
+class SynthSIMD
+{
+private:
+	int level;
+
+public:
+	/// Wavetable lookup.
+	/// @code
+	/// dst[i] = wt[ndx[i]]
+	/// @endcode
+	/// @param dst output samples
+	/// @param wt wavetable
+	/// @param ndx table indexes
+	/// @param n number of samples
+	void (*Lookup)(AmpValue *dst, const AmpValue *wt, const bsInt32 *ndx, int n);
+
+	/// Interpolated wavetable lookup, calculated in double precision.
+	/// @code
+	/// dst[i] = wt[ndx[i]] + ((wt[ndx[i]+1] - wt[ndx[i]]) * fr[i])
+	/// @endcode
+	/// @param dst output samples
+	/// @param wt wavetable (with guard point)
+	/// @param ndx table indexes (integer part)
+	/// @param fr fractional part of indexes
+	/// @param n number of samples
+	void (*LookupI)(AmpValue *dst, const AmpValue *wt, const bsInt32 *ndx, const PhsAccum *fr, int n);
+
+	/// Wavetable lookup with a fixed point (Q16.16) index.
+	/// The index is rounded to the nearest table entry, then
+	/// incremented and masked after each sample.
+	/// @param dst output samples
+	/// @param wt wavetable (with guard point)
+	/// @param ndx starting index
+	/// @param incr index increment
+	/// @param mask index mask
+	/// @param n number of samples
+	/// @return updated index
+	bsInt32 (*Lookup32)(AmpValue *dst, const AmpValue *wt, bsInt32 ndx, bsInt32 incr, bsInt32 mask, int n);
+
+	/// Multiply by a gain.
+	/// @code
+	/// dst[i] = src[i] * g
+	/// @endcode
+	/// @param dst output samples (may be the same as src)
+	/// @param src input samples
+	/// @param g gain
+	/// @param n number of samples
+	void (*Mul)(AmpValue *dst, const AmpValue *src, AmpValue g, int n);
+
+	/// Multiply by a gain and accumulate.
+	/// @code
+	/// dst[i] += src[i] * g
+	/// @endcode
+	/// @param dst accumulated samples
+	/// @param src input samples
+	/// @param g gain
+	/// @param n number of samples
+	void (*MulAdd)(AmpValue *dst, const AmpValue *src, AmpValue g, int n);
+
+	/// Add two signals and multiply by a gain.
+	/// @code
+	/// dst[i] = (a[i] + b[i]) * g
+	/// @endcode
+	/// @param dst output samples
+	/// @param a first input
+	/// @param b second input
+	/// @param g gain
+	/// @param n number of samples
+	void (*AddMul)(AmpValue *dst, const AmpValue *a, const AmpValue *b, AmpValue g, int n);
+
+	/// Recirculating delay (comb filter) over a run of the delay buffer.
+	/// The run must not wrap and must be no longer than the delay,
+	/// so that each buffer value is read once before it is replaced.
+	/// @code
+	/// dst[i] = buf[i] * g; buf[i] = in[i] + dst[i]
+	/// @endcode
+	/// @param dst output samples (may be the same as in)
+	/// @param buf delay buffer at the current position
+	/// @param in input samples
+	/// @param g decay factor
+	/// @param n number of samples
+	void (*Comb)(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n);
+
+	/// Recirculating delay with the output added to dst.
+	/// Restrictions are the same as Comb.
+	/// @code
+	/// t = buf[i] * g; buf[i] = in[i] + t; dst[i] += t
+	/// @endcode
+	/// @param dst accumulated samples
+	/// @param buf delay buffer at the current position
+	/// @param in input samples
+	/// @param g decay factor
+	/// @param n number of samples
+	void (*CombAdd)(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n);
+
+	/// All-pass delay over a run of the delay buffer.
+	/// Restrictions are the same as Comb.
+	/// @code
+	/// vm = buf[i]; vn = in[i] - vm * g; buf[i] = vn; dst[i] = vm + vn * g
+	/// @endcode
+	/// @param dst output samples (may be the same as in)
+	/// @param buf delay buffer at the current position
+	/// @param in input samples
+	/// @param g all-pass coefficient
+	/// @param n number of samples
+	void (*AllPass)(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n);
+
+	/// Convert 16-bit PCM to sample values in the range [-1,+1).
+	/// When lsb is not NULL, it holds the low byte of SF2 24-bit samples.
+	/// The conversion is exact; results match the scalar code.
+	/// @code
+	/// dst[i] = src[i] / 32768.0
+	/// dst[i] = ((src[i] * 256) + lsb[i]) / 8388608.0
+	/// @endcode
+	/// @param dst output samples
+	/// @param src 16-bit samples in native byte order
+	/// @param lsb 24-bit low byte, or NULL
+	/// @param n number of samples
+	void (*Pcm16)(AmpValue *dst, const bsInt16 *src, const bsUint8 *lsb, int n);
+
+	/// Three oscillator phase modulation for SIMD_LANES voices at once.
+	/// Each lane is a separate voice with its own wavetables and phase.
+	/// For each sample, the oscillators are calculated the same as
+	/// GenWaveWT::Gen() followed by GenWaveWT::PhaseModWT().
+	/// The modulators are selected by the route flags.
+	/// The AVX2 version gathers the table values for all lanes with one
+	/// instruction. There is no SSE2 version, since without gather it
+	/// is no faster than calculating each voice separately.
+	/// @code
+	/// out[k] = wt[k][index[k]] * amp[i][k]; index[k] += incr[k]
+	/// mod[k] = phs[i] * mult[k] + (modulators of k)
+	/// index[k] += mod[k]
+	/// dst[i] = out[0] (+ out[1])
+	/// @endcode
+	/// @param dst output of oscillator 1, SIMD_LANES values for each sample
+	/// @param st oscillator state, updated on return
+	/// @param amp amplitude, 3 * SIMD_LANES values for each sample
+	/// @param phs phase (index) modulation, SIMD_LANES values for each sample
+	/// @param route combination of SIMD_PM_* flags
+	/// @param n number of samples
+	void (*PhaseMod3)(AmpValue *dst, SynthPM3Lanes *st, const AmpValue *amp, const AmpValue *phs, int route, int n);
+
+	SynthSIMD();
+
+	/// Determine the best instruction set supported by the processor.
+	/// @return SIMD_NONE, SIMD_SSE2 or SIMD_AVX2
+	static int Detect();
+
+	/// Select the kernels. The level is limited to
+	/// what the processor supports.
+	/// @param lvl requested level
+	/// @return level actually selected
+	int SetLevel(int lvl);
+
+	/// Get the current level.
+	/// @return SIMD_NONE, SIMD_SSE2 or SIMD_AVX2
+	int GetLevel()
+	{
+		return level;
+	}
+};
+
+extern SynthSIMD synthSIMD;
+///@}
+#endif
@@ -56,6 +56,37 @@ public:
 	/// @brief Delay minimum amount.
 	/// @details Used for spin locks.
 	virtual void ShortWait();
+
+	/// @brief Give up the remainder of the time slice.
+	/// @details Used for spin loops that must respond
+	/// faster than ShortWait() allows.
+	static void YieldThread();
+
+	/// @brief Atomic add.
+	/// @details This also acts as a full memory barrier.
+	/// Adding 0 can be used to read a value written by another thread.
+	/// @param val value to modify
+	/// @param n amount to add
+	/// @return the new value
+	static long AtomicAdd(volatile long *val, long n);
+
+	/// @brief Atomic compare and swap.
+	/// @details If *val equals cmp, n is stored into *val.
+	/// This also acts as a full memory barrier.
+	/// @param val value to modify
+	/// @param cmp expected value
+	/// @param n new value
+	/// @return the prior value of *val
+	static long AtomicCAS(volatile long *val, long cmp, long n);
+
+	/// @brief Full memory barrier.
+	/// @details Orders memory access between threads
+	/// that share data without a lock.
+	static void MemoryFence();
+
+	/// @brief Number of CPUs available.
+	/// @return number of online processors, at least 1
+	static int CPUCount();
 };
 
 #endif
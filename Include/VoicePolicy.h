@@ -0,0 +1,160 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file VoicePolicy.h Voice allocation policy for the sequencer.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+/// @addtogroup grpSeq
+//@{
+
+#ifndef VOICEPOLICY_H
+#define VOICEPOLICY_H
+
+/// Number of channels with their own limit and priority.
+#define VOICE_CHANNELS 16
+
+/// Prefer notes in release.
+#define VOICE_STEAL_RELEASE 0x01
+/// Prefer the note with the lowest level (Instrument::GetLevel()).
+#define VOICE_STEAL_LEVEL   0x02
+/// Prefer a note in the same exclusive group as the new note.
+#define VOICE_STEAL_EXCL    0x04
+
+/// @brief Voice allocation policy.
+/// @details The policy limits the number of active notes, both in
+/// total and for each channel, and chooses which note to remove when
+/// a new note would exceed a limit. Candidates are compared in order by:
+/// - exclusive group: a note in the same group as the new note has
+/// already been cancelled by it (VOICE_STEAL_EXCL)
+/// - channel priority: lower priority channels lose notes first
+/// - release: notes in release before notes still sounding (VOICE_STEAL_RELEASE)
+/// - level: the quietest note (VOICE_STEAL_LEVEL)
+/// - age: the oldest note
+///
+/// When a channel is over its own limit, only notes on that channel
+/// are considered. The defaults (VOICE_STEAL_RELEASE, no channel limits)
+/// are the same as the sequencer without a policy.
+///
+/// The total limit can also be set by render time. With a time budget,
+/// the sequencer times the voice rendering for each block and the limit
+/// is lowered to the number of voices that fit within that fraction of
+/// real time. The limit drops immediately when the cost rises and
+/// recovers one voice per block. Notes are only removed when a new
+/// note starts, so a lower limit does not cut notes already sounding.
+/// In block mode the time is exact; otherwise
+/// it is taken from the first sample of each block. Mixer and effects
+/// processing are not included, so the budget should leave room for them.
+/// A budget should only be set for live playback.
+class VoicePolicy : public SeqVoicePolicy
+{
+private:
+	bsInt32 maxVoices;
+	bsInt32 minVoices;
+	bsInt32 cpuLimit;
+	bsInt32 stolen;
+	int steal;
+	double budget;
+	double voiceCost;
+	double renderStart;
+	bsInt32 chnlLimit[VOICE_CHANNELS];
+	int chnlPri[VOICE_CHANNELS];
+
+	int Priority(int chnl)
+	{
+		if (chnl >= 0 && chnl < VOICE_CHANNELS)
+			return chnlPri[chnl];
+		return 0;
+	}
+
+public:
+	VoicePolicy();
+
+	/// Set the maximum number of active notes.
+	/// @param n maximum notes
+	void SetMaxVoices(bsInt32 n)
+	{
+		maxVoices = n;
+		cpuLimit = n;
+	}
+
+	/// Get the maximum number of active notes.
+	bsInt32 GetMaxVoices()
+	{
+		return maxVoices;
+	}
+
+	/// Set the smallest limit the time budget may impose.
+	/// @param n minimum notes
+	void SetMinVoices(bsInt32 n)
+	{
+		minVoices = n;
+	}
+
+	/// Set how notes are chosen for removal.
+	/// @param flags combination of VOICE_STEAL_* values
+	void SetSteal(int flags)
+	{
+		steal = flags;
+	}
+
+	/// Limit the active notes on one channel.
+	/// @param chnl channel number (0-15)
+	/// @param n maximum notes, 0 for no limit
+	void SetChannelLimit(int chnl, bsInt32 n)
+	{
+		if (chnl >= 0 && chnl < VOICE_CHANNELS)
+			chnlLimit[chnl] = n;
+	}
+
+	/// Set the priority of one channel.
+	/// Notes on channels with lower priority are removed first.
+	/// All channels default to 0.
+	/// @param chnl channel number (0-15)
+	/// @param pri priority
+	void SetChannelPriority(int chnl, int pri)
+	{
+		if (chnl >= 0 && chnl < VOICE_CHANNELS)
+			chnlPri[chnl] = pri;
+	}
+
+	/// Set the time budget.
+	/// @param frac fraction of real time for rendering voices, 0 for none
+	void SetTimeBudget(double frac)
+	{
+		budget = frac;
+		cpuLimit = maxVoices;
+	}
+
+	/// Get the current limit on active notes, including the time budget.
+	bsInt32 GetLimit()
+	{
+		return cpuLimit < maxVoices ? cpuLimit : maxVoices;
+	}
+
+	/// Get the number of notes removed since Reset().
+	bsInt32 GetStolen()
+	{
+		return stolen;
+	}
+
+	/// Get the measured render cost of one voice,
+	/// as a fraction of real time.
+	double GetVoiceCost()
+	{
+		return voiceCost * synthParams.sampleRate;
+	}
+
+	/// Clear the measurements and statistics.
+	void Reset();
+
+	virtual ActiveEvent *Select(ActiveEvent *head, ActiveEvent *tail, ActiveEvent *act, bsInt32 count);
+	virtual int Timed();
+	virtual void StartRender();
+	virtual void EndRender(bsInt32 frames, bsInt32 voices);
+};
+//@}
+#endif
@@ -108,6 +108,10 @@ SOURCE=.\PreComp.cpp
 
 SOURCE=.\BSynth.h
 # End Source File
+# Begin Source File
+
+SOURCE=.\SynthProject.h
+# End Source File
 # End Group
 # Begin Group "Resource Files"
 
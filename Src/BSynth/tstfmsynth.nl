@@ -21,7 +21,7 @@ begin
 	'LFO frequency, wavetable, attack, level
 	map "Test" 90, 91, 92, 93;
 	{C4, C4, C4, C4, C4, C4, C4}, %4, 100, 
-	{ 2.0, 2.5, 3.0 3.5, 4.0 4.5, 5.0},
+	{ 2.0, 2.5, 3.0, 3.5, 4.0, 4.5, 5.0},
 	{ 0, 0, 1, 1, 2, 2, 0},
 	{ 0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6},
 	{ 0.05, 0.10, 0.2, 0.3, 0.4, 0.5, 0.8};
@@ -0,0 +1,325 @@
+/////////////////////////////////////////////////////////////////////////
+// BasicSynth - Soundbank sample storage benchmark
+//
+// Loads a soundbank (SF2 or DLS) with all samples preloaded, once
+// with samples converted to float and once with 16-bit and 24-bit
+// samples kept in native format, then plays voices on every
+// zone in the bank with the soundbank oscillator.
+//
+// For each storage format the output contains the bytes of sample
+// data in memory, the load time, the time per sample for each voice
+// and the number of voices one core can play in real time.
+// Both formats must produce the same output.
+//
+// The time to build the soundbank from the file and from the
+// cache (SoundBankCache) is also shown, without loading samples.
+// This writes the cache file for the soundbank.
+//
+// The sample preload time is shown for one thread and for the
+// number of threads given with -t (default 4). The elapsed time
+// is taken from the preload progress callback.
+//
+// use: BankBench [-d seconds] [-v voices] [-t threads] [-o file] soundbank
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL 
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "BasicSynth.h"
+#include <SFFile.h>
+#include <DLSFile.h>
+#include <SoundBankCache.h>
+#include <SFGen.h>
+#include "BenchTimer.h"
+
+class BankResult
+{
+public:
+	const char *error;
+	double loadSec;
+	double renderSec;
+	double voiceFrames;
+	double checksum;
+	bsUint32 bytes;
+	long samples;
+	long zones;
+
+	BankResult()
+	{
+		error = 0;
+		loadSec = 0;
+		renderSec = 0;
+		voiceFrames = 0;
+		checksum = 0;
+		bytes = 0;
+		samples = 0;
+		zones = 0;
+	}
+};
+
+static SoundBank *LoadBank(const char *fname, int pre)
+{
+	if (SFFile::IsSF2File(fname))
+	{
+		SFFile sf;
+		return sf.LoadSoundBank(fname, pre);
+	}
+	if (DLSFile::IsDLSFile(fname))
+	{
+		DLSFile dls;
+		return dls.LoadSoundBank(fname, pre);
+	}
+	return 0;
+}
+
+/// Time building the soundbank from the file and from the cache.
+static int TimeCache(const char *fname, double& parseSec, double& cacheSec)
+{
+	double t0 = BenchTime();
+	SoundBank *bnk = LoadBank(fname, 0);
+	double t1 = BenchTime();
+	if (bnk == 0)
+		return -1;
+	parseSec = t1 - t0;
+
+	bsString cname;
+	SoundBankCache::CacheName(fname, cname);
+	int err = SoundBankCache::WriteCache(bnk, cname, fname);
+	delete bnk;
+	if (err)
+		return -1;
+
+	t0 = BenchTime();
+	bnk = SoundBankCache::ReadCache(cname, fname, 0);
+	t1 = BenchTime();
+	if (bnk == 0)
+		return -1;
+	cacheSec = t1 - t0;
+	delete bnk;
+	return 0;
+}
+
+static void PreloadProgress(bsInt32 done, bsInt32 total, double secs, Opaque usr)
+{
+	if (done == total)
+		*(double *) usr = secs;
+}
+
+/// Time loading all samples with the given number of threads.
+static int TimePreload(const char *fname, int threads, double& preloadSec)
+{
+	SoundBank *bnk = LoadBank(fname, 0);
+	if (bnk == 0)
+		return -1;
+	int err = bnk->PreloadSamples(threads, PreloadProgress, (Opaque) &preloadSec);
+	delete bnk;
+	return err;
+}
+
+/// Make a list of all zones in the bank.
+static SBZone **ListZones(SoundBank *bnk, long& count)
+{
+	count = 0;
+	SBZone **list = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		long n = 0;
+		for (int bank = 0; bank <= 128; bank++)
+		{
+			for (int prog = 0; prog < 128; prog++)
+			{
+				SBInstr *in = bnk->GetInstr(bank, prog, pass == 0);
+				if (in == 0 || (bank > 0 && bank < 128 && in->bank != bank))
+					continue; // GetInstr falls back to bank 0
+				SBZone *zone = 0;
+				while ((zone = in->EnumZones(zone)) != 0)
+				{
+					if (zone->sample && zone->tableEnd > zone->tableStart)
+					{
+						if (list)
+							list[n] = zone;
+						n++;
+					}
+				}
+			}
+		}
+		if (pass == 0)
+			list = new SBZone*[n > 0 ? n : 1];
+		count = n;
+	}
+	return list;
+}
+
+/// Start a voice on the next zone, at a pitch from one octave
+/// below to one octave above the recorded pitch.
+static void StartVoice(GenWaveSB& osc, SBZone *zone, long n)
+{
+	double ratio = pow(2.0, (double) ((n * 7) % 25 - 12) / 12.0);
+	osc.InitSB(zone, (zone->rate / synthParams.sampleRate) * ratio);
+}
+
+/// Load the bank and play all zones.
+static void RunBank(const char *fname, int native, int voices, FrqValue duration, BankResult& res)
+{
+	SoundBank::nativeSamples = native;
+
+	double t0 = BenchTime();
+	SoundBank *bnk = LoadBank(fname, 1);
+	double t1 = BenchTime();
+	if (bnk == 0)
+	{
+		res.error = "cannot load soundbank";
+		return;
+	}
+	bnk->Lock();
+	res.loadSec = t1 - t0;
+
+	SBSample *samp;
+	for (samp = bnk->samples; samp; samp = samp->next)
+	{
+		res.bytes += samp->MemSize();
+		res.samples++;
+	}
+
+	SBZone **zones = ListZones(bnk, res.zones);
+	if (res.zones == 0)
+	{
+		res.error = "no zones";
+		delete zones;
+		bnk->Unlock();
+		return;
+	}
+
+	GenWaveSB *osc = new GenWaveSB[voices];
+	long next = 0;
+	int v;
+	for (v = 0; v < voices; v++, next++)
+		StartVoice(osc[v], zones[next % res.zones], next);
+
+	long totalSamples = (long) (duration * synthParams.sampleRate);
+	double sum = 0;
+	double t2 = BenchTime();
+	for (long n = 0; n < totalSamples; n++)
+	{
+		AmpValue out = 0;
+		for (v = 0; v < voices; v++)
+		{
+			out += osc[v].Gen();
+			if (osc[v].IsFinished())
+			{
+				StartVoice(osc[v], zones[next % res.zones], next);
+				next++;
+			}
+		}
+		sum += out;
+	}
+	double t3 = BenchTime();
+	res.renderSec = t3 - t2;
+	res.voiceFrames = (double) totalSamples * (double) voices;
+	res.checksum = sum;
+
+	delete[] osc;
+	delete zones;
+	bnk->Unlock();
+}
+
+int main(int argc, char *argv[])
+{
+	FrqValue duration = 10.0;
+	int voices = 32;
+	int threads = 4;
+	const char *outFile = 0;
+
+	int argn = 1;
+	while (argn < argc && argv[argn][0] == '-')
+	{
+		if (strcmp(argv[argn], "-d") == 0 && argn+1 < argc)
+			duration = atof(argv[++argn]);
+		else if (strcmp(argv[argn], "-v") == 0 && argn+1 < argc)
+			voices = atoi(argv[++argn]);
+		else if (strcmp(argv[argn], "-t") == 0 && argn+1 < argc)
+			threads = atoi(argv[++argn]);
+		else if (strcmp(argv[argn], "-o") == 0 && argn+1 < argc)
+			outFile = argv[++argn];
+		else
+			break;
+		argn++;
+	}
+	if (argn != argc-1)
+	{
+		fprintf(stderr, "use: BankBench [-d seconds] [-v voices] [-t threads] [-o file] soundbank\n");
+		return 1;
+	}
+	if (voices < 1)
+		voices = 1;
+	if (threads < 1)
+		threads = 1;
+	const char *bankFile = argv[argn];
+
+	InitSynthesizer();
+
+	FILE *fp = stdout;
+	if (outFile && (fp = fopen(outFile, "w")) == NULL)
+	{
+		fprintf(stderr, "Cannot open %s\n", outFile);
+		return 1;
+	}
+
+	static const char *formats[] = { "float", "native" };
+	BankResult res[2];
+	int errors = 0;
+	fprintf(fp, "{\n  \"voices\": %d,\n", voices);
+	double parseSec = 0;
+	double cacheSec = 0;
+	if (TimeCache(bankFile, parseSec, cacheSec) == 0)
+		fprintf(fp, "  \"parse_sec\": %.6f,\n  \"cache_sec\": %.6f,\n", parseSec, cacheSec);
+	else
+		errors++;
+	double preloadSec1 = 0;
+	double preloadSecN = 0;
+	if (TimePreload(bankFile, 1, preloadSec1) == 0
+	 && TimePreload(bankFile, threads, preloadSecN) == 0)
+		fprintf(fp, "  \"preload_threads\": %d,\n  \"preload_sec_1\": %.6f,\n  \"preload_sec_n\": %.6f,\n",
+			threads, preloadSec1, preloadSecN);
+	else
+		errors++;
+	SoundBank::preloadThreads = threads;
+	fprintf(fp, "  \"results\": [");
+	for (int native = 0; native < 2; native++)
+	{
+		fprintf(stderr, "%s %s\n", bankFile, formats[native]);
+		RunBank(bankFile, native, voices, duration, res[native]);
+		fprintf(fp, "%s\n    { \"storage\": \"%s\"", native ? "," : "", formats[native]);
+		if (res[native].error)
+		{
+			errors++;
+			fprintf(fp, ", \"error\": \"%s\"", res[native].error);
+		}
+		else
+		{
+			double nsv = (res[native].renderSec * 1.0e9) / res[native].voiceFrames;
+			double vpc = nsv > 0 ? 1.0e9 / (nsv * synthParams.sampleRate) : 0;
+			fprintf(fp, ", \"samples\": %ld, \"zones\": %ld, \"sample_bytes\": %lu, \"load_sec\": %.6f,",
+				res[native].samples, res[native].zones, (unsigned long) res[native].bytes, res[native].loadSec);
+			fprintf(fp, " \"ns_per_sample_voice\": %.2f, \"voices_per_core\": %.0f",
+				nsv, vpc);
+		}
+		fprintf(fp, " }");
+	}
+	fprintf(fp, "\n  ]\n}\n");
+	if (fp != stdout)
+		fclose(fp);
+
+	if (errors == 0 && res[0].checksum != res[1].checksum)
+	{
+		fprintf(stderr, "output differs!\n");
+		errors++;
+	}
+	return errors ? 1 : 0;
+}
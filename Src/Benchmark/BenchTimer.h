@@ -0,0 +1,35 @@
+/////////////////////////////////////////////////////////////////////////
+// BasicSynth - Benchmark timer
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL 
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////////////
+#ifndef _BENCHTIMER_H
+#define _BENCHTIMER_H
+
+#if _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/// Return a monotonic wall clock time in seconds.
+/// Only the difference between two values is meaningful.
+inline double BenchTime()
+{
+#if _WIN32
+	LARGE_INTEGER frq;
+	LARGE_INTEGER cnt;
+	QueryPerformanceFrequency(&frq);
+	QueryPerformanceCounter(&cnt);
+	return (double) cnt.QuadPart / (double) frq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + ((double) ts.tv_nsec * 1.0e-9);
+#endif
+}
+
+#endif
@@ -0,0 +1,391 @@
+/////////////////////////////////////////////////////////////////////////
+// BasicSynth - Control rate check
+//
+// Checks the control rate ramps (GenCtl) that AddSynth, MatrixSynth
+// and GMPlayer use for their modulators.
+//
+// First, each modulation source is set up the way the instrument
+// sets it up for a control rate of 1 and run through GenCtl. The
+// values must be exactly the same as the values the source produces
+// when it is called on every sample without a control rate, i.e.,
+// the audio rate path the instruments used before GenCtl.
+//
+// Then the instruments are rendered at control rates of 1, 16 and 32.
+// The 16 and 32 renders are compared to the rate 1 render and the
+// signal to noise ratio must be at least the minimum (-m, default
+// 40dB). The LFO depth in the test projects is raised to one semitone
+// so that the ramps are heard. For GMPlayer the control rate also
+// sets the filter update rate. GMPlayer needs a GM soundbank, and is
+// skipped when none is given.
+//
+// use: CtlRateCheck [-m minSNR] [soundbank]
+//
+// Run this from the Src/BSynth directory so that the score
+// files in the projects are found.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////////////
+#include "BSynth.h"
+#include <SFFile.h>
+#include <DLSFile.h>
+#include <SoundBankCache.h>
+#include "SynthProject.h"
+
+/// Output that keeps all of the samples.
+/// The buffer doubles in size each time it is full.
+class CheckWaveOut : public WaveOutBuf
+{
+public:
+	virtual int FlushOutput()
+	{
+		SampleValue *buf = new SampleValue[sampleMax * 2];
+		memcpy(buf, samples, sampleMax * sizeof(SampleValue));
+		delete[] samples;
+		samples = buf;
+		nxtSamp = samples + sampleMax;
+		sampleMax *= 2;
+		endSamp = samples + sampleMax;
+		return 0;
+	}
+
+	/// Number of values (all channels) output.
+	long Count()
+	{
+		return (long) sampleTotal;
+	}
+};
+
+#define CHECK_SAMPLES 441000
+
+/// Run a source on every sample, then a second copy through
+/// GenCtl at a rate of 1.
+/// @return number of values that differ
+template<class G> static long CheckSource(G& ref, G& src)
+{
+	GenCtl ctl;
+	ctl.Init(1);
+	ctl.Start(src);
+	long diffs = 0;
+	for (long n = 0; n < CHECK_SAMPLES; n++)
+	{
+		AmpValue v1 = ref.Gen();
+		AmpValue v2 = ctl.Gen(src);
+		if (v1 != v2)
+			diffs++;
+	}
+	return diffs;
+}
+
+// The Init functions set up each source the same way as
+// the instrument. A rate of 0 leaves the control rate unset.
+
+/// LFO as started by AddSynth and MatrixSynth
+static void InitLFO(LFO& lfo, bsInt32 rate)
+{
+	lfo.SetFrequency(3.5);
+	lfo.SetWavetable(WT_SIN);
+	lfo.SetAttack(0.2);
+	lfo.SetLevel(1.0);
+	lfo.SetSigFrq(440.0);
+	if (rate > 0)
+		lfo.SetCtlRate(rate);
+	lfo.Reset(0);
+}
+
+/// PitchBend as started by MatrixSynth
+static void InitPitchBend(PitchBend& pb, bsInt32 rate)
+{
+	pb.SetFrequency(440.0);
+	pb.SetAmount(0, -2.0);
+	pb.SetRate(0, 0.3);
+	pb.SetAmount(1, 0.5);
+	pb.SetRate(1, 2.0);
+	pb.SetAmount(2, 0.0);
+	if (rate > 0)
+		pb.SetCtlRate(rate);
+	pb.Reset(0);
+}
+
+/// PitchBendWT as started by MatrixSynth
+static void InitPitchBendWT(PitchBendWT& pb, bsInt32 rate)
+{
+	pb.SetLevel(1.0);
+	pb.SetWavetable(WT_TRI);
+	pb.SetDuration(0.8);
+	pb.SetDelay(0.1);
+	pb.SetMode(0);
+	pb.SetSigFrq(440.0);
+	pb.SetDurationS(CHECK_SAMPLES / 2);
+	if (rate > 0)
+		pb.SetCtlRate(rate);
+	pb.Reset(0);
+}
+
+/// Modulation envelope (EG2) as started by GMPlayer
+static void InitEnvSB(EnvGenSB& eg, bsInt32 rate)
+{
+	FrqValue ctlTime = 1.0;
+	if (rate > 0)
+		ctlTime = 1.0 / (FrqValue) rate;
+	eg.SetDelay(0.05 * ctlTime);
+	eg.SetAttack(0.3 * ctlTime);
+	eg.SetHold(0.1 * ctlTime);
+	eg.SetDecay(1.5 * ctlTime);
+	eg.SetSustain(0.4);
+	eg.SetRelease(0.5 * ctlTime);
+	eg.Reset(0);
+}
+
+/// Vibrato and modulator LFO as started by GMPlayer
+static void InitWaveWT(GenWaveWT& wv, bsInt32 rate)
+{
+	wv.InitWT(5.5, WT_SIN);
+	if (rate > 1)
+		wv.Modulate(5.5 * (FrqValue) (rate - 1));
+}
+
+/// Check one source at a rate of 1.
+/// @return 1 if the values differ, 0 if they are the same
+template<class G> static int CheckRate1(const char *name, void (*init)(G&, bsInt32))
+{
+	G ref;
+	G src;
+	init(ref, 0);
+	init(src, 1);
+	long diffs = CheckSource(ref, src);
+	if (diffs)
+		printf("%-24s rate 1  %ld values differ from the audio rate\n", name, diffs);
+	else
+		printf("%-24s rate 1  same\n", name);
+	return diffs ? 1 : 0;
+}
+
+/// Raise the LFO depth on all instruments of a type.
+static void RaiseLFO(InstrManager& mgr, const char *type)
+{
+	InstrConfig *ic = 0;
+	while ((ic = mgr.EnumInstr(ic)) != 0)
+	{
+		if (ic->instrType && ic->instrTmplt
+		 && strcmp(ic->instrType->GetType(), type) == 0)
+		{
+			InstrumentVP *ip = (InstrumentVP *) ic->instrTmplt;
+			ip->SetParam(18, 0.2);  // LFO attack
+			ip->SetParam(19, 1.0);  // LFO depth, semitones
+		}
+	}
+}
+
+struct CheckInstr
+{
+	const char *type;
+	const char *prjFile;  ///< project, or 0 for GMPlayer
+};
+
+static CheckInstr instrs[] =
+{
+	{ "AddSynth", "tstaddsynth.xml" },
+	{ "MatrixSynth", "tstmatsynth.xml" },
+	{ "GMPlayer", 0 },
+	{ 0, 0 }
+};
+
+static SoundBank *gmBank = 0;
+
+// GM programs that usually have vibrato
+static bsInt16 gmProgs[] = { 0, 24, 40, 56, 73, -1 };
+
+/// Set up GMPlayer notes with the mod wheel all the way up.
+static int InitGMPlayer(SynthProject *prj)
+{
+	InstrMapEntry *ime = prj->mgr.FindType("GMPlayer");
+	if (ime == 0)
+		return -1;
+	prj->mix.SetChannels(1);
+	prj->mix.MasterVolume(1.0, 1.0);
+	prj->mix.ChannelOn(0, 1);
+	prj->mix.ChannelVolume(0, 0.5);
+	prj->mgr.ProcessMessage(MIDI_CTLCHG, MIDI_CTRL_MOD, 127);
+	bsInt32 start = 0;
+	bsInt16 inum;
+	for (inum = 0; gmProgs[inum] >= 0; inum++)
+	{
+		GMPlayer *gm = new GMPlayer;
+		gm->SetSoundBank(gmBank);
+		gm->SetParam(GMPLAYER_FLAGS, (float) (GMPLAYER_LOCAL_BANK|GMPLAYER_LOCAL_PROG|GMPLAYER_LOCAL_PAN|GMPLAYER_LOCAL_VOL));
+		gm->SetParam(GMPLAYER_BANK, 0);
+		gm->SetParam(GMPLAYER_PROG, (float) gmProgs[inum]);
+		InstrConfig *inc = prj->mgr.AddInstrument(inum, ime, gm);
+		int note;
+		for (note = 0; note < 3; note++)
+		{
+			VarParamEvent *evt = (VarParamEvent *) prj->mgr.ManufEvent(inc);
+			evt->type = SEQEVT_START;
+			evt->evid = (inum * 3) + note;
+			evt->chnl = 0;
+			evt->start = start;
+			evt->duration = synthParams.isampleRate;
+			evt->SetParam(P_PITCH, (float) (48 + (note * 7)));
+			evt->SetParam(P_VOLUME, 1.0);
+			evt->SetParam(P_NOTEONVEL, 100);
+			prj->seq.AddEvent(evt);
+			start += synthParams.isampleRate / 2;
+		}
+	}
+	prj->tail = 1.0;
+	return 0;
+}
+
+/// Render one instrument at a control rate.
+/// @return 0 on success, 1 for a missing file, -1 for an error
+static int RenderInstr(CheckInstr *cp, bsInt32 rate, CheckWaveOut& out)
+{
+	int err = 0;
+	synthParams.ctlRate = rate;
+	srand(1);
+	SynthProject *prj = new SynthProject;
+	prj->silent = 1;
+	prj->err.msgOut = stderr;
+	prj->Init();
+	if (cp->prjFile)
+	{
+		if (prj->LoadProject((char *) cp->prjFile) != 0)
+			err = prj->missing ? 1 : -1;
+		else if (prj->GenerateSequence() != 0)
+			err = -1;
+		else
+			RaiseLFO(prj->mgr, cp->type);
+	}
+	else if (gmBank == 0)
+		err = 1;
+	else
+		err = InitGMPlayer(prj);
+	if (err == 0)
+	{
+		out.AllocBuf(synthParams.isampleRate * 2, 2);
+		prj->wvp = &out;
+		prj->Render();
+		prj->wvp = &prj->wvf;
+	}
+	delete prj;
+	synthParams.ctlRate = 1;
+	return err;
+}
+
+/// Signal to noise ratio of a render against the reference,
+/// over the common length.
+/// @return SNR in dB, or -1 when there is no difference
+static double SNR(CheckWaveOut& ref, CheckWaveOut& out)
+{
+	long count = ref.Count() < out.Count() ? ref.Count() : out.Count();
+	const SampleValue *rp = ref.GetBuf();
+	const SampleValue *op = out.GetBuf();
+	double sig = 0;
+	double err = 0;
+	for (long n = 0; n < count; n++)
+	{
+		double d = (double) rp[n] - (double) op[n];
+		sig += (double) rp[n] * (double) rp[n];
+		err += d * d;
+	}
+	if (err == 0)
+		return -1;
+	if (sig == 0)
+		return 0;
+	return 10.0 * log10(sig / err);
+}
+
+static bsInt32 rates[] = { 16, 32, 0 };
+
+int main(int argc, char *argv[])
+{
+#if defined(USE_MSXML)
+	CoInitialize(0);
+#endif
+
+	double minSNR = 40.0;
+	const char *bankFile = 0;
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-m") == 0 && i+1 < argc)
+			minSNR = atof(argv[++i]);
+		else if (argv[i][0] == '-')
+		{
+			fprintf(stderr, "use: CtlRateCheck [-m minSNR] [soundbank]\n");
+			return 1;
+		}
+		else
+			bankFile = argv[i];
+	}
+
+	InitSynthesizer();
+	int errors = 0;
+	errors += CheckRate1<LFO>("LFO", InitLFO);
+	errors += CheckRate1<PitchBend>("PitchBend", InitPitchBend);
+	errors += CheckRate1<PitchBendWT>("PitchBendWT", InitPitchBendWT);
+	errors += CheckRate1<EnvGenSB>("GMPlayer EG2", InitEnvSB);
+	errors += CheckRate1<GenWaveWT>("GMPlayer LFO", InitWaveWT);
+
+	if (bankFile)
+	{
+		if (SFFile::IsSF2File(bankFile) || DLSFile::IsDLSFile(bankFile))
+			gmBank = SoundBankCache::LoadSoundBank(bankFile, 0);
+		if (gmBank == 0)
+		{
+			fprintf(stderr, "Cannot load SoundBank '%s'\n", bankFile);
+			errors++;
+		}
+		else
+		{
+			gmBank->Lock();
+			gmBank->name = bankFile;
+			SoundBank::SoundBankList.Insert(gmBank);
+		}
+	}
+
+	CheckInstr *cp;
+	for (cp = instrs; cp->type; cp++)
+	{
+		CheckWaveOut ref;
+		int err = RenderInstr(cp, 1, ref);
+		if (err)
+		{
+			printf("%-24s %s\n", cp->type, err > 0 ? "skipped" : "error");
+			if (err < 0)
+				errors++;
+			continue;
+		}
+		bsInt32 *rp;
+		for (rp = rates; *rp; rp++)
+		{
+			CheckWaveOut out;
+			if (RenderInstr(cp, *rp, out) != 0)
+			{
+				printf("%-24s rate %-2d error\n", cp->type, *rp);
+				errors++;
+				continue;
+			}
+			double snr = SNR(ref, out);
+			if (snr < 0)
+				printf("%-24s rate %-2d same\n", cp->type, *rp);
+			else
+			{
+				printf("%-24s rate %-2d SNR %.1f dB\n", cp->type, *rp, snr);
+				if (snr < minSNR)
+					errors++;
+			}
+		}
+	}
+
+	if (gmBank)
+		gmBank->Unlock();
+
+#if defined(USE_MSXML)
+	CoUninitialize();
+#endif
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,325 @@
+/////////////////////////////////////////////////////////////////////////
+// BasicSynth - Render benchmark
+//
+// Loads BSynth projects and renders each one to a null output
+// in one or more modes, then writes the timing as JSON.
+//
+// Modes:
+//  tick         - one call to Tick() per sample (default sequencer path)
+//  block        - block mode
+//  block-scalar - block mode with the SIMD kernels set to scalar code
+//  threads-N    - block mode with N rendering threads
+//
+// For each project and mode the output contains the rendered
+// length, the time to render, the realtime factor, the time
+// per sample for each active voice, the peak number of active
+// voices and the number of heap allocations made while rendering.
+// Projects that refer to a score or soundbank file that is not present
+// are reported as skipped rather than as an error. Messages from the
+// score scripts go to stderr so that stdout contains only the JSON.
+//
+// use: RenderBench [-m mode[,mode...]] [-n repeat] [-o file] [-M] [-N] [project...]
+//
+// -M memory maps soundbank samples rather than loading them.
+// -N keeps 16-bit and 24-bit soundbank samples in native format.
+//
+// Run this from the Src/BSynth directory so that the score
+// files in the projects are found.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL 
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////////////
+#include <new>
+#include "BSynth.h"
+#include <SFFile.h>
+#include <DLSFile.h>
+#include <SoundBankCache.h>
+#include <SynthThread.h>
+#include "SynthProject.h"
+#include "BenchTimer.h"
+
+/////////////////////////////////////////////////////////////////////////
+// Count heap allocations. The count is only read before and after
+// rendering, so this includes allocations on the render threads.
+/////////////////////////////////////////////////////////////////////////
+static volatile long allocCount = 0;
+
+void *operator new(size_t sz)
+{
+	SynthThread::AtomicAdd(&allocCount, 1);
+	void *p = malloc(sz > 0 ? sz : 1);
+	if (p == 0)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t sz)
+{
+	SynthThread::AtomicAdd(&allocCount, 1);
+	void *p = malloc(sz > 0 ? sz : 1);
+	if (p == 0)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) throw()
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) throw()
+{
+	free(p);
+}
+
+/// Null output. Samples are converted and then discarded
+/// when the buffer is full.
+class BenchWaveOut : public WaveOutBuf
+{
+public:
+	/// Number of frames (samples per channel) output.
+	long Frames()
+	{
+		return (long) sampleTotal / channels;
+	}
+};
+
+static const char *defProjects[] =
+{
+	"tstaddsynth.xml",
+	"tstfmsynth.xml",
+	"tstmatsynth.xml",
+	"tstsubsynth.xml",
+	"tsttonesynth.xml",
+	"tstsoundbank.xml",
+	"jig.xml",
+	0
+};
+
+static const char *defModes = "tick,block,block-scalar,threads-2,threads-4";
+
+class BenchResult
+{
+public:
+	const char *error;
+	const char *skipped;
+	double audioSec;
+	double renderSec;
+	double voiceFrames;
+	bsInt32 peakVoices;
+	long allocs;
+
+	BenchResult()
+	{
+		error = 0;
+		skipped = 0;
+		audioSec = 0;
+		renderSec = 0;
+		voiceFrames = 0;
+		peakVoices = 0;
+		allocs = 0;
+	}
+};
+
+/// Load and render one project in one mode.
+static void RunProject(const char *prjFile, const char *mode, int repeat, BenchResult& res)
+{
+	int threads = 0;
+	bool block = false;
+	bool scalar = false;
+	if (strcmp(mode, "tick") == 0)
+		block = false;
+	else if (strcmp(mode, "block") == 0)
+		block = true;
+	else if (strcmp(mode, "block-scalar") == 0)
+		block = scalar = true;
+	else if (strncmp(mode, "threads-", 8) == 0 && (threads = atoi(&mode[8])) > 0)
+		block = true;
+	else
+	{
+		res.error = "unknown mode";
+		return;
+	}
+
+	SynthProject *prj = new SynthProject;
+	prj->silent = 1;
+	prj->err.msgOut = stderr;
+	prj->Init();
+	if (prj->LoadProject((char *) prjFile) != 0)
+	{
+		if (prj->missing)
+			res.skipped = "missing score or soundbank file";
+		else
+			res.error = "cannot load project";
+	}
+	else if (prj->GenerateSequence() != 0)
+		res.error = "cannot generate sequence";
+	else
+	{
+		BenchWaveOut nul;
+		nul.AllocBuf(synthParams.isampleRate * 2, 2);
+		prj->wvp = &nul;
+		prj->seq.SetBlockMode(block);
+		if (threads > 0)
+			prj->seq.SetThreads(threads);
+		int simdLevel = synthSIMD.GetLevel();
+		if (scalar)
+			synthSIMD.SetLevel(SIMD_NONE);
+
+		for (int r = 0; r < repeat; r++)
+		{
+			long frames0 = nul.Frames();
+			long alloc0 = allocCount;
+			double t0 = BenchTime();
+			prj->Render();
+			double t1 = BenchTime();
+			if (r == 0 || (t1 - t0) < res.renderSec)
+				res.renderSec = t1 - t0;
+			if (r == 0)
+			{
+				res.allocs = allocCount - alloc0;
+				res.audioSec = (double) (nul.Frames() - frames0) / synthParams.sampleRate;
+				prj->seq.GetStats(res.peakVoices, res.voiceFrames);
+			}
+		}
+
+		synthSIMD.SetLevel(simdLevel);
+		prj->wvp = &prj->wvf;
+	}
+	delete prj;
+}
+
+static void WriteString(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	while (*str)
+	{
+		if (*str == '"' || *str == '\\')
+			fputc('\\', fp);
+		fputc(*str++, fp);
+	}
+	fputc('"', fp);
+}
+
+int main(int argc, char *argv[])
+{
+#if defined(USE_MSXML)
+	CoInitialize(0);
+#endif
+
+	const char *modes = defModes;
+	const char *outFile = 0;
+	int repeat = 1;
+
+	int i = 1;
+	while (i < argc && argv[i][0] == '-')
+	{
+		if (strcmp(argv[i], "-m") == 0 && i+1 < argc)
+			modes = argv[++i];
+		else if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+			repeat = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+			outFile = argv[++i];
+		else if (strcmp(argv[i], "-M") == 0)
+			SoundBank::mapSamples = 1;
+		else if (strcmp(argv[i], "-N") == 0)
+			SoundBank::nativeSamples = 1;
+		else
+		{
+			fprintf(stderr, "use: RenderBench [-m mode[,mode...]] [-n repeat] [-o file] [-M] [-N] [project...]\n");
+			return 1;
+		}
+		i++;
+	}
+	if (repeat < 1)
+		repeat = 1;
+
+	const char **projects = defProjects;
+	if (i < argc)
+		projects = (const char **) &argv[i];
+
+	FILE *fp = stdout;
+	if (outFile && (fp = fopen(outFile, "w")) == NULL)
+	{
+		fprintf(stderr, "Cannot open %s\n", outFile);
+		return 1;
+	}
+
+	static const char *simdNames[] = { "none", "sse2", "avx2" };
+	fprintf(fp, "{\n  \"simd\": \"%s\",\n  \"repeat\": %d,\n  \"results\": [", 
+		simdNames[synthSIMD.GetLevel()], repeat);
+
+	int errors = 0;
+	int count = 0;
+	const char **pp;
+	for (pp = projects; *pp; pp++)
+	{
+		const char *mp = modes;
+		while (*mp)
+		{
+			char mode[40];
+			int len = 0;
+			while (*mp && *mp != ',')
+			{
+				if (len < (int) sizeof(mode)-1)
+					mode[len++] = *mp;
+				mp++;
+			}
+			mode[len] = '\0';
+			if (*mp == ',')
+				mp++;
+			if (len == 0)
+				continue;
+
+			fprintf(stderr, "%s %s\n", *pp, mode);
+			BenchResult res;
+			RunProject(*pp, mode, repeat, res);
+
+			fprintf(fp, "%s\n    { \"project\": ", count++ ? "," : "");
+			WriteString(fp, *pp);
+			fprintf(fp, ", \"mode\": ");
+			WriteString(fp, mode);
+			if (res.error)
+			{
+				errors++;
+				fprintf(fp, ", \"error\": ");
+				WriteString(fp, res.error);
+			}
+			else if (res.skipped)
+			{
+				fprintf(fp, ", \"skipped\": ");
+				WriteString(fp, res.skipped);
+			}
+			else
+			{
+				double rtf = res.renderSec > 0 ? res.audioSec / res.renderSec : 0;
+				double nsv = res.voiceFrames > 0 ? (res.renderSec * 1.0e9) / res.voiceFrames : 0;
+				fprintf(fp, ", \"audio_sec\": %.3f, \"render_sec\": %.6f, \"realtime\": %.2f,", 
+					res.audioSec, res.renderSec, rtf);
+				fprintf(fp, " \"ns_per_sample_voice\": %.2f, \"peak_voices\": %d, \"allocations\": %ld",
+					nsv, (int) res.peakVoices, res.allocs);
+			}
+			fprintf(fp, " }");
+		}
+	}
+	fprintf(fp, "\n  ]\n}\n");
+	if (fp != stdout)
+		fclose(fp);
+
+#if defined(USE_MSXML)
+	CoUninitialize();
+#endif
+	return errors ? 1 : 0;
+}
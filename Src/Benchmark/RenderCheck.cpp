@@ -0,0 +1,196 @@
+/////////////////////////////////////////////////////////////////////////
+// BasicSynth - Render check
+//
+// Renders BSynth projects in tick mode, then again with block
+// mode, tick resolutions and threads that split the notes at
+// different places. Each render must produce exactly the same
+// 16-bit samples as the tick mode render, i.e., the same wave
+// file that BSynth writes. Block mode can finish a few samples
+// later, so only the common length is compared.
+//
+// The first project has an FMSynth patch with the delay line on,
+// where the voice must end on the same sample in every mode.
+// jig.xml is not included. It plays several noise voices at once,
+// and these share one random sequence, so the noise depends on the
+// order in which the voices are generated.
+//
+// use: RenderCheck [project...]
+//
+// Run this from the Src/BSynth directory so that the score
+// files in the projects are found. Projects that refer to
+// a missing score or soundbank file are skipped.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////////////
+#include "BSynth.h"
+#include <SFFile.h>
+#include <DLSFile.h>
+#include <SoundBankCache.h>
+#include "SynthProject.h"
+
+/// Output that keeps all of the samples.
+/// The buffer doubles in size each time it is full.
+class CheckWaveOut : public WaveOutBuf
+{
+public:
+	virtual int FlushOutput()
+	{
+		SampleValue *buf = new SampleValue[sampleMax * 2];
+		memcpy(buf, samples, sampleMax * sizeof(SampleValue));
+		delete[] samples;
+		samples = buf;
+		nxtSamp = samples + sampleMax;
+		sampleMax *= 2;
+		endSamp = samples + sampleMax;
+		return 0;
+	}
+
+	/// Number of values (all channels) output.
+	long Count()
+	{
+		return (long) sampleTotal;
+	}
+};
+
+static const char *defProjects[] =
+{
+	"tstfmsynth.xml",
+	"tstaddsynth.xml",
+	"tstmatsynth.xml",
+	"tstsubsynth.xml",
+	"tsttonesynth.xml",
+	"tstsoundbank.xml",
+	0
+};
+
+struct CheckMode
+{
+	const char *name;
+	int block;
+	int threads;
+	long tickFrames;
+};
+
+static CheckMode modes[] =
+{
+	{ "block", 1, 0, 0 },
+	{ "tick -r 256", 0, 0, 256 },
+	{ "block -r 256", 1, 0, 256 },
+	{ "block -r 100", 1, 0, 100 },
+	{ "threads-3 -r 512", 1, 3, 512 },
+	{ 0, 0, 0, 0 }
+};
+
+/// Load and render one project.
+/// @return 0 on success, 1 for a missing file, -1 for an error
+static int RenderProject(const char *prjFile, CheckMode *mp, CheckWaveOut& out)
+{
+	int err = 0;
+	// same noise as a new BSynth process
+	srand(1);
+	SynthProject *prj = new SynthProject;
+	prj->silent = 1;
+	prj->err.msgOut = stderr;
+	prj->Init();
+	if (prj->LoadProject((char *) prjFile) != 0)
+		err = prj->missing ? 1 : -1;
+	else if (prj->GenerateSequence() != 0)
+		err = -1;
+	else
+	{
+		out.AllocBuf(synthParams.isampleRate * 2, 2);
+		prj->wvp = &out;
+		prj->tickFrames = mp ? mp->tickFrames : 0;
+		if (mp)
+		{
+			prj->seq.SetBlockMode(mp->block != 0);
+			if (mp->threads > 0)
+				prj->seq.SetThreads(mp->threads);
+		}
+		prj->Render();
+		prj->wvp = &prj->wvf;
+	}
+	delete prj;
+	return err;
+}
+
+/// Compare the common length of two renders.
+/// @return number of values that differ
+static long Compare(CheckWaveOut& ref, CheckWaveOut& out, long& first)
+{
+	long count = ref.Count() < out.Count() ? ref.Count() : out.Count();
+	const SampleValue *rp = ref.GetBuf();
+	const SampleValue *op = out.GetBuf();
+	long diffs = 0;
+	first = -1;
+	for (long n = 0; n < count; n++)
+	{
+		if (rp[n] != op[n])
+		{
+			if (diffs++ == 0)
+				first = n / 2;
+		}
+	}
+	return diffs;
+}
+
+int main(int argc, char *argv[])
+{
+#if defined(USE_MSXML)
+	CoInitialize(0);
+#endif
+
+	int i = 1;
+	if (i < argc && argv[i][0] == '-')
+	{
+		fprintf(stderr, "use: RenderCheck [project...]\n");
+		return 1;
+	}
+
+	const char **projects = defProjects;
+	if (i < argc)
+		projects = (const char **) &argv[i];
+
+	int errors = 0;
+	const char **pp;
+	for (pp = projects; *pp; pp++)
+	{
+		CheckWaveOut ref;
+		int err = RenderProject(*pp, 0, ref);
+		if (err)
+		{
+			printf("%-20s %s\n", *pp, err > 0 ? "skipped" : "error");
+			if (err < 0)
+				errors++;
+			continue;
+		}
+		CheckMode *mp;
+		for (mp = modes; mp->name; mp++)
+		{
+			CheckWaveOut out;
+			if (RenderProject(*pp, mp, out) != 0)
+			{
+				printf("%-20s %-18s error\n", *pp, mp->name);
+				errors++;
+				continue;
+			}
+			long first;
+			long diffs = Compare(ref, out, first);
+			if (diffs)
+			{
+				printf("%-20s %-18s %ld values differ, first at frame %ld\n", *pp, mp->name, diffs, first);
+				errors++;
+			}
+			else
+				printf("%-20s %-18s same\n", *pp, mp->name);
+		}
+	}
+
+#if defined(USE_MSXML)
+	CoUninitialize();
+#endif
+	return errors ? 1 : 0;
+}
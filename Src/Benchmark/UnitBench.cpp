@@ -0,0 +1,218 @@
+/////////////////////////////////////////////////////////////////////////
+// BasicSynth - Unit generator benchmark
+//
+// Runs white noise through each filter, delay and reverb unit,
+// once with a call to Sample() for each value and once in blocks
+// with Samples(). Prints the time per sample for each method and
+// checks that both produce the same output.
+//
+// use: UnitBench [-b blocksize] [-d seconds]
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL 
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "SynthDefs.h"
+#include "WaveTable.h"
+#include "GenWave.h"
+#include "GenWaveWT.h"
+#include "EnvGen.h"
+#include "EnvGenSeg.h"
+#include "BiQuad.h"
+#include "DynFilter.h"
+#include "Filter.h"
+#include "AllPass.h"
+#include "DelayLine.h"
+#include "Reverb.h"
+#include "Flanger.h"
+#include "BenchTimer.h"
+
+static GenUnit *MakeFilterLP()
+{
+	FilterLP *f = new FilterLP;
+	f->Init(1000.0, 1.0);
+	return f;
+}
+
+static GenUnit *MakeFilterBP()
+{
+	FilterBP *f = new FilterBP;
+	f->Init(1000.0, 2.0, 1.0);
+	return f;
+}
+
+static GenUnit *MakeDynFilterLP()
+{
+	DynFilterLP *f = new DynFilterLP;
+	f->InitFilter(200.0, 0.5, 4000.0, 0.5, 1000.0, 0.5, 200.0);
+	return f;
+}
+
+static GenUnit *MakeFilterIIR2()
+{
+	FilterIIR2 *f = new FilterIIR2;
+	f->CalcCoef(1000.0);
+	return f;
+}
+
+static GenUnit *MakeFilterSV()
+{
+	FilterSV *f = new FilterSV;
+	f->InitFilter(1000.0, 2.0, 0.5, 0.25, 0.25);
+	return f;
+}
+
+static GenUnit *MakeFilterSVLP()
+{
+	FilterSVLP *f = new FilterSVLP;
+	f->InitFilter(1000.0, 2.0);
+	return f;
+}
+
+static GenUnit *MakeAllPassFilter()
+{
+	AllPassFilter *f = new AllPassFilter;
+	f->InitAP(0.5);
+	return f;
+}
+
+static GenUnit *MakeDelayLineR()
+{
+	DelayLineR *d = new DelayLineR;
+	d->InitDLR(0.0437, 2.0, 0.001);
+	return d;
+}
+
+static GenUnit *MakeAllPassDelay()
+{
+	AllPassDelay *d = new AllPassDelay;
+	d->InitDLR(0.09683, 0.0050, 0.001);
+	return d;
+}
+
+static GenUnit *MakeReverb1()
+{
+	Reverb1 *r = new Reverb1;
+	r->InitReverb(0.5, 0.04, 2.0);
+	return r;
+}
+
+static GenUnit *MakeReverb2()
+{
+	Reverb2 *r = new Reverb2;
+	r->InitReverb(0.5, 2.0);
+	return r;
+}
+
+static GenUnit *MakeFlanger()
+{
+	Flanger *f = new Flanger;
+	f->InitFlanger(0.7, 0.7, 0.1, 0.004, 0.003, 0.15);
+	return f;
+}
+
+struct UnitEntry
+{
+	const char *name;
+	GenUnit *(*make)();
+};
+
+static UnitEntry units[] =
+{
+	{ "FilterLP", MakeFilterLP },
+	{ "FilterBP", MakeFilterBP },
+	{ "DynFilterLP", MakeDynFilterLP },
+	{ "FilterIIR2", MakeFilterIIR2 },
+	{ "FilterSV", MakeFilterSV },
+	{ "FilterSVLP", MakeFilterSVLP },
+	{ "AllPassFilter", MakeAllPassFilter },
+	{ "DelayLineR", MakeDelayLineR },
+	{ "AllPassDelay", MakeAllPassDelay },
+	{ "Reverb1", MakeReverb1 },
+	{ "Reverb2", MakeReverb2 },
+	{ "Flanger", MakeFlanger },
+	{ 0, 0 }
+};
+
+int main(int argc, char *argv[])
+{
+	int blkSize = 256;
+	FrqValue duration = 10.0;
+
+	int argn;
+	for (argn = 1; argn < argc; argn++)
+	{
+		if (strcmp(argv[argn], "-b") == 0 && argn+1 < argc)
+			blkSize = atoi(argv[++argn]);
+		else if (strcmp(argv[argn], "-d") == 0 && argn+1 < argc)
+			duration = atof(argv[++argn]);
+		else
+		{
+			fprintf(stderr, "use: UnitBench [-b blocksize] [-d seconds]\n");
+			exit(1);
+		}
+	}
+	if (blkSize < 1)
+		blkSize = 1;
+
+	InitSynthesizer();
+
+	long totalSamples = (long) (duration * synthParams.sampleRate);
+	if (totalSamples < blkSize)
+		totalSamples = blkSize;
+	AmpValue *in = new AmpValue[totalSamples];
+	AmpValue *out1 = new AmpValue[totalSamples];
+	AmpValue *out2 = new AmpValue[totalSamples];
+
+	long n;
+	srand(1);
+	for (n = 0; n < totalSamples; n++)
+		in[n] = ((AmpValue) rand() / (AmpValue) RAND_MAX) - 0.5;
+
+	printf("%ld samples, block size %d\n", totalSamples, blkSize);
+	printf("%-16s %12s %12s %8s\n", "unit", "Sample ns", "Samples ns", "speedup");
+
+	int errors = 0;
+	UnitEntry *ue;
+	for (ue = units; ue->name; ue++)
+	{
+		GenUnit *up1 = ue->make();
+		GenUnit *up2 = ue->make();
+
+		double t0 = BenchTime();
+		for (n = 0; n < totalSamples; n++)
+			out1[n] = up1->Sample(in[n]);
+		double t1 = BenchTime();
+		for (n = 0; n < totalSamples; n += blkSize)
+		{
+			int cnt = blkSize;
+			if (n + cnt > totalSamples)
+				cnt = (int) (totalSamples - n);
+			up2->Samples(&in[n], &out2[n], cnt);
+		}
+		double t2 = BenchTime();
+
+		double ns1 = ((t1 - t0) * 1.0e9) / (double) totalSamples;
+		double ns2 = ((t2 - t1) * 1.0e9) / (double) totalSamples;
+		int same = memcmp(out1, out2, totalSamples * sizeof(AmpValue)) == 0;
+		if (!same)
+			errors++;
+		printf("%-16s %12.2f %12.2f %7.2fx%s\n", ue->name, ns1, ns2,
+			ns2 > 0 ? ns1 / ns2 : 0.0, same ? "" : "  output differs!");
+
+		delete up1;
+		delete up2;
+	}
+
+	delete[] in;
+	delete[] out1;
+	delete[] out2;
+
+	return errors ? 1 : 0;
+}
@@ -178,6 +178,18 @@ SOURCE=.\SoundBank.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\SoundBankCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\SoundBankLoader.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\SoundBankStreamer.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\SynthFileW.cpp
 
 !IF  "$(CFG)" == "Common - Win32 Release"
@@ -195,6 +207,10 @@ SOURCE=.\SynthMutex.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\SynthSIMD.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\SynthString.cpp
 
 !IF  "$(CFG)" == "Common - Win32 Release"
@@ -264,6 +280,19 @@ SOURCE=.\tinyxml\tinyxmlparser.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\VoicePolicy.cpp
+
+!IF  "$(CFG)" == "Common - Win32 Release"
+
+!ELSEIF  "$(CFG)" == "Common - Win32 Debug"
+
+# PROP Intermediate_Dir "Debug6"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
 SOURCE=.\WaveFile.cpp
 
 !IF  "$(CFG)" == "Common - Win32 Release"
@@ -369,6 +398,10 @@ SOURCE=..\..\Include\Flanger.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Include\GenCtl.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Include\GenNoise.h
 # End Source File
 # Begin Source File
@@ -449,6 +482,18 @@ SOURCE=..\..\Include\SFSoundBank.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Include\SoundBankCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Include\SoundBankLoader.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Include\SoundBankStreamer.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Include\SMFFile.h
 # End Source File
 # Begin Source File
@@ -469,6 +514,14 @@ SOURCE=..\..\Include\SynthMutex.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Include\SynthQueue.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Include\SynthSIMD.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Include\SynthString.h
 # End Source File
 # Begin Source File
@@ -485,6 +538,10 @@ SOURCE=..\..\Include\tinyxml.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Include\VoicePolicy.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Include\WaveFile.h
 # End Source File
 # Begin Source File
@@ -80,7 +80,7 @@ int DLSFile::IsDLSFile(const char *fname)
 	return isDLS;
 }
 
-SoundBank *DLSFile::LoadSoundBank(const char *fname, int pre)
+SoundBank *DLSFile::LoadSoundBank(const char *fname, int pre, SBLoadCB cb, Opaque usr)
 {
 	preload = pre;
 
@@ -110,6 +110,8 @@ SoundBank *DLSFile::LoadSoundBank(const char *fname, int pre)
 	if (info.Read(file, rchk.cksz - 4) == 0)
 		sb = BuildSoundBank(fname);
 	file.FileClose();
+	if (sb && preload)
+		sb->PreloadSamples(SoundBank::preloadThreads, cb, usr);
 	return sb;
 }
 
@@ -589,8 +591,6 @@ SoundBank *DLSFile::BuildSoundBank(const char *fname)
 			sp->format = wvi->wvfmt.bitsPerSamp == 8 ? 0 : 1;
 		else if (wvi->wvfmt.fmtTag == 2)
 			sp->format = 2;
-		if (preload)
-			sbnk->LoadSample(sp, file);
 	}
 
 	bsUint32 insIndx = 0;
@@ -754,7 +754,6 @@ SoundBank *DLSFile::BuildSoundBank(const char *fname)
 
 			grp->AddZone(zone);
 		}
-		instr->loaded = preload;
 	}
 
 	sbnk->Optimize();
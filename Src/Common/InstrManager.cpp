@@ -18,6 +18,7 @@
 #include <SynthMutex.h>
 #include <WaveTable.h>
 #include <WaveFile.h>
+#include <SynthSIMD.h>
 #include <Mixer.h>
 #include <SynthList.h>
 #include <XmlWrap.h>
@@ -288,3 +289,82 @@ void InstrManager::ExclNoteOff(int index, Instrument *ip)
 		exclNotes[index] = 0;
 }
 
+
+/////////////////////////////////////////////////////////////////
+// Block capture for multi-threaded rendering
+/////////////////////////////////////////////////////////////////
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+static THREAD_LOCAL BlockCapture *curCapture = 0;
+
+BlockCapture *BlockCapture::Current()
+{
+	return curCapture;
+}
+
+void BlockCapture::SetCurrent(BlockCapture *cap)
+{
+	curCapture = cap;
+}
+
+AmpValue *BlockCapture::Add(int type, int ch, int frames, int count)
+{
+	if (numRecs >= maxRecs)
+	{
+		bsInt32 newMax = maxRecs + 8;
+		CaptureRec *newRecs = new CaptureRec[newMax];
+		if (numRecs > 0)
+			memcpy(newRecs, recs, numRecs*sizeof(CaptureRec));
+		delete[] recs;
+		recs = newRecs;
+		maxRecs = newMax;
+	}
+	bsInt32 need = dataLen + (frames * count);
+	if (need > dataMax)
+	{
+		bsInt32 newMax = need * 2;
+		AmpValue *newData = new AmpValue[newMax];
+		if (dataLen > 0)
+			memcpy(newData, data, dataLen*sizeof(AmpValue));
+		delete[] data;
+		data = newData;
+		dataMax = newMax;
+	}
+	CaptureRec *rp = &recs[numRecs++];
+	rp->type = (bsInt16) type;
+	rp->ch = (bsInt16) ch;
+	rp->pos = blkPos;
+	rp->frames = frames;
+	rp->ofs = dataLen;
+	dataLen = need;
+	return &data[rp->ofs];
+}
+
+void BlockCapture::Replay(Mixer *mix)
+{
+	CaptureRec *rp = recs;
+	CaptureRec *re = &recs[numRecs];
+	while (rp < re)
+	{
+		AmpValue *dp = &data[rp->ofs];
+		mix->SetBlockPos(rp->pos);
+		switch (rp->type)
+		{
+		case 0:
+			mix->ChannelInBlock(rp->ch, dp, rp->frames);
+			break;
+		case 1:
+			mix->ChannelIn2Block(rp->ch, dp, dp + rp->frames, rp->frames);
+			break;
+		case 2:
+			mix->FxInBlock(rp->ch, dp, rp->frames);
+			break;
+		}
+		rp++;
+	}
+}
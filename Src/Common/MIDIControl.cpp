@@ -14,13 +14,18 @@
 #include <SynthDefs.h>
 #include <SynthString.h>
 #include <SynthMutex.h>
+#include <SynthThread.h>
+#include <SynthFile.h>
 #include <WaveFile.h>
+#include <SynthSIMD.h>
 #include <Mixer.h>
 #include <SynthList.h>
 #include <XmlWrap.h>
 #include <SeqEvent.h>
 #include <MIDIDefs.h>
 #include <MIDIControl.h>
+#include <SoundBank.h>
+#include <SoundBankLoader.h>
 #include <Instrument.h>
 #include <Sequencer.h>
 #include <GenWaveWT.h>
@@ -57,6 +62,7 @@ void MIDIChannelStatus::Reset()
 MIDIControl::MIDIControl()
 {
 	switchLevel = 64;
+	prefetch = 0;
 	for (int ch = 0; ch < 16; ch++)
 		channel[ch].channel = ch;
 	channel[9].cc[MIDI_CTRL_BANK] = 0x78;
@@ -114,6 +120,8 @@ void MIDIControl::ProcessMessage(short mm, short v1, short v2)
 					st->bank = 128;
 				else
 					st->bank = 0;
+				if (prefetch)
+					prefetch->Prefetch(st->bank, st->patch);
 				break;
 			case MIDI_CTRL_DATA:
 				switch (st->rpnnum)
@@ -157,6 +165,8 @@ void MIDIControl::ProcessMessage(short mm, short v1, short v2)
 			break;
 		case MIDI_PRGCHG:
 			st->patch = v2;
+			if (prefetch)
+				prefetch->Prefetch(st->bank, st->patch);
 			break;
 		case MIDI_KEYAT:
 			st->at[v1] = v2;
@@ -15,6 +15,7 @@
 #include <SynthMutex.h>
 #include <XmlWrap.h>
 #include <SeqEvent.h>
+#include <SynthSIMD.h>
 #include <Mixer.h>
 #include <WaveFile.h>
 #include <MIDIDefs.h>
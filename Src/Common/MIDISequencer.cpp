@@ -16,6 +16,7 @@
 #include <SynthDefs.h>
 #include <SynthString.h>
 #include <WaveFile.h>
+#include <SynthSIMD.h>
 #include <Mixer.h>
 #include <SynthList.h>
 #include <XmlWrap.h>
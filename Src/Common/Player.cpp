@@ -18,6 +18,7 @@
 #include <SynthString.h>
 #include <SynthMutex.h>
 #include <WaveFile.h>
+#include <SynthSIMD.h>
 #include <Mixer.h>
 #include <SynthList.h>
 #include <XmlWrap.h>
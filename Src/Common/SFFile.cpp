@@ -83,7 +83,7 @@ int SFFile::IsSF2File(const char *fname)
 	return isSF2;
 }
 
-SoundBank *SFFile::LoadSoundBank(const char *fname, int pre)
+SoundBank *SFFile::LoadSoundBank(const char *fname, int pre, SBLoadCB cb, Opaque usr)
 {
 	preload = pre;
 
@@ -144,6 +144,8 @@ SoundBank *SFFile::LoadSoundBank(const char *fname, int pre)
 	file.FileClose();
 
 	sfbnk->Optimize();
+	if (preload)
+		sfbnk->PreloadSamples(SoundBank::preloadThreads, cb, usr);
 
 	return sfbnk;
 }
@@ -400,22 +402,17 @@ SBSample *SFFile::CreateSample(sfSample *shdr, short id)
 	if (sampleFileOffs2 != 0)
 	{
 		samp->format = 3;
-		samp->filepos = sampleFileOffs2 + shdr->dwStart;
+		samp->filepos2 = sampleFileOffs2 + shdr->dwStart;
 	}
 	else
 		samp->format = 1;
 
-	if (preload)
-		sfbnk->LoadSample(samp, file);
-
 	if (shdr->wSampleLink)
 	{
 		samp->linkSamp = sfbnk->GetSample(shdr->wSampleLink, 0);
 		if (samp->linkSamp)
 		{
 			samp->linkSamp->linkSamp = samp;
-			if (preload)
-				sfbnk->LoadSample(samp->linkSamp, file);
 		}
 	}
 	return samp;
@@ -1162,7 +1159,6 @@ void SFFile::BuildPreset(int n)
 		globValid = 0;
 		bagNdx1++;
 	}
-	instr->loaded = preload;
 }
 
 void SFFile::BuildSoundBank()
@@ -15,6 +15,7 @@
 #include <SynthString.h>
 #include <SynthMutex.h>
 #include <WaveFile.h>
+#include <SynthSIMD.h>
 #include <Mixer.h>
 #include <SynthList.h>
 #include <XmlWrap.h>
@@ -431,6 +432,7 @@ void SMFFile::NoteOff(short chnl, short key, short vel, short track)
 	evt->SetType(SEQEVT_START);
 	evt->SetID(seq->NextEventID());
 	evt->SetInum(pm->inc->inum);
+	evt->SetInCfg(inc);
 	if (hdr.format == 2)
 		evt->SetTrack(track);
 	else
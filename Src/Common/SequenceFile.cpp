@@ -15,6 +15,7 @@
 #include <SynthList.h>
 #include <SynthFile.h>
 #include <SynthMutex.h>
+#include <SynthSIMD.h>
 #include <Mixer.h>
 #include <WaveFile.h>
 #include <XmlWrap.h>
@@ -16,8 +16,11 @@
 #include <SynthDefs.h>
 #include <SynthString.h>
 #include <SynthMutex.h>
+#include <SynthThread.h>
+#include <SynthQueue.h>
 #include <WaveTable.h>
 #include <WaveFile.h>
+#include <SynthSIMD.h>
 #include <Mixer.h>
 #include <SynthList.h>
 #include <XmlWrap.h>
@@ -32,45 +35,104 @@
 
 void SeqTrack::Reset()
 {
-	SeqEvent *evt;
-	while ((evt = evtHead->next) != evtTail)
-	{
-		evt->Remove();
-		evt->Destroy();
-	}
-	evtLast = evtHead;
+	bsInt32 n;
+	for (n = 0; n < evtCount; n++)
+		evtList[n]->Destroy();
+	evtCount = 0;
+	evtList[0] = evtTail;
+	evtPlay = 0;
+	sorted = 1;
 	seqLength = 0;
 }
 
+// Make room for more events. The list always has
+// one extra entry for the end marker.
+void SeqTrack::Grow()
+{
+	bsInt32 newAlloc = evtAlloc ? evtAlloc * 2 : 256;
+	SeqEvent **newList = new SeqEvent*[newAlloc+1];
+	bsInt32 n;
+	for (n = 0; n < evtCount; n++)
+		newList[n] = evtList[n];
+	newList[evtCount] = evtTail;
+	delete[] evtList;
+	evtList = newList;
+	evtAlloc = newAlloc;
+}
+
 void SeqTrack::AddEvent(SeqEvent *evt)
 {
 	//printf("Add Event %d at time %d\n", evt->evid, evt->start);
-	if (evtLast == NULL)
-		evtLast = evtHead;
-	SeqEvent *inspt;
-	if (evt->start >= evtLast->start)
+	if (evtCount >= evtAlloc)
+		Grow();
+	if (evtCount > 0 && evt->start < evtList[evtCount-1]->start)
+		sorted = 0;
+	evtList[evtCount++] = evt;
+	evtList[evtCount] = evtTail;
+	bsInt32 e = evt->start + evt->duration;
+	if (e >= seqLength)
+		seqLength = e+1;
+}
+
+// Merge sort, which keeps events with the same
+// start time in the order they were added.
+void SeqTrack::Sort()
+{
+	SeqEvent **src = evtList;
+	SeqEvent **dst = new SeqEvent*[evtAlloc+1];
+	SeqEvent **tmp;
+	bsInt32 width;
+	bsInt32 lo, mid, hi;
+	bsInt32 i, j, k;
+	for (width = 1; width < evtCount; width *= 2)
 	{
-		do
+		for (lo = 0; lo < evtCount; lo += 2 * width)
 		{
-			inspt = evtLast;
-			evtLast = evtLast->next;
-		} while (evt->start >= evtLast->start);
-		inspt->Insert(evt);
-		evtLast = evt;
+			mid = lo + width;
+			if (mid > evtCount)
+				mid = evtCount;
+			hi = mid + width;
+			if (hi > evtCount)
+				hi = evtCount;
+			i = lo;
+			j = mid;
+			k = lo;
+			while (i < mid && j < hi)
+			{
+				if (src[j]->start < src[i]->start)
+					dst[k++] = src[j++];
+				else
+					dst[k++] = src[i++];
+			}
+			while (i < mid)
+				dst[k++] = src[i++];
+			while (j < hi)
+				dst[k++] = src[j++];
+		}
+		tmp = src;
+		src = dst;
+		dst = tmp;
 	}
-	else
+	// src has the sorted list, dst is the spare buffer
+	delete[] dst;
+	evtList = src;
+	evtList[evtCount] = evtTail;
+	sorted = 1;
+}
+
+bsInt32 SeqTrack::FindEvent(bsInt32 st)
+{
+	bsInt32 lo = 0;
+	bsInt32 hi = evtCount;
+	while (lo < hi)
 	{
-		do
-		{
-			inspt = evtLast;
-			evtLast = evtLast->prev;
-		} while (evt->start < evtLast->start);
-		evtLast->Insert(evt);
-		evtLast = evt;
+		bsInt32 mid = (lo + hi) / 2;
+		if (evtList[mid]->start < st)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	bsInt32 e = evt->start + evt->duration;
-	if (e >= seqLength)
-		seqLength = e+1;
+	return lo;
 }
 
 //////////////////////////// SEQUENCER ////////////////////////////
@@ -92,8 +154,24 @@ Sequencer::Sequencer()
 	instMgr = 0;
 	globEventID = 0;
 	maxNote = 1000;
+	voicePolicy = 0;
+	silentLevel = 0;
+	silentFrames = 0;
 	trkActive = 0;
 	evtActive = 0;
+	blkMode = false;
+	blkActive = false;
+	numThreads = 1;
+	pool = 0;
+	blkPos = 0;
+	blkFrames = 0;
+	actArena = 0;
+	actFree = 0;
+	actArenaSize = 0;
+	statActive = 0;
+	statPeak = 0;
+	statVoiceFrames = 0;
+	statSilent = 0;
 
 	track = new SeqTrack(0);
 
@@ -104,11 +182,15 @@ Sequencer::Sequencer()
 	immTail->start = 0x7FFFFFFFL;
 	immHead->evid = -1;
 	immTail->evid = -2;
+	immQueue = new SynthQueueMPSC<SeqEvent*>;
+	immOverflow = 0;
 
 	actHead = new ActiveEvent;
 	actTail = new ActiveEvent;
 	actHead->ip = NULL;
 	actTail->ip = NULL;
+	actHead->ic = NULL;
+	actTail->ic = NULL;
 	actHead->evid = -1;
 	actTail->evid = -2;
 	actHead->ison = SEQ_AE_OFF;
@@ -126,8 +208,10 @@ Sequencer::~Sequencer()
 	Reset();
 	immHead->Destroy();
 	immTail->Destroy();
+	delete immQueue;
 	delete actHead;
 	delete actTail;
+	delete[] actArena;
 	delete track;
 	globEventID = 0;
 }
@@ -160,15 +244,69 @@ void Sequencer::AddEvent(SeqEvent *evt)
 	tp->AddEvent(evt);
 }
 
+// Sort all tracks before playback. Sorting allocates,
+// and a track can be started from the render thread.
+void Sequencer::SortTracks()
+{
+	for (SeqTrack *tp = track; tp; tp = tp->next)
+		tp->SortIfNeeded();
+}
+
 
 void Sequencer::AddImmediate(SeqEvent *evt)
 {
 	if (evt == 0)
 		return;
 
-	critMutex.Enter();
-	immTail->InsertBefore(evt);
-	critMutex.Leave();
+	if (immOverflow || !immQueue->Put(evt))
+	{
+		// Queue is full. Keep order by sending everything
+		// through the list until the sequencer empties it.
+		critMutex.Enter();
+		immTail->InsertBefore(evt);
+		immOverflow = 1;
+		critMutex.Leave();
+	}
+}
+
+// Process (or discard) all pending immediate events.
+// Called once per block by the sequencer thread.
+void Sequencer::ProcessImmediate(bool discard)
+{
+	SeqEvent *evt;
+	while (immQueue->Get(evt))
+	{
+		if (!discard)
+			ProcessEvent(evt, 0);
+		evt->Destroy();
+	}
+
+	if (immOverflow)
+	{
+		// detach the list so that producers are not held up
+		SeqEvent *first;
+		SeqEvent *last;
+		critMutex.Enter();
+		first = immHead->next;
+		last = immTail->prev;
+		immHead->next = immTail;
+		immTail->prev = immHead;
+		immOverflow = 0;
+		critMutex.Leave();
+		if (first != immTail)
+		{
+			last->next = 0;
+			while ((evt = first) != 0)
+			{
+				first = evt->next;
+				evt->next = 0;
+				evt->prev = 0;
+				if (!discard)
+					ProcessEvent(evt, 0);
+				evt->Destroy();
+			}
+		}
+	}
 }
 
 // Multi-mode sequencer can play live, sequence, loop tracks or any combination.
@@ -185,11 +323,12 @@ bsUint32 Sequencer::SequenceMulti(InstrManager& im, bsUint32 startTime, bsUint32
 
 	im.SetSequencer(this);
 
-	SeqEvent *imm = 0;
 	SeqEvent *evt = 0;
 	SeqTrack *tp = 0;
 	trkActive = 0;
 	evtActive = 0;
+	InitActive();
+	SortTracks();
 
 	seqTick = startTime;
 	track->LoopCount(1);
@@ -197,6 +336,7 @@ bsUint32 Sequencer::SequenceMulti(InstrManager& im, bsUint32 startTime, bsUint32
 
 	instMgr = &im;
 	instMgr->Start();
+	StartBlock((st & seqPlay) == 0);
 
 	state = st;
 	int live = st & seqPlay;
@@ -212,36 +352,36 @@ bsUint32 Sequencer::SequenceMulti(InstrManager& im, bsUint32 startTime, bsUint32
 	while (playing)
 	{
 		if (live)
-		{
-			// in-line message peek/get
-			critMutex.Enter();
-			imm = immHead->next;
-			if (imm != immTail)
-				imm->Remove();
-			else
-				imm = NULL;
-			critMutex.Leave();
-			if (imm)
-			{
-				ProcessEvent(imm, 0);
-				imm->Destroy();
-			}
-		}
+			ProcessImmediate(false);
 
 		if (sequenced)
 		{
-			// find any events that are ready to activate
+			// find any events that are ready to activate,
+			// splitting the tick at events that start inside it
+			bsInt32 pos = 0;
+			do
+			{
+				bsInt32 next = tickRes;
+				for (tp = track; tp; tp = tp->next)
+				{
+					while ((evt = tp->NextEvent(pos)) != 0)
+						ProcessEvent(evt, SEQ_AE_TM);
+					next = tp->NextOffset(next);
+				}
+				// invoke all active instruments up to the next event
+				evtActive = TickFrames(pos, next - pos);
+				pos = next;
+			} while (pos < tickRes && playing);
+
 			trkActive = 0;
 			for (tp = track; tp; tp = tp->next)
-			{
-				while ((evt = tp->NextEvent()) != 0)
-					ProcessEvent(evt, SEQ_AE_TM);
 				trkActive |= tp->Tick();
-			}
 		}
-
-		// invoke all active instruments for tickRes samples
-		evtActive = Tick();
+		else
+		{
+			// invoke all active instruments for tickRes samples
+			evtActive = Tick();
+		}
 
 		// When we have reached the end of the sequence
 		// AND all events have finished,
@@ -254,6 +394,7 @@ bsUint32 Sequencer::SequenceMulti(InstrManager& im, bsUint32 startTime, bsUint32
 				playing = false;
 		}
 	}
+	StopBlock();
 	instMgr->Stop();
 
 	// Since it is possible to halt the sequence while events are still
@@ -288,6 +429,8 @@ bsUint32 Sequencer::Sequence(InstrManager& im, bsUint32 startTime, bsUint32 endT
 	SeqEvent *evt = 0;
 	trkActive = 0;
 	evtActive = 0;
+	InitActive();
+	SortTracks();
 
 	seqTick = startTime;
 	track->LoopCount(1);
@@ -295,6 +438,7 @@ bsUint32 Sequencer::Sequence(InstrManager& im, bsUint32 startTime, bsUint32 endT
 
 	instMgr = &im;
 	instMgr->Start();
+	StartBlock(true);
 
 	state = seqSeqOnce;
 
@@ -306,14 +450,20 @@ bsUint32 Sequencer::Sequence(InstrManager& im, bsUint32 startTime, bsUint32 endT
 	playing = true;
 	while (playing)
 	{
-		// find any events that are ready to activate
-		while ((evt = track->NextEvent()) != 0)
-			ProcessEvent(evt, SEQ_AE_TM);
+		// find any events that are ready to activate,
+		// splitting the tick at events that start inside it
+		bsInt32 pos = 0;
+		do
+		{
+			while ((evt = track->NextEvent(pos)) != 0)
+				ProcessEvent(evt, SEQ_AE_TM);
+			bsInt32 next = track->NextOffset(tickRes);
+			// invoke all active instruments up to the next event
+			evtActive = TickFrames(pos, next - pos);
+			pos = next;
+		} while (pos < tickRes && playing);
 		trkActive = track->Tick();
 
-		// invoke all active instruments for tickRes samples
-		evtActive = Tick();
-
 		// When we have reached the end of the sequence
 		// AND all events have finished,
 		// OR, we have hit the last time caller wanted,
@@ -322,6 +472,7 @@ bsUint32 Sequencer::Sequence(InstrManager& im, bsUint32 startTime, bsUint32 endT
 		  || (endTime != 0 && seqTick >= endTime))
 			playing = false;
 	}
+	StopBlock();
 	instMgr->Stop();
 
 	// Since it is possible to halt the sequence while events are still
@@ -351,41 +502,23 @@ bsUint32 Sequencer::Play(InstrManager& im)
 	instMgr = &im;
 	im.SetSequencer(this);
 
-	SeqEvent *evt;
-
 	ClearActive();
-
-	critMutex.Enter();
-	while ((evt = immHead->next) != immTail)
-	{
-		evt->Remove();
-		evt->Destroy();
-	}
-	critMutex.Leave();
+	InitActive();
+	SortTracks();
+	ProcessImmediate(true);
 
 	state = seqPlay;
 	seqTick = 0;
 
 	instMgr->Start();
+	StartBlock(false);
 	playing = true;
 	while (playing)
 	{
-		// in-line message peek/get
-		critMutex.Enter();
-		evt = immHead->next;
-		if (evt != immTail)
-			evt->Remove();
-		else
-			evt = NULL;
-		critMutex.Leave();
-		if (evt)
-		{
-			ProcessEvent(evt, 0);
-			evt->Destroy();
-		}
-
+		ProcessImmediate(false);
 		Tick();
 	}
+	StopBlock();
 	instMgr->Stop();
 
 	ClearActive();
@@ -401,16 +534,8 @@ bsUint32 Sequencer::Play(InstrManager& im)
 // Reset should be called to clean up any memory before filling in a new sequence.
 void Sequencer::Reset()
 {
-	SeqEvent *evt;
 	ClearActive();
-
-	critMutex.Enter();
-	while ((evt = immHead->next) != immTail)
-	{
-		evt->Remove();
-		evt->Destroy();
-	}
-	critMutex.Leave();
+	ProcessImmediate(true);
 
 	track->Reset();
 	SeqTrack *tp;
@@ -431,15 +556,104 @@ void Sequencer::ClearActive()
 
 	while ((act = actHead->next) != actTail)
 	{
-		instMgr->Deallocate(act->ip);
+		instMgr->Deallocate(act->ip, act->ic);
 		act->Remove();
+		FreeActive(act);
+	}
+}
+
+// Preallocate active events to the maximum number of notes.
+// The arena can only be rebuilt while no events are active.
+void Sequencer::InitActive()
+{
+	statPeak = statActive;
+	statVoiceFrames = 0;
+	statSilent = 0;
+	if (actArenaSize == maxNote || actHead->next != actTail)
+		return;
+	delete[] actArena;
+	actArena = 0;
+	actFree = 0;
+	actArenaSize = 0;
+	if (maxNote <= 0)
+		return;
+	actArena = new ActiveEvent[maxNote];
+	actArenaSize = maxNote;
+	for (bsInt32 n = maxNote; n-- > 0; )
+	{
+		actArena[n].next = actFree;
+		actFree = &actArena[n];
+	}
+}
+
+// Get an active event from the arena, or the heap if the arena is exhausted.
+ActiveEvent *Sequencer::NewActive()
+{
+	if (++statActive > statPeak)
+		statPeak = statActive;
+	ActiveEvent *act = actFree;
+	if (act)
+	{
+		actFree = act->next;
+		act->next = 0;
+		act->prev = 0;
+		return act;
+	}
+	return new ActiveEvent;
+}
+
+// Return an active event to the arena, or the heap if it was not allocated from the arena.
+void Sequencer::FreeActive(ActiveEvent *act)
+{
+	statActive--;
+	if (act >= actArena && act < &actArena[actArenaSize])
+	{
+		act->next = actFree;
+		actFree = act;
+	}
+	else
 		delete act;
+}
+
+// Remove notes in release that have been below the silence
+// level for silentFrames samples. A note that gets louder again
+// (e.g., a looping sample) starts the count over.
+void Sequencer::RemoveSilent(bsInt32 frames)
+{
+	ActiveEvent *act = actHead->next;
+	while (act != actTail)
+	{
+		if (act->ison == SEQ_AE_REL)
+		{
+			if (act->ip->GetLevel() >= silentLevel)
+				act->quiet = 0;
+			else if (act->quiet >= silentFrames)
+			{
+				instMgr->Deallocate(act->ip, act->ic);
+				ActiveEvent *p = act->Remove();
+				FreeActive(act);
+				statSilent++;
+				act = p;
+				continue;
+			}
+			else
+				act->quiet += frames;
+		}
+		act = act->next;
 	}
 }
 
+// Cycle all active events for one tick (tickRes samples)
+int Sequencer::Tick()
+{
+	return TickFrames(0, tickRes);
+}
+
 // Cycle all active events (Tick)
 // This is "IT" - where we actually generate samples...
-int Sequencer::Tick()
+// pos is the offset into the current tick; frames is the
+// number of samples to generate.
+int Sequencer::TickFrames(bsInt32 pos, bsInt32 frames)
 {
 	if (pausing)
 	{
@@ -448,13 +662,26 @@ int Sequencer::Tick()
 			return 0;
 	}
 
+	if (silentLevel > 0)
+		RemoveSilent(frames);
+
+	statVoiceFrames += (double) statActive * (double) frames;
+
+	if (blkActive)
+		return TickBlock(pos, frames);
+
+	// Voices and mixer output are interleaved on each sample,
+	// so only the voices for the first sample are timed.
+	int timed = voicePolicy && voicePolicy->Timed();
 	int actCount;
-	bsInt32 tickBlk = tickRes;
+	bsInt32 tickBlk = frames;
 	do
 	{
 		actCount = 0;
 		Instrument *ins;
 		ActiveEvent *act = actHead->next;
+		if (timed)
+			voicePolicy->StartRender();
 		while (act != actTail)
 		{
 			actCount++;
@@ -478,9 +705,9 @@ int Sequencer::Tick()
 				if (ins->IsFinished())
 				{
 					//printf("Remove Note for event %d\n", act->evid);
-					instMgr->Deallocate(ins);
+					instMgr->Deallocate(ins, act->ic);
 					ActiveEvent *p = act->Remove();
-					delete act;
+					FreeActive(act);
 					act = p;
 					actCount--;
 				}
@@ -491,6 +718,11 @@ int Sequencer::Tick()
 				}
 			}
 		}
+		if (timed)
+		{
+			voicePolicy->EndRender(1, actCount);
+			timed = 0;
+		}
 		instMgr->Tick();
 
 		seqTick++;
@@ -509,6 +741,513 @@ int Sequencer::Tick()
 	return actCount;
 }
 
+//////////////////////// RENDER THREADS /////////////////////////
+
+// Number of checks made before a thread waiting for the
+// next block, or for the workers to finish, blocks on a signal.
+#define SEQ_SPIN 1000
+
+class SeqRenderWorker : public SynthThread
+{
+public:
+	SeqRenderPool *pool;
+	SynthSignal start;      // set when a block is ready
+	volatile long waiting;  // 1 while blocked, or about to block, on start
+	virtual int ThreadProc();
+};
+
+// Worker threads for offline block rendering.
+// For each block, the sequencer adds the voices that can render
+// in parallel, then calls Render(). The calling thread and the
+// workers take voices from the list until all are done. Output
+// from each voice is captured and then sent to the mixer in list order.
+// The block is open while the calling thread takes voices. A worker
+// counts itself busy and then checks that the block is still open,
+// so the caller only waits for workers that joined the block. When
+// the workers are slow to start, as on a single CPU, the caller
+// renders the block alone and does not wait for them.
+// Threads spin briefly while waiting, then block on a signal,
+// so that waiting threads do not take CPU time from the others.
+// A thread sets its waiting flag before it checks the condition
+// one last time. The thread that changes the condition clears the
+// flag and sends the wakeup; signals are latched, so the wakeup is
+// not lost when it is sent before the wait.
+class SeqRenderPool
+{
+public:
+	Sequencer *seq;
+	SeqRenderWorker *workers;
+	int numWorkers;
+	ActiveEvent **voices;
+	BlockCapture **capture;
+	int numVoices;
+	int maxVoices;
+	volatile long blkGen;   // incremented to start a block
+	volatile long blkNext;  // next voice to render
+	volatile long blkOpen;  // 1 while workers may take voices
+	volatile long blkBusy;  // number of workers in the block
+	volatile long quit;
+	SynthSignal done;       // set when the last busy worker finishes
+	volatile long waiting;  // 1 while Render() waits on done
+
+	SeqRenderPool(Sequencer *s, int threads)
+	{
+		seq = s;
+		numVoices = 0;
+		maxVoices = 0;
+		voices = 0;
+		capture = 0;
+		blkGen = 0;
+		blkNext = 0;
+		blkOpen = 0;
+		blkBusy = 0;
+		quit = 0;
+		waiting = 0;
+		done.Create();
+		numWorkers = 0;
+		workers = new SeqRenderWorker[threads-1];
+		for (int n = 0; n < threads-1; n++)
+		{
+			SeqRenderWorker *wp = &workers[numWorkers];
+			wp->pool = this;
+			wp->waiting = 0;
+			wp->start.Create();
+			if (wp->StartThread() == 0)
+				numWorkers++;
+		}
+	}
+
+	~SeqRenderPool()
+	{
+		quit = 1;
+		StartWorkers();
+		for (int n = 0; n < numWorkers; n++)
+			workers[n].WaitThread();
+		delete[] workers;
+		for (int n = 0; n < maxVoices; n++)
+			delete capture[n];
+		delete[] capture;
+		delete[] voices;
+	}
+
+	void Add(ActiveEvent *act)
+	{
+		if (numVoices >= maxVoices)
+		{
+			int newMax = maxVoices + 32;
+			ActiveEvent **newVoices = new ActiveEvent*[newMax];
+			BlockCapture **newCapture = new BlockCapture*[newMax];
+			for (int n = 0; n < maxVoices; n++)
+			{
+				newVoices[n] = voices[n];
+				newCapture[n] = capture[n];
+			}
+			for (int n = maxVoices; n < newMax; n++)
+				newCapture[n] = new BlockCapture;
+			delete[] voices;
+			delete[] capture;
+			voices = newVoices;
+			capture = newCapture;
+			maxVoices = newMax;
+		}
+		voices[numVoices++] = act;
+	}
+
+	// Start the next block and wake the workers that are blocked.
+	void StartWorkers()
+	{
+		SynthThread::AtomicAdd(&blkGen, 1);
+		for (int n = 0; n < numWorkers; n++)
+		{
+			if (SynthThread::AtomicCAS(&workers[n].waiting, 1, 0) == 1)
+				workers[n].start.Wakeup();
+		}
+	}
+
+	// Called by a worker when a block starts.
+	void WorkerBlock()
+	{
+		SynthThread::AtomicAdd(&blkBusy, 1);
+		if (SynthThread::AtomicAdd(&blkOpen, 0))
+			RenderVoices();
+		if (SynthThread::AtomicAdd(&blkBusy, -1) == 0
+		 && SynthThread::AtomicCAS(&waiting, 1, 0) == 1)
+			done.Wakeup();
+	}
+
+	// Close the block and wait for the busy workers to finish.
+	void WaitWorkers()
+	{
+		SynthThread::AtomicCAS(&blkOpen, 1, 0);
+		int spin = 0;
+		while (blkBusy > 0)
+		{
+			if (++spin < SEQ_SPIN)
+				continue;
+			SynthThread::AtomicCAS(&waiting, 0, 1);
+			if (SynthThread::AtomicAdd(&blkBusy, 0) > 0
+			 || SynthThread::AtomicCAS(&waiting, 1, 0) != 1)
+				done.Wait();
+			break;
+		}
+	}
+
+	void RenderVoices()
+	{
+		long n;
+		while ((n = SynthThread::AtomicAdd(&blkNext, 1) - 1) < numVoices)
+		{
+			BlockCapture *cap = capture[n];
+			cap->Clear();
+			BlockCapture::SetCurrent(cap);
+			seq->BlockVoice(voices[n]);
+		}
+		BlockCapture::SetCurrent(0);
+	}
+
+	// Render all voices added since the last call.
+	// Returns the number of voices that must be called with Tick().
+	int Render()
+	{
+		int n;
+		if (numVoices < 2 || numWorkers == 0)
+		{
+			for (n = 0; n < numVoices; n++)
+				seq->BlockVoice(voices[n]);
+		}
+		else
+		{
+			blkNext = 0;
+			SynthThread::AtomicCAS(&blkOpen, 0, 1);
+			StartWorkers();
+			RenderVoices();
+			WaitWorkers();
+			Mixer *mix = seq->instMgr->GetMixer();
+			for (n = 0; n < numVoices; n++)
+				capture[n]->Replay(mix);
+		}
+		int tickVoices = 0;
+		for (n = 0; n < numVoices; n++)
+		{
+			if (voices[n]->flags & SEQ_AE_TICK)
+				tickVoices++;
+		}
+		numVoices = 0;
+		return tickVoices;
+	}
+};
+
+int SeqRenderWorker::ThreadProc()
+{
+	long seen = 0;
+	for (;;)
+	{
+		int spin = 0;
+		while (pool->blkGen == seen)
+		{
+			if (++spin < SEQ_SPIN)
+				continue;
+			SynthThread::AtomicCAS(&waiting, 0, 1);
+			if (SynthThread::AtomicAdd(&pool->blkGen, 0) == seen
+			 || SynthThread::AtomicCAS(&waiting, 1, 0) != 1)
+				start.Wait();
+			break;
+		}
+		seen = SynthThread::AtomicAdd(&pool->blkGen, 0);
+		if (pool->quit)
+			break;
+		pool->WorkerBlock();
+	}
+	return 0;
+}
+
+// Setup block output if requested and the instrument manager supports it.
+// Offline rendering can use multiple threads, but no more than the
+// number of CPUs; extra threads only add hand-off time to each block.
+void Sequencer::StartBlock(bool offline)
+{
+	blkActive = blkMode && instMgr->SetBlockSize(tickRes) == 0;
+	int threads = numThreads;
+	if (threads > 1 && threads > SynthThread::CPUCount())
+		threads = SynthThread::CPUCount();
+	if (blkActive && offline && threads > 1)
+		pool = new SeqRenderPool(this, threads);
+}
+
+void Sequencer::StopBlock()
+{
+	if (pool)
+	{
+		delete pool;
+		pool = 0;
+	}
+	if (blkActive)
+	{
+		instMgr->SetBlockSize(0);
+		blkActive = false;
+	}
+}
+
+// Generate frames samples from the instrument, starting at pos.
+// Returns 0 if the instrument does not support TickBlock.
+int Sequencer::RenderBlock(ActiveEvent *act, int pos, int frames)
+{
+	while (frames > 0)
+	{
+		int n = frames > MAX_TICKBLOCK ? MAX_TICKBLOCK : frames;
+		instMgr->SetBlockPos(pos);
+		if (!act->ip->TickBlock(n))
+		{
+			act->flags |= SEQ_AE_TICK;
+			return 0;
+		}
+		pos += n;
+		frames -= n;
+	}
+	return 1;
+}
+
+// Generate the current block segment for a voice that supports TickBlock.
+// Voices in release have already been checked for IsFinished.
+// This only changes the active event and the instrument
+// and may be called on a worker thread.
+void Sequencer::BlockVoice(ActiveEvent *act)
+{
+	if (act->ison == SEQ_AE_ON)
+	{
+		if ((act->flags & SEQ_AE_TM) && act->count <= blkFrames)
+		{
+			// duration finishes in this segment
+			if (RenderBlock(act, blkPos, act->count))
+			{
+				act->ip->Stop();
+				act->ison = SEQ_AE_REL;
+				RenderBlock(act, blkPos + act->count, blkFrames - act->count);
+				act->count = 0;
+			}
+		}
+		else if (RenderBlock(act, blkPos, blkFrames))
+		{
+			if (act->flags & SEQ_AE_TM)
+				act->count -= blkFrames;
+		}
+	}
+	else if (act->ison == SEQ_AE_REL)
+		RenderBlock(act, blkPos, blkFrames);
+}
+
+// Render voices that have the same batch key together.
+// Each instrument keeps its samples and outputs them from
+// TickBlock() when BlockVoice() is called, so the output is
+// mixed in the same order as without batching.
+// Only voices that generate the whole segment with one call
+// to TickBlock() are included.
+void Sequencer::BatchVoices()
+{
+	if (blkFrames > MAX_TICKBLOCK)
+		return;
+
+	Opaque keys[SEQ_BATCH_KEYS];
+	Instrument *batch[SEQ_BATCH_KEYS][SEQ_BATCH_MAX];
+	int count[SEQ_BATCH_KEYS];
+	int numKeys = 0;
+	int k;
+
+	ActiveEvent *act;
+	for (act = actHead->next; act != actTail; act = act->next)
+	{
+		if (act->flags & SEQ_AE_TICK)
+			continue;
+		if (act->ison == SEQ_AE_ON)
+		{
+			if ((act->flags & SEQ_AE_TM) && act->count <= blkFrames)
+				continue;
+		}
+		else if (act->ison != SEQ_AE_REL)
+			continue;
+		Opaque key = act->ip->BatchKey();
+		if (key == 0)
+			continue;
+		for (k = 0; k < numKeys; k++)
+		{
+			if (keys[k] == key)
+				break;
+		}
+		if (k == numKeys)
+		{
+			if (numKeys >= SEQ_BATCH_KEYS)
+				continue;
+			keys[numKeys++] = key;
+			count[k] = 0;
+		}
+		batch[k][count[k]++] = act->ip;
+		if (count[k] == SEQ_BATCH_MAX)
+		{
+			batch[k][0]->TickBatch(batch[k], count[k], blkFrames);
+			count[k] = 0;
+		}
+	}
+	for (k = 0; k < numKeys; k++)
+	{
+		if (count[k] > 1)
+			batch[k][0]->TickBatch(batch[k], count[k], blkFrames);
+	}
+}
+
+// Cycle all active events for one block segment (TickBlock)
+// Instruments that support block output generate the
+// samples at once. Any others are called on each sample.
+// pos is the offset into the block; frames is the number of samples.
+int Sequencer::TickBlock(bsInt32 pos, bsInt32 frames)
+{
+	blkPos = pos;
+	blkFrames = frames;
+
+	int timed = voicePolicy && voicePolicy->Timed();
+	if (timed)
+		voicePolicy->StartRender();
+
+	int actCount = 0;
+	int tickVoices = 0;
+	Instrument *ins;
+	ActiveEvent *act = actHead->next;
+	while (act != actTail)
+	{
+		ins = act->ip;
+		if (!(act->flags & SEQ_AE_TICK)
+		 && act->ison == SEQ_AE_REL && ins->IsFinished())
+		{
+			instMgr->Deallocate(ins, act->ic);
+			ActiveEvent *p = act->Remove();
+			FreeActive(act);
+			act = p;
+		}
+		else
+			act = act->next;
+	}
+
+	// With worker threads the voices are already rendered in parallel.
+	if (!pool)
+		BatchVoices();
+
+	act = actHead->next;
+	while (act != actTail)
+	{
+		if (!(act->flags & SEQ_AE_TICK))
+		{
+			if (pool)
+			{
+				pool->Add(act);
+				actCount++;
+				act = act->next;
+				continue;
+			}
+			BlockVoice(act);
+		}
+		if (act->flags & SEQ_AE_TICK)
+			tickVoices++;
+		actCount++;
+		act = act->next;
+	}
+	if (pool)
+		tickVoices += pool->Render();
+	// Voices that do not support TickBlock are not included.
+	if (timed)
+		voicePolicy->EndRender(frames, actCount - tickVoices);
+
+	if (tickVoices == 0)
+	{
+		// Everything is in the mixer block buffers.
+		instMgr->TickBlock(frames);
+		if (tickCB)
+		{
+			for (bsInt32 n = 0; n < frames; n++)
+			{
+				seqTick++;
+				if (++tickCount >= tickWrap)
+				{
+					tickCB(++wrapCount, tickArg);
+					tickCount = 0;
+				}
+			}
+		}
+		else
+			seqTick += frames;
+		return actCount;
+	}
+
+	bsInt32 tickBlk = frames;
+	do
+	{
+		if (tickVoices)
+		{
+			act = actHead->next;
+			while (act != actTail)
+			{
+				if (!(act->flags & SEQ_AE_TICK))
+				{
+					act = act->next;
+					continue;
+				}
+				ins = act->ip;
+				if (act->ison == SEQ_AE_ON)
+				{
+					ins->Tick();
+					if ((act->flags & SEQ_AE_TM) && --act->count == 0)
+					{
+						ins->Stop();
+						act->ison = SEQ_AE_REL;
+					}
+					act = act->next;
+				}
+				else if (act->ison == SEQ_AE_REL)
+				{
+					if (ins->IsFinished())
+					{
+						instMgr->Deallocate(ins, act->ic);
+						ActiveEvent *p = act->Remove();
+						FreeActive(act);
+						act = p;
+						actCount--;
+						tickVoices--;
+					}
+					else
+					{
+						ins->Tick();
+						act = act->next;
+					}
+				}
+			}
+		}
+		instMgr->Tick();
+
+		seqTick++;
+		if (tickCB && ++tickCount >= tickWrap)
+		{
+			tickCB(++wrapCount, tickArg);
+			tickCount = 0;
+		}
+	} while (--tickBlk > 0);
+
+	return actCount;
+}
+
+// Remove the voices chosen by the voice policy.
+// The new note is started first so that the policy can see
+// its exclusive group and level along with the others.
+void Sequencer::StealVoices(ActiveEvent *newAct)
+{
+	ActiveEvent *act;
+	while ((act = voicePolicy->Select(actHead->next, actTail, newAct, statActive)) != 0)
+	{
+		if (act == newAct)
+			break;
+		instMgr->Deallocate(act->ip, act->ic);
+		act->Remove();
+		FreeActive(act);
+	}
+}
+
 void Sequencer::Broadcast(SeqEvent *evt)
 {
 	ActiveEvent *act;
@@ -548,6 +1287,7 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 					act->ip->Start(evt);
 					act->count = evt->duration;
 					act->ison = SEQ_AE_ON;
+					act->quiet = 0;
 				}
 				return;
 			}
@@ -556,7 +1296,7 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 			break;
 		/// FALTHROUGH on RESTART event no longer playing
 	case SEQEVT_START:
-		if (++evtActive > maxNote)
+		if (voicePolicy == 0 && ++evtActive > maxNote)
 		{
 			// This is for MIDI, or other live playback,
 			// where the instruments are not "well behaved."
@@ -570,9 +1310,9 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 				act = actHead->next;
 			if (act != actTail) // sanity check
 			{
-				instMgr->Deallocate(act->ip);
+				instMgr->Deallocate(act->ip, act->ic);
 				act->Remove();
-				delete act;
+				FreeActive(act);
 				evtActive--;
 			}
 		}
@@ -580,7 +1320,7 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 		// locate the instrument by id (inum) and return
 		// a valid instance. We then initialize the instrument
 		// by passing the event structure.
-		if ((act = new ActiveEvent) == NULL)
+		if ((act = NewActive()) == NULL)
 		{
 			playing = false;
 			return;
@@ -589,7 +1329,9 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 		act->evid = evt->evid;
 		act->ison = SEQ_AE_ON;
 		act->count = evt->duration;
+		act->quiet = 0;
 		act->chnl = evt->chnl;
+		act->ic = evt->im;
 		if ((flags & SEQ_AE_TM) && act->count == 0)
 			act->count = 1;
 		act->flags = flags;
@@ -597,7 +1339,11 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 		// assume: allocate should not fail, even if inum is invalid...
 		act->ip = instMgr->Allocate(evt);
 		if (act->ip != 0)
+		{
 			act->ip->Start(evt);
+			if (voicePolicy)
+				StealVoices(act);
+		}
 		else	// ...except if we are out of memory, so give up now.
 			playing = false;
 		break;
@@ -14,9 +14,20 @@
 #include <math.h>
 #include <SynthDefs.h>
 #include <SynthList.h>
+#include <SynthThread.h>
+#include <SynthMutex.h>
+#include <SynthSIMD.h>
+#include <WaveTable.h>
+#include <Filter.h>
 #include <SoundBank.h>
+#include <SoundBankLoader.h>
+#include <SoundBankStreamer.h>
 
 SoundBank SoundBank::SoundBankList;
+int SoundBank::mapSamples = 0;
+int SoundBank::streamMillisec = 0;
+int SoundBank::nativeSamples = 0;
+int SoundBank::preloadThreads = 1;
 
 // N.B. - this unconditionally clears the list without checking for locks.
 // The sound bank is still valid until the last lock is removed, but it
@@ -268,6 +279,95 @@ float SoundBank::Transform(short val, short tt)
 	return normalize[tt&3][val];
 }
 
+void SoundBank::Optimize()
+{
+	for (int b = 0; b < 129; b++)
+	{
+		SBInstr **instrList = instrBank[b];
+		if (instrList == 0)
+			continue;
+		for (int n = 0; n < 128; n++)
+		{
+			if (instrList[n] == 0)
+				continue;
+			SBZone *zone = 0;
+			while ((zone = instrList[n]->zoneList.EnumItem(zone)) != 0)
+				zone->Precompute();
+		}
+	}
+}
+
+// Everything in here is constant for the zone.
+// Values that depend on key, velocity or controllers
+// are left to the player.
+void SBZone::Precompute()
+{
+	derivedRate = synthParams.sampleRate;
+
+	if (rate != synthParams.isampleRate)
+	{
+		double wsrCents = 1200.0 * SoundBank::log2((double)rate/440.0);
+		double srCents = 1200.0 * SoundBank::log2((double)synthParams.sampleRate/440.0);
+		rateCents = FrqValue(wsrCents - srCents);
+	}
+	else
+		rateCents = 0;
+
+	vibLfoHz = SoundBank::Frequency(vibLfo.rate);
+	vibDelayN = (bsInt32) (SoundBank::EnvRate(vibLfo.delay) * synthParams.sampleRate);
+	modLfoHz = SoundBank::Frequency(modLfo.rate);
+	modDelayN = (bsInt32) (SoundBank::EnvRate(modLfo.delay) * synthParams.sampleRate);
+
+	volRt.delay = SoundBank::EnvRate(volEg.delay);
+	volRt.attack = SoundBank::EnvRate(volEg.attack);
+	volRt.hold = SoundBank::EnvRate(volEg.hold);
+	volRt.decay = SoundBank::EnvRate(volEg.decay);
+	volRt.release = SoundBank::EnvRate(volEg.release);
+	if (genFlags & SBGEN_SF2)
+	{
+		if (volEg.sustain <= 0)
+			volRt.sustain = 1.0;
+		else if (volEg.sustain < 960.0)
+			volRt.sustain = (960.0 - volEg.sustain) / 960.0;
+		else
+			volRt.sustain = 0.0;
+	}
+	else
+		volRt.sustain = volEg.sustain * 0.001;
+
+	modRt.delay = SoundBank::EnvRate(modEg.delay);
+	modRt.attack = SoundBank::EnvRate(modEg.attack);
+	modRt.hold = SoundBank::EnvRate(modEg.hold);
+	modRt.decay = SoundBank::EnvRate(modEg.decay);
+	modRt.release = SoundBank::EnvRate(modEg.release);
+	if (genFlags & SBGEN_SF2)
+	{
+		if (modEg.sustain <= 0)
+			modRt.sustain = 1.0;
+		else if (modEg.sustain >= 1000.0)
+			modRt.sustain = 0.0;
+		else
+			modRt.sustain = 1.0f - (modEg.sustain * 0.001);
+	}
+	else
+		modRt.sustain = modEg.sustain * 0.001;
+
+	// The filter is only used if the cutoff is below the
+	// maximum, or a modulator can move it into range.
+	genFlags &= ~SBGEN_FILTERD;
+	float dynFilter = modLfoFlt + modLfoMwFlt + modEnvFlt;
+	if (filtFreq > SoundBank::maxFilter)
+		genFlags &= ~SBGEN_FILTERX;
+	else if ((filtFreq + dynFilter) > SoundBank::minFilter)
+		genFlags |= SBGEN_FILTERX;
+	if ((genFlags & SBGEN_FILTERX) && dynFilter > 0)
+		genFlags |= SBGEN_FILTERD;
+	filtGainQ = SoundBank::Gain(filtQ)/2.0f;
+	FilterIIR2p filt;
+	filt.CalcCoef(SoundBank::Frequency((bsInt16)filtFreq), filtGainQ);
+	filt.GetCoef(filtCoef[0], filtCoef[1], filtCoef[2]);
+}
+
 int SoundBank::OpenSampleFile()
 {
 	if (sampleFileOpen)
@@ -289,9 +389,34 @@ int SoundBank::LoadInstr(SBInstr *in)
 	if (in->loaded)
 		return 0;
 
+	// loads are serialized with the background loader
+	SoundBankLoader *ldr = loader;
+	if (ldr)
+		ldr->LockLoad();
+	int err = 0;
 	if (OpenSampleFile())
-		return -1;
-	return LoadInstr(in, sampleFile);
+		err = -1;
+	else
+		err = LoadInstr(in, sampleFile);
+	if (ldr)
+		ldr->UnlockLoad();
+	return err;
+}
+
+SBInstr *SoundBank::RequestInstr(bsInt16 bank, bsInt16 prog)
+{
+	if (loader == 0)
+		return GetInstr(bank, prog, 1);
+
+	SBInstr *in = GetInstr(bank, prog, 0);
+	if (in && !in->loaded)
+	{
+		loader->Request(this, in->bank, in->prog);
+		return 0;
+	}
+	// the loader thread may have just written the samples
+	SynthThread::MemoryFence();
+	return in;
 }
 
 int SoundBank::LoadInstr(SBInstr *in, FileReadBuf& f)
@@ -321,10 +446,19 @@ int SoundBank::LoadInstr(SBInstr *in, FileReadBuf& f)
 		}
 		if (samp)
 		{
-			if (samp->sample == 0)
+			if (!samp->IsLoaded())
 			{
 				err |= LoadSample(samp, f);
 			}
+			if (samp->IsStreamed())
+			{
+				// keep a late start point and the loop resident,
+				// including the interpolation point after the loop
+				if (zone->tableStart >= samp->residentLen)
+					err |= AddResident(samp, f, zone->tableStart, zone->tableStart + samp->residentLen);
+				if (zone->mode)
+					err |= AddResident(samp, f, zone->loopStart, zone->loopEnd + 1);
+			}
 			/*if (zone->mode && zone->peak == 0.0 && samp->sample)
 			{
 				bsInt32 sampnum = zone->loopStart;
@@ -338,6 +472,8 @@ int SoundBank::LoadInstr(SBInstr *in, FileReadBuf& f)
 			}*/
 		}
 	}
+	// samples must be visible before another thread sees 'loaded'
+	SynthThread::MemoryFence();
 	in->loaded = 1;
 	return err;
 }
@@ -348,19 +484,59 @@ static void ZeroSample(AmpValue *sp, bsInt32 len)
 		*sp++ = 0.0;
 }
 
+// Point the sample at the data in the mapped file.
+// Only mono 16-bit and SF2 24-bit samples in native byte order
+// can be read in place; anything else is loaded as usual.
+int SoundBank::MapSample(SBSample *samp)
+{
+#if SYNTH_BIG_ENDIAN
+	return -1;
+#else
+	if (sampleMapOpen < 0 || samp->channels != 1
+	 || (samp->format != 1 && samp->format != 3))
+		return -1;
+	if (sampleMapOpen == 0)
+		sampleMapOpen = sampleMap.FileOpen(file) == 0 ? 1 : -1;
+	if (sampleMapOpen < 0)
+		return -1;
+
+	size_t mapsize = sampleMap.FileSize();
+	size_t samplen = (size_t) samp->sampleLen;
+	if (samp->filepos == 0 || (samp->filepos & 1)
+	 || samp->filepos + (samplen * 2) > mapsize)
+		return -1;
+	if (samp->format == 3 && samp->filepos2 != 0)
+	{
+		if (samp->filepos2 + samplen > mapsize)
+			return -1;
+		samp->mappedLSB = sampleMap.FileData() + samp->filepos2;
+	}
+	samp->mapped = (const bsInt16 *) (sampleMap.FileData() + samp->filepos);
+	return 0;
+#endif
+}
+
 int SoundBank::LoadSample(SBSample *samp)
 {
-	if (samp->sample)
+	if (samp->IsLoaded())
 		return 0;
 
-	if (OpenSampleFile())
+	SoundBankLoader *ldr = loader;
+	if (ldr)
+		ldr->LockLoad();
+	int err = 0;
+	if (OpenSampleFile() == 0)
+		err = LoadSample(samp, sampleFile);
+	else if (!samp->IsLoaded() && MapSample(samp) != 0)
 	{
 		bsUint32 samplen = samp->sampleLen+2;
 		samp->sample = new AmpValue[samplen];
 		ZeroSample(samp->sample, samplen);
-		return -1;
+		err = -1;
 	}
-	return LoadSample(samp, sampleFile);
+	if (ldr)
+		ldr->UnlockLoad();
+	return err;
 }
 
 // We can have one block of either 1 or 2 channel,
@@ -368,7 +544,13 @@ int SoundBank::LoadSample(SBSample *samp)
 // Two zeros are added at the end as guard points.
 int SoundBank::LoadSample(SBSample *samp, FileReadBuf& f)
 {
-	if (samp->sample)
+	if (samp->IsLoaded())
+		return 0;
+	if (MapSample(samp) == 0)
+		return 0;
+	if (StreamSample(samp, f) == 0)
+		return 0;
+	if (ReadNative(samp, f) == 0)
 		return 0;
 
 	samp->sample = new AmpValue[samp->sampleLen + 2];
@@ -402,7 +584,6 @@ static float SwapFloat(float n)
 
 int SoundBank::ReadSamples1(SBSample *samp, FileReadBuf& f)
 {
-	bsInt32 cnt;
 	bsInt32 samplen = samp->sampleLen;
 	AmpValue *sp = samp->sample;
 
@@ -411,41 +592,221 @@ int SoundBank::ReadSamples1(SBSample *samp, FileReadBuf& f)
 		ZeroSample(sp, samplen+2);
 		return -1;
 	}
-	f.FileRewind(samp->filepos);
+	ReadFrames(samp, f, 0, samplen, sp);
+	sp[samplen] = 0;
+	sp[samplen+1] = 0;
+	return 0;
+}
+
+// Read part of a mono sample.
+int SoundBank::ReadFrames(SBSample *samp, FileReadBuf& f, bsInt32 first, bsInt32 count, AmpValue *sp)
+{
+	bsInt32 cnt;
+	AmpValue *start = sp;
 	if (samp->format == 0) // 8-bit
 	{
-		for (cnt = 0; cnt < samplen; cnt++)
+		f.FileRewind(samp->filepos + first);
+		for (cnt = 0; cnt < count; cnt++)
 			*sp++ = (AmpValue) (f.ReadCh() - 128) / 128.0;
 	}
 	else if (samp->format == 1 || samp->format == 3) // 16-bit
 	{
-		for (cnt = 0; cnt < samplen; cnt++)
+		f.FileRewind(samp->filepos + (first * 2));
+		for (cnt = 0; cnt < count; cnt++)
 		{
 			short val = f.ReadCh() | (f.ReadCh() << 8);
 			*sp++ = (AmpValue) val / 32768.0;
 		}
 		if (samp->format == 3 && samp->filepos2 != 0) // 24-bit SF2
 		{
-			f.FileRewind(samp->filepos2);
-			sp = samp->sample;
-			for (cnt = 0; cnt < samplen; cnt++)
+			f.FileRewind(samp->filepos2 + first);
+			sp = start;
+			for (cnt = 0; cnt < count; cnt++)
 				*sp++ += ((AmpValue) f.ReadCh() / 8388608.0);
 		}
 	}
 	else if (samp->format == 2) // IEEE float (rare)
 	{
+		f.FileRewind(samp->filepos + (first * 4));
 		float val;
-		for (cnt = 0; cnt < samplen; cnt++)
+		for (cnt = 0; cnt < count; cnt++)
 		{
 			f.FileRead(&val, 4);
 			*sp++ = SwapFloat(val);
 		}
 	}
-	*sp++ = 0;
-	*sp = 0;
 	return 0;
 }
 
+// Keep a mono 16-bit or 24-bit sample as integers.
+// No guard points are needed, the oscillator checks the length.
+int SoundBank::ReadNative(SBSample *samp, FileReadBuf& f)
+{
+	if (!nativeSamples || samp->channels != 1 || samp->filepos == 0
+	 || (samp->format != 1 && samp->format != 3))
+		return -1;
+	bsInt32 samplen = samp->sampleLen;
+	bsInt16 *sp = new bsInt16[samplen > 0 ? samplen : 1];
+	f.FileRewind(samp->filepos);
+	f.FileRead(sp, samplen * 2);
+#if SYNTH_BIG_ENDIAN
+	bsInt32 cnt;
+	for (cnt = 0; cnt < samplen; cnt++)
+		sp[cnt] = (bsInt16) (((sp[cnt] >> 8) & 0xff) | (sp[cnt] << 8));
+#endif
+	if (samp->format == 3 && samp->filepos2 != 0)
+	{
+		bsUint8 *lsb = new bsUint8[samplen > 0 ? samplen : 1];
+		f.FileRewind(samp->filepos2);
+		f.FileRead(lsb, samplen);
+		samp->sampleLSB = lsb;
+	}
+	samp->sample16 = sp;
+	return 0;
+}
+
+#define PCM_BLOCK 4096
+
+// Positional read; anything past the end of the file is zero.
+static void ReadAt(FileReadAt& f, void *buf, int siz, bsUint32 pos)
+{
+	int cnt = f.FileRead(buf, siz, pos);
+	if (cnt < 0)
+		cnt = 0;
+	if (cnt < siz)
+		memset((bsUint8 *) buf + cnt, 0, siz - cnt);
+}
+
+// Read a mono 16-bit or 24-bit sample with positional reads,
+// keeping it native or converting with the vector kernel.
+// The values are the same as from ReadNative() or ReadFrames().
+// This does not touch any shared state, so threads may
+// load different samples at the same time.
+int SoundBank::ReadPCM(SBSample *samp, FileReadAt& f)
+{
+	if (samp->channels != 1 || samp->filepos == 0
+	 || (samp->format != 1 && samp->format != 3)
+	 || StreamHead(samp) > 0)
+		return -1;
+	bsInt32 samplen = samp->sampleLen;
+	int has24 = samp->format == 3 && samp->filepos2 != 0;
+	if (nativeSamples)
+	{
+		bsInt16 *sp = new bsInt16[samplen > 0 ? samplen : 1];
+		ReadAt(f, sp, samplen * 2, samp->filepos);
+#if SYNTH_BIG_ENDIAN
+		bsInt32 cnt;
+		for (cnt = 0; cnt < samplen; cnt++)
+			sp[cnt] = (bsInt16) (((sp[cnt] >> 8) & 0xff) | (sp[cnt] << 8));
+#endif
+		if (has24)
+		{
+			bsUint8 *lsb = new bsUint8[samplen > 0 ? samplen : 1];
+			ReadAt(f, lsb, samplen, samp->filepos2);
+			samp->sampleLSB = lsb;
+		}
+		samp->sample16 = sp;
+		return 0;
+	}
+
+	AmpValue *sp = new AmpValue[samplen + 2];
+	bsInt16 pcm[PCM_BLOCK];
+	bsUint8 lsb[PCM_BLOCK];
+	bsInt32 first = 0;
+	while (first < samplen)
+	{
+		bsInt32 count = samplen - first;
+		if (count > PCM_BLOCK)
+			count = PCM_BLOCK;
+		ReadAt(f, pcm, count * 2, samp->filepos + (first * 2));
+#if SYNTH_BIG_ENDIAN
+		bsInt32 cnt;
+		for (cnt = 0; cnt < count; cnt++)
+			pcm[cnt] = (bsInt16) (((pcm[cnt] >> 8) & 0xff) | (pcm[cnt] << 8));
+#endif
+		if (has24)
+			ReadAt(f, lsb, count, samp->filepos2 + first);
+		synthSIMD.Pcm16(&sp[first], pcm, has24 ? lsb : 0, count);
+		first += count;
+	}
+	sp[samplen] = 0;
+	sp[samplen+1] = 0;
+	samp->sample = sp;
+	return 0;
+}
+
+// Number of frames kept resident when the sample is streamed,
+// or zero if the sample is loaded whole.
+bsInt32 SoundBank::StreamHead(SBSample *samp)
+{
+	if (streamMillisec <= 0 || samp->channels != 1 || samp->filepos == 0
+	 || samp->format < 0 || samp->format > 3)
+		return 0;
+	bsInt32 head = (bsInt32) (((double) samp->rate * streamMillisec) / 1000.0);
+	if (head < 1 || samp->sampleLen < head * 2)
+		return 0; // not worth it
+	return head;
+}
+
+// Load only the start of a long mono sample.
+// The rest is read by the streamer as the sample plays.
+int SoundBank::StreamSample(SBSample *samp, FileReadBuf& f)
+{
+	bsInt32 head = StreamHead(samp);
+	if (head <= 0)
+		return -1;
+	AmpValue *sp = new AmpValue[head];
+	ReadFrames(samp, f, 0, head, sp);
+	samp->residentLen = head;
+	samp->sample = sp;
+	return 0;
+}
+
+// Make frames [first,last) of a streamed sample resident.
+// This is called from the instrument loader for loop sections,
+// possibly while the sample is playing.
+int SoundBank::AddResident(SBSample *samp, FileReadBuf& f, bsInt32 first, bsInt32 last)
+{
+	if (first < samp->residentLen)
+		first = samp->residentLen;
+	if (last > samp->sampleLen)
+		last = samp->sampleLen;
+	if (first >= last)
+		return 0;
+	SBSampleRange *old = samp->loopRange;
+	if (old)
+	{
+		if (first >= old->first && last <= old->last)
+			return 0;
+		if (old->first < first)
+			first = old->first;
+		if (old->last > last)
+			last = old->last;
+	}
+	SBSampleRange *rng = new SBSampleRange(first, last, old);
+	ReadFrames(samp, f, first, last - first, rng->data);
+	SynthThread::MemoryFence();
+	samp->loopRange = rng;
+	return 0;
+}
+
+SBStream *SoundBank::OpenStream(SBSample *samp, bsInt32 start)
+{
+	if (streamer == 0)
+		return 0;
+	return streamer->Open(this, samp, start);
+}
+
+bsInt32 SBStream::Available()
+{
+	return (bsInt32) SynthThread::AtomicAdd(&fillPos, 0);
+}
+
+void SBStream::Close()
+{
+	SynthThread::AtomicCAS(&state, 2, 3);
+}
+
 // Two-channel samples. Allowed by DLS2, but not
 // really useful since we need a mono sample for the
 // oscillator phase to work correctly. We load these
@@ -0,0 +1,868 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file SoundBankCache.cpp Binary cache of a built soundbank.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#if _WIN32
+#include <process.h>
+#define getpid _getpid
+#endif
+#if UNIX
+#include <unistd.h>
+#endif
+#include <SynthDefs.h>
+#include <SynthString.h>
+#include <SynthList.h>
+#include <SoundBank.h>
+#include <SFFile.h>
+#include <DLSFile.h>
+#include <SoundBankCache.h>
+
+int SoundBankCache::useCache = 1;
+
+// Sections of the cache file
+#define SBC_SAMPLE 0
+#define SBC_INSTR  1
+#define SBC_GROUP  2
+#define SBC_ZONE   3
+#define SBC_MOD    4
+#define SBC_REF    5 ///< zone numbers for each group, in AddZone() order
+#define SBC_STR    6 ///< string table, offset 0 is the empty string
+
+struct sbcSample
+{
+	bsUint32 filepos;
+	bsUint32 filepos2;
+	bsInt32  rate;
+	bsInt32  sampleLen;
+	bsInt32  index;
+	bsInt32  link;      ///< linked sample record or -1
+	bsInt16  format;
+	bsInt16  channels;
+};
+
+struct sbcInstr
+{
+	bsUint32 name;
+	bsInt16  instrNdx;
+	bsInt16  bank;
+	bsInt16  prog;
+	bsInt16  pad;
+	bsInt32  firstGroup;
+	bsInt32  numGroups;
+	bsInt32  firstZone;
+	bsInt32  numZones;
+	bsInt32  firstMod;
+	bsInt32  numMods;
+};
+
+struct sbcGroup
+{
+	bsInt16  lowKey;
+	bsInt16  highKey;
+	bsInt16  lowVel;
+	bsInt16  highVel;
+	bsInt16  index;
+	bsInt16  global;
+	bsInt32  firstMod;
+	bsInt32  numMods;
+	bsInt32  firstRef;
+	bsInt32  numRefs;
+};
+
+struct sbcZone
+{
+	bsUint32  name;
+	bsInt32   sample;   ///< sample record or -1
+	bsInt32   link;     ///< linked zone record or -1
+	bsInt32   firstMod;
+	bsInt32   numMods;
+	bsInt16   zoneNdx;
+	bsInt16   sampleNdx;
+	AmpValue  pan;
+	FrqValue  rate;
+	FrqValue  recCents;
+	FrqValue  recFreq;
+	bsInt32   tableStart;
+	bsInt32   tableEnd;
+	bsInt32   loopStart;
+	bsInt32   loopEnd;
+	bsInt32   loopLen;
+	bsInt32   recPeriod;
+	bsInt16   keyNum;
+	bsInt16   cents;
+	bsInt16   chan;
+	bsInt16   mode;
+	bsInt16   lowKey;
+	bsInt16   highKey;
+	bsInt16   lowVel;
+	bsInt16   highVel;
+	bsInt16   exclNote;
+	bsInt16   exclSelf;
+	bsInt16   fixedKey;
+	bsInt16   fixedVel;
+	bsInt16   fineTune;
+	bsInt16   coarseTune;
+	bsInt16   scaleTune;
+	bsInt16   pad;
+	SBEnv     volEg;
+	SBEnv     modEg;
+	SBLfo     vibLfo;
+	SBLfo     modLfo;
+	AmpValue  velScale;
+	FrqValue  velFlt;
+	AmpValue  initAtten;
+	FrqValue  vibLfoFrq;
+	FrqValue  vibLfoMwFrq;
+	AmpValue  modLfoVol;
+	FrqValue  modLfoFlt;
+	FrqValue  modLfoFrq;
+	FrqValue  modLfoMwFrq;
+	FrqValue  modLfoMwFlt;
+	AmpValue  modLfoMwVol;
+	FrqValue  modEnvFrq;
+	FrqValue  modEnvFlt;
+	FrqValue  filtFreq;
+	AmpValue  filtQ;
+	AmpValue  reverb;
+	AmpValue  chorus;
+	bsUint32  genFlags;
+	AmpValue  peak;
+};
+
+struct sbcMod
+{
+	bsInt16 srcOp;
+	bsInt16 srcNf;
+	bsInt16 ctlOp;
+	bsInt16 ctlNf;
+	bsInt16 dstOp;
+	bsInt16 trnOp;
+	float   scale;
+};
+
+static void InitHeader(sbcHeader& hdr)
+{
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, "BSBC", 4);
+	hdr.version = SBCACHE_VERSION;
+	hdr.byteOrder = 0x01020304;
+	hdr.recSize[SBC_SAMPLE] = sizeof(sbcSample);
+	hdr.recSize[SBC_INSTR] = sizeof(sbcInstr);
+	hdr.recSize[SBC_GROUP] = sizeof(sbcGroup);
+	hdr.recSize[SBC_ZONE] = sizeof(sbcZone);
+	hdr.recSize[SBC_MOD] = sizeof(sbcMod);
+}
+
+static const size_t secRecSize[7] =
+{
+	sizeof(sbcSample), sizeof(sbcInstr), sizeof(sbcGroup),
+	sizeof(sbcZone), sizeof(sbcMod), sizeof(bsInt32), 1
+};
+
+void SoundBankCache::CacheName(const char *fname, bsString& cname)
+{
+	cname = fname;
+	cname += ".bsc";
+}
+
+SoundBank *SoundBankCache::LoadSoundBank(const char *fname, int pre, SBLoadCB cb, Opaque usr)
+{
+	bsString cname;
+	CacheName(fname, cname);
+
+	SoundBank *bnk = 0;
+	if (useCache && (bnk = ReadCache(cname, fname, pre, cb, usr)) != 0)
+		return bnk;
+
+	if (SFFile::IsSF2File(fname))
+	{
+		SFFile sf;
+		bnk = sf.LoadSoundBank(fname, pre, cb, usr);
+	}
+	else if (DLSFile::IsDLSFile(fname))
+	{
+		DLSFile dls;
+		bnk = dls.LoadSoundBank(fname, pre, cb, usr);
+	}
+	if (bnk && useCache)
+		WriteCache(bnk, cname, fname);
+	return bnk;
+}
+
+/////////////////////////////////////////////////////////////
+// Writing
+/////////////////////////////////////////////////////////////
+
+// Strings are added to the table as they are found.
+class sbcStrings
+{
+public:
+	char *data;
+	bsUint32 size;
+
+	sbcStrings()
+	{
+		data = 0;
+		size = 1; // empty string at 0
+	}
+
+	bsUint32 Add(const char *str)
+	{
+		size_t len = str ? strlen(str) : 0;
+		if (len == 0)
+			return 0;
+		bsUint32 off = size;
+		if (data)
+			memcpy(&data[off], str, len+1);
+		size += (bsUint32) len + 1;
+		return off;
+	}
+};
+
+static bsInt32 CountMods(SBModList *ml)
+{
+	bsInt32 n = 0;
+	SBModInfo *mi = 0;
+	while ((mi = ml->EnumModInfo(mi)) != 0)
+		n++;
+	return n;
+}
+
+static void SaveMods(SBModList *ml, sbcMod *mods, bsInt32& modNum, bsInt32& first, bsInt32& num)
+{
+	first = modNum;
+	SBModInfo *mi = 0;
+	while ((mi = ml->EnumModInfo(mi)) != 0)
+	{
+		sbcMod *mp = &mods[modNum++];
+		mp->srcOp = mi->srcOp;
+		mp->srcNf = mi->srcNf;
+		mp->ctlOp = mi->ctlOp;
+		mp->ctlNf = mi->ctlNf;
+		mp->dstOp = mi->dstOp;
+		mp->trnOp = mi->trnOp;
+		mp->scale = mi->scale;
+	}
+	num = modNum - first;
+}
+
+// Sample record numbers, sorted by address for lookup.
+struct sbcSampleRef
+{
+	SBSample *samp;
+	bsInt32 num;
+};
+
+static int CompareSampleRef(const void *p1, const void *p2)
+{
+	const SBSample *s1 = ((const sbcSampleRef *) p1)->samp;
+	const SBSample *s2 = ((const sbcSampleRef *) p2)->samp;
+	if (s1 < s2)
+		return -1;
+	if (s1 > s2)
+		return 1;
+	return 0;
+}
+
+class sbcSampleMap
+{
+public:
+	sbcSampleRef *refs;
+	size_t count;
+
+	sbcSampleMap(SoundBank *bnk)
+	{
+		count = 0;
+		SBSample *sp;
+		for (sp = bnk->samples; sp; sp = sp->next)
+			count++;
+		refs = new sbcSampleRef[count + 1];
+		count = 0;
+		for (sp = bnk->samples; sp; sp = sp->next)
+		{
+			refs[count].samp = sp;
+			refs[count].num = (bsInt32) count;
+			count++;
+		}
+		qsort(refs, count, sizeof(sbcSampleRef), CompareSampleRef);
+	}
+
+	~sbcSampleMap()
+	{
+		delete[] refs;
+	}
+
+	/// Find the sample record number, or -1 for none.
+	bsInt32 Find(SBSample *samp)
+	{
+		if (samp == 0)
+			return -1;
+		sbcSampleRef key;
+		key.samp = samp;
+		sbcSampleRef *ref = (sbcSampleRef *) bsearch(&key, refs, count, sizeof(sbcSampleRef), CompareSampleRef);
+		return ref ? ref->num : -1;
+	}
+};
+
+// A zone belongs to a group when it is in the group key map.
+// AddZone() puts the zone on every key in range, so only the
+// first key needs to be checked.
+static int InGroup(SBZoneGroup *grp, SBZone *zone)
+{
+	int lo = zone->lowKey > grp->lowKey ? zone->lowKey : grp->lowKey;
+	int hi = zone->highKey < grp->highKey ? zone->highKey : grp->highKey;
+	if (lo > hi || lo < 0 || lo > 127)
+		return 0;
+	SBZoneRef *ref;
+	for (ref = grp->map[lo]; ref; ref = ref->next)
+	{
+		if (ref->zone == zone)
+			return 1;
+	}
+	return 0;
+}
+
+// Walk the soundbank, counting records when the arrays are NULL,
+// or filling the arrays otherwise.
+static void SaveBank(SoundBank *bnk, sbcHeader& hdr, sbcSample *samples, sbcInstr *instrs,
+	sbcGroup *groups, sbcZone *zones, sbcMod *mods, bsInt32 *refs, sbcStrings& str, sbcSampleMap& smap)
+{
+	bsInt32 sampNum = 0;
+	bsInt32 instrNum = 0;
+	bsInt32 grpNum = 0;
+	bsInt32 zoneNum = 0;
+	bsInt32 modNum = 0;
+	bsInt32 refNum = 0;
+
+	SBSample *samp;
+	for (samp = bnk->samples; samp; samp = samp->next, sampNum++)
+	{
+		if (samples)
+		{
+			sbcSample *sp = &samples[sampNum];
+			sp->filepos = samp->filepos;
+			sp->filepos2 = samp->filepos2;
+			sp->rate = samp->rate;
+			sp->sampleLen = samp->sampleLen;
+			sp->index = samp->index;
+			sp->link = smap.Find(samp->linkSamp);
+			sp->format = samp->format;
+			sp->channels = samp->channels;
+		}
+	}
+
+	for (int b = 0; b < 129; b++)
+	{
+		SBInstr **instrList = bnk->instrBank[b];
+		if (instrList == 0)
+			continue;
+		for (int p = 0; p < 128; p++)
+		{
+			SBInstr *in = instrList[p];
+			if (in == 0)
+				continue;
+
+			bsInt32 zone0 = zoneNum;
+			SBZone *zone = 0;
+			while ((zone = in->EnumZones(zone)) != 0)
+			{
+				if (zones)
+				{
+					sbcZone *zp = &zones[zoneNum];
+					zp->name = str.Add(zone->name);
+					zp->sample = smap.Find(zone->sample);
+					zp->link = -1;
+					if (zone->linkZone)
+					{
+						bsInt32 zn = zone0;
+						SBZone *lz = 0;
+						while ((lz = in->EnumZones(lz)) != 0 && lz != zone->linkZone)
+							zn++;
+						if (lz)
+							zp->link = zn;
+					}
+					SaveMods(zone, mods, modNum, zp->firstMod, zp->numMods);
+					zp->zoneNdx = zone->zoneNdx;
+					zp->sampleNdx = zone->sampleNdx;
+					zp->pan = zone->pan;
+					zp->rate = zone->rate;
+					zp->recCents = zone->recCents;
+					zp->recFreq = zone->recFreq;
+					zp->tableStart = zone->tableStart;
+					zp->tableEnd = zone->tableEnd;
+					zp->loopStart = zone->loopStart;
+					zp->loopEnd = zone->loopEnd;
+					zp->loopLen = zone->loopLen;
+					zp->recPeriod = zone->recPeriod;
+					zp->keyNum = zone->keyNum;
+					zp->cents = zone->cents;
+					zp->chan = zone->chan;
+					zp->mode = zone->mode;
+					zp->lowKey = zone->lowKey;
+					zp->highKey = zone->highKey;
+					zp->lowVel = zone->lowVel;
+					zp->highVel = zone->highVel;
+					zp->exclNote = zone->exclNote;
+					zp->exclSelf = zone->exclSelf;
+					zp->fixedKey = zone->fixedKey;
+					zp->fixedVel = zone->fixedVel;
+					zp->fineTune = zone->fineTune;
+					zp->coarseTune = zone->coarseTune;
+					zp->scaleTune = zone->scaleTune;
+					zp->volEg = zone->volEg;
+					zp->modEg = zone->modEg;
+					zp->vibLfo = zone->vibLfo;
+					zp->modLfo = zone->modLfo;
+					zp->velScale = zone->velScale;
+					zp->velFlt = zone->velFlt;
+					zp->initAtten = zone->initAtten;
+					zp->vibLfoFrq = zone->vibLfoFrq;
+					zp->vibLfoMwFrq = zone->vibLfoMwFrq;
+					zp->modLfoVol = zone->modLfoVol;
+					zp->modLfoFlt = zone->modLfoFlt;
+					zp->modLfoFrq = zone->modLfoFrq;
+					zp->modLfoMwFrq = zone->modLfoMwFrq;
+					zp->modLfoMwFlt = zone->modLfoMwFlt;
+					zp->modLfoMwVol = zone->modLfoMwVol;
+					zp->modEnvFrq = zone->modEnvFrq;
+					zp->modEnvFlt = zone->modEnvFlt;
+					zp->filtFreq = zone->filtFreq;
+					zp->filtQ = zone->filtQ;
+					zp->reverb = zone->reverb;
+					zp->chorus = zone->chorus;
+					zp->genFlags = zone->genFlags;
+					zp->peak = zone->peak;
+				}
+				else
+				{
+					str.Add(zone->name);
+					modNum += CountMods(zone);
+				}
+				zoneNum++;
+			}
+
+			bsInt32 grp0 = grpNum;
+			SBZoneGroup *grp = 0;
+			while ((grp = in->EnumGroups(grp)) != 0)
+			{
+				bsInt32 ref0 = refNum;
+				bsInt32 zn = zone0;
+				zone = 0;
+				while ((zone = in->EnumZones(zone)) != 0)
+				{
+					if (InGroup(grp, zone))
+					{
+						if (refs)
+							refs[refNum] = zn;
+						refNum++;
+					}
+					zn++;
+				}
+				if (groups)
+				{
+					sbcGroup *gp = &groups[grpNum];
+					gp->lowKey = grp->lowKey;
+					gp->highKey = grp->highKey;
+					gp->lowVel = grp->lowVel;
+					gp->highVel = grp->highVel;
+					gp->index = grp->index;
+					gp->global = grp->global;
+					gp->firstRef = ref0;
+					gp->numRefs = refNum - ref0;
+					SaveMods(grp, mods, modNum, gp->firstMod, gp->numMods);
+				}
+				else
+					modNum += CountMods(grp);
+				grpNum++;
+			}
+
+			if (instrs)
+			{
+				sbcInstr *ip = &instrs[instrNum];
+				ip->name = str.Add(in->instrName);
+				ip->instrNdx = in->instrNdx;
+				ip->bank = in->bank;
+				ip->prog = in->prog;
+				ip->firstGroup = grp0;
+				ip->numGroups = grpNum - grp0;
+				ip->firstZone = zone0;
+				ip->numZones = zoneNum - zone0;
+				SaveMods(in, mods, modNum, ip->firstMod, ip->numMods);
+			}
+			else
+			{
+				str.Add(in->instrName);
+				modNum += CountMods(in);
+			}
+			instrNum++;
+		}
+	}
+
+	SBInfo& info = bnk->info;
+	hdr.fileVer[0] = info.wMajorFile;
+	hdr.fileVer[1] = info.wMinorFile;
+	hdr.fileVer[2] = info.wMajorVer;
+	hdr.fileVer[3] = info.wMinorVer;
+	hdr.infoStr[0] = str.Add(info.szSoundEngine);
+	hdr.infoStr[1] = str.Add(info.szName);
+	hdr.infoStr[2] = str.Add(info.szDate);
+	hdr.infoStr[3] = str.Add(info.szEng);
+	hdr.infoStr[4] = str.Add(info.szProduct);
+	hdr.infoStr[5] = str.Add(info.szCopyright);
+	hdr.infoStr[6] = str.Add(info.szComment);
+	hdr.infoStr[7] = str.Add(info.szTools);
+	hdr.chnls = bnk->chnls;
+
+	hdr.secCount[SBC_SAMPLE] = sampNum;
+	hdr.secCount[SBC_INSTR] = instrNum;
+	hdr.secCount[SBC_GROUP] = grpNum;
+	hdr.secCount[SBC_ZONE] = zoneNum;
+	hdr.secCount[SBC_MOD] = modNum;
+	hdr.secCount[SBC_REF] = refNum;
+	hdr.secCount[SBC_STR] = str.size;
+}
+
+int SoundBankCache::WriteCache(SoundBank *bnk, const char *cname, const char *fname)
+{
+	sbcHeader hdr;
+	InitHeader(hdr);
+	if (SynthFileInfo(fname, hdr.srcSize, hdr.srcTime) != 0)
+		return -1;
+
+	// count, then fill
+	sbcStrings str;
+	sbcSampleMap smap(bnk);
+	SaveBank(bnk, hdr, 0, 0, 0, 0, 0, 0, str, smap);
+
+	void *sec[7];
+	bsUint32 offs = (sizeof(hdr) + 7) & ~7;
+	int n;
+	for (n = 0; n < 7; n++)
+	{
+		size_t len = (size_t) hdr.secCount[n] * secRecSize[n];
+		sec[n] = new char[len > 0 ? len : 1];
+		memset(sec[n], 0, len > 0 ? len : 1);
+		hdr.secOffs[n] = offs;
+		offs = (offs + (bsUint32) len + 7) & ~7;
+	}
+	str.data = (char *) sec[SBC_STR];
+	str.size = 1;
+	SaveBank(bnk, hdr, (sbcSample *) sec[SBC_SAMPLE], (sbcInstr *) sec[SBC_INSTR],
+		(sbcGroup *) sec[SBC_GROUP], (sbcZone *) sec[SBC_ZONE], (sbcMod *) sec[SBC_MOD],
+		(bsInt32 *) sec[SBC_REF], str, smap);
+
+	// Write to a name for this process, then rename it over the cache.
+	// Another process may have the old cache mapped, and must not see
+	// a partly written file.
+	bsString tname(cname);
+	tname += ".";
+	tname.Append((long) getpid());
+	tname += ".tmp";
+
+	int err = 0;
+	FileWriteUnBuf wf;
+	if (wf.FileOpen(tname) != 0)
+		err = -1;
+	else
+	{
+		static char zeros[8];
+		bsUint32 pos = sizeof(hdr);
+		if (wf.FileWrite(&hdr, sizeof(hdr)) != (int) sizeof(hdr))
+			err = -1;
+		for (n = 0; n < 7 && !err; n++)
+		{
+			size_t len = (size_t) hdr.secCount[n] * secRecSize[n];
+			if (hdr.secOffs[n] > pos)
+				wf.FileWrite(zeros, hdr.secOffs[n] - pos);
+			if (len > 0 && wf.FileWrite(sec[n], len) != (int) len)
+				err = -1;
+			pos = hdr.secOffs[n] + (bsUint32) len;
+		}
+		if (wf.FileClose() != 0)
+			err = -1;
+		if (err == 0 && SynthRenameFile(tname, cname) != 0)
+			err = -1;
+		if (err)
+			SynthDeleteFile(tname);
+	}
+	for (n = 0; n < 7; n++)
+		delete[] (char *) sec[n];
+	return err;
+}
+
+/////////////////////////////////////////////////////////////
+// Reading
+/////////////////////////////////////////////////////////////
+
+static int CheckHeader(const sbcHeader *hdr, size_t size, bsUint32 srcSize, bsUint32 srcTime)
+{
+	sbcHeader chk;
+	InitHeader(chk);
+	if (memcmp(hdr->magic, chk.magic, 4) != 0
+	 || hdr->version != chk.version
+	 || hdr->byteOrder != chk.byteOrder
+	 || memcmp(hdr->recSize, chk.recSize, sizeof(chk.recSize)) != 0
+	 || hdr->srcSize != srcSize
+	 || hdr->srcTime != srcTime)
+		return -1;
+	for (int n = 0; n < 7; n++)
+	{
+		if (hdr->secOffs[n] & 7 || hdr->secOffs[n] > size
+		 || (size - hdr->secOffs[n]) / secRecSize[n] < hdr->secCount[n])
+			return -1;
+	}
+	// the string table must start with the empty string and end with a terminator
+	const char *strs = (const char *) hdr + hdr->secOffs[SBC_STR];
+	bsUint32 strSize = hdr->secCount[SBC_STR];
+	if (strSize == 0 || strs[0] != 0 || strs[strSize-1] != 0)
+		return -1;
+	return 0;
+}
+
+static void LoadMods(SBModList *ml, const sbcMod *mods, bsInt32 first, bsInt32 num)
+{
+	const sbcMod *mp = &mods[first];
+	while (--num >= 0)
+	{
+		SBModInfo *mi = ml->AddModInfo();
+		mi->srcOp = mp->srcOp;
+		mi->srcNf = mp->srcNf;
+		mi->ctlOp = mp->ctlOp;
+		mi->ctlNf = mp->ctlNf;
+		mi->dstOp = mp->dstOp;
+		mi->trnOp = mp->trnOp;
+		mi->scale = mp->scale;
+		mp++;
+	}
+}
+
+// Check that [first, first+num) is inside a section of cnt records.
+static inline int BadRange(bsInt32 first, bsInt32 num, bsUint32 cnt)
+{
+	return first < 0 || num < 0 || (bsUint32) first > cnt || (bsUint32) num > cnt - (bsUint32) first;
+}
+
+SoundBank *SoundBankCache::ReadCache(const char *cname, const char *fname, int pre, SBLoadCB cb, Opaque usr)
+{
+	bsUint32 srcSize;
+	bsUint32 srcTime;
+	if (SynthFileInfo(fname, srcSize, srcTime) != 0)
+		return 0;
+
+	FileReadMap map;
+	if (map.FileOpen(cname) != 0)
+		return 0;
+	size_t size = map.FileSize();
+	const bsUint8 *data = map.FileData();
+	const sbcHeader *hdr = (const sbcHeader *) data;
+	if (size < sizeof(sbcHeader) || CheckHeader(hdr, size, srcSize, srcTime) != 0)
+		return 0;
+
+	const sbcSample *samples = (const sbcSample *) (data + hdr->secOffs[SBC_SAMPLE]);
+	const sbcInstr *instrs = (const sbcInstr *) (data + hdr->secOffs[SBC_INSTR]);
+	const sbcGroup *groups = (const sbcGroup *) (data + hdr->secOffs[SBC_GROUP]);
+	const sbcZone *zones = (const sbcZone *) (data + hdr->secOffs[SBC_ZONE]);
+	const sbcMod *mods = (const sbcMod *) (data + hdr->secOffs[SBC_MOD]);
+	const bsInt32 *refs = (const bsInt32 *) (data + hdr->secOffs[SBC_REF]);
+	const char *strs = (const char *) (data + hdr->secOffs[SBC_STR]);
+	bsUint32 sampCount = hdr->secCount[SBC_SAMPLE];
+	bsUint32 zoneCount = hdr->secCount[SBC_ZONE];
+	bsUint32 strSize = hdr->secCount[SBC_STR];
+	bsUint32 n;
+
+	// all record numbers are checked before anything is built
+	for (n = 0; n < sampCount; n++)
+	{
+		if (samples[n].link >= (bsInt32) sampCount)
+			return 0;
+	}
+	for (n = 0; n < zoneCount; n++)
+	{
+		const sbcZone *zp = &zones[n];
+		if (zp->sample >= (bsInt32) sampCount || zp->link >= (bsInt32) zoneCount
+		 || zp->name >= strSize || BadRange(zp->firstMod, zp->numMods, hdr->secCount[SBC_MOD]))
+			return 0;
+	}
+	for (n = 0; n < hdr->secCount[SBC_GROUP]; n++)
+	{
+		const sbcGroup *gp = &groups[n];
+		if (BadRange(gp->firstMod, gp->numMods, hdr->secCount[SBC_MOD])
+		 || BadRange(gp->firstRef, gp->numRefs, hdr->secCount[SBC_REF]))
+			return 0;
+	}
+	for (n = 0; n < hdr->secCount[SBC_REF]; n++)
+	{
+		if (refs[n] < 0 || refs[n] >= (bsInt32) zoneCount)
+			return 0;
+	}
+	for (n = 0; n < hdr->secCount[SBC_INSTR]; n++)
+	{
+		const sbcInstr *ip = &instrs[n];
+		if (ip->name >= strSize || ip->bank < 0 || ip->bank > 128
+		 || ip->prog < 0 || ip->prog > 127
+		 || BadRange(ip->firstMod, ip->numMods, hdr->secCount[SBC_MOD])
+		 || BadRange(ip->firstGroup, ip->numGroups, hdr->secCount[SBC_GROUP])
+		 || BadRange(ip->firstZone, ip->numZones, zoneCount))
+			return 0;
+	}
+	for (n = 0; n < 8; n++)
+	{
+		if (hdr->infoStr[n] >= strSize)
+			return 0;
+	}
+
+	SoundBank *bnk = new SoundBank;
+	bnk->file = fname;
+	bnk->chnls = hdr->chnls;
+	bnk->info.wMajorFile = hdr->fileVer[0];
+	bnk->info.wMinorFile = hdr->fileVer[1];
+	bnk->info.wMajorVer = hdr->fileVer[2];
+	bnk->info.wMinorVer = hdr->fileVer[3];
+	bnk->info.szSoundEngine = &strs[hdr->infoStr[0]];
+	bnk->info.szName = &strs[hdr->infoStr[1]];
+	bnk->info.szDate = &strs[hdr->infoStr[2]];
+	bnk->info.szEng = &strs[hdr->infoStr[3]];
+	bnk->info.szProduct = &strs[hdr->infoStr[4]];
+	bnk->info.szCopyright = &strs[hdr->infoStr[5]];
+	bnk->info.szComment = &strs[hdr->infoStr[6]];
+	bnk->info.szTools = &strs[hdr->infoStr[7]];
+
+	// AddSample() puts the sample at the front of the list,
+	// so add them in reverse to keep the original order.
+	SBSample **sampList = new SBSample*[sampCount + 1];
+	n = sampCount;
+	while (n-- > 0)
+	{
+		const sbcSample *sp = &samples[n];
+		SBSample *samp = bnk->AddSample(sp->index);
+		samp->filepos = sp->filepos;
+		samp->filepos2 = sp->filepos2;
+		samp->rate = sp->rate;
+		samp->sampleLen = sp->sampleLen;
+		samp->format = sp->format;
+		samp->channels = sp->channels;
+		sampList[n] = samp;
+	}
+	for (n = 0; n < sampCount; n++)
+	{
+		if (samples[n].link >= 0)
+			sampList[n]->linkSamp = sampList[samples[n].link];
+	}
+
+	SBZone **zoneList = new SBZone*[zoneCount + 1];
+	memset(zoneList, 0, sizeof(SBZone*) * (zoneCount + 1));
+	for (n = 0; n < hdr->secCount[SBC_INSTR]; n++)
+	{
+		const sbcInstr *ip = &instrs[n];
+		SBInstr *in = bnk->AddInstr(ip->bank, ip->prog);
+		in->instrName = &strs[ip->name];
+		in->instrNdx = ip->instrNdx;
+		LoadMods(in, mods, ip->firstMod, ip->numMods);
+
+		bsInt32 zn;
+		for (zn = ip->firstZone; zn < ip->firstZone + ip->numZones; zn++)
+		{
+			const sbcZone *zp = &zones[zn];
+			SBZone *zone = in->AddZone();
+			zoneList[zn] = zone;
+			zone->name = &strs[zp->name];
+			zone->sample = zp->sample >= 0 ? sampList[zp->sample] : 0;
+			LoadMods(zone, mods, zp->firstMod, zp->numMods);
+			zone->zoneNdx = zp->zoneNdx;
+			zone->sampleNdx = zp->sampleNdx;
+			zone->pan = zp->pan;
+			zone->rate = zp->rate;
+			zone->recCents = zp->recCents;
+			zone->recFreq = zp->recFreq;
+			zone->tableStart = zp->tableStart;
+			zone->tableEnd = zp->tableEnd;
+			zone->loopStart = zp->loopStart;
+			zone->loopEnd = zp->loopEnd;
+			zone->loopLen = zp->loopLen;
+			zone->recPeriod = zp->recPeriod;
+			zone->keyNum = zp->keyNum;
+			zone->cents = zp->cents;
+			zone->chan = zp->chan;
+			zone->mode = zp->mode;
+			zone->lowKey = zp->lowKey;
+			zone->highKey = zp->highKey;
+			zone->lowVel = zp->lowVel;
+			zone->highVel = zp->highVel;
+			zone->exclNote = zp->exclNote;
+			zone->exclSelf = zp->exclSelf;
+			zone->fixedKey = zp->fixedKey;
+			zone->fixedVel = zp->fixedVel;
+			zone->fineTune = zp->fineTune;
+			zone->coarseTune = zp->coarseTune;
+			zone->scaleTune = zp->scaleTune;
+			zone->volEg = zp->volEg;
+			zone->modEg = zp->modEg;
+			zone->vibLfo = zp->vibLfo;
+			zone->modLfo = zp->modLfo;
+			zone->velScale = zp->velScale;
+			zone->velFlt = zp->velFlt;
+			zone->initAtten = zp->initAtten;
+			zone->vibLfoFrq = zp->vibLfoFrq;
+			zone->vibLfoMwFrq = zp->vibLfoMwFrq;
+			zone->modLfoVol = zp->modLfoVol;
+			zone->modLfoFlt = zp->modLfoFlt;
+			zone->modLfoFrq = zp->modLfoFrq;
+			zone->modLfoMwFrq = zp->modLfoMwFrq;
+			zone->modLfoMwFlt = zp->modLfoMwFlt;
+			zone->modLfoMwVol = zp->modLfoMwVol;
+			zone->modEnvFrq = zp->modEnvFrq;
+			zone->modEnvFlt = zp->modEnvFlt;
+			zone->filtFreq = zp->filtFreq;
+			zone->filtQ = zp->filtQ;
+			zone->reverb = zp->reverb;
+			zone->chorus = zp->chorus;
+			zone->genFlags = zp->genFlags;
+			zone->peak = zp->peak;
+		}
+
+		bsInt32 gn;
+		for (gn = ip->firstGroup; gn < ip->firstGroup + ip->numGroups; gn++)
+		{
+			const sbcGroup *gp = &groups[gn];
+			SBZoneGroup *grp = in->AddGroup();
+			grp->lowKey = gp->lowKey;
+			grp->highKey = gp->highKey;
+			grp->lowVel = gp->lowVel;
+			grp->highVel = gp->highVel;
+			grp->index = gp->index;
+			grp->global = gp->global;
+			LoadMods(grp, mods, gp->firstMod, gp->numMods);
+			const bsInt32 *rp = &refs[gp->firstRef];
+			bsInt32 rn;
+			for (rn = 0; rn < gp->numRefs; rn++, rp++)
+			{
+				if (zoneList[*rp])
+					grp->AddZone(zoneList[*rp]);
+			}
+		}
+	}
+
+	for (n = 0; n < zoneCount; n++)
+	{
+		if (zoneList[n] && zones[n].link >= 0)
+			zoneList[n]->linkZone = zoneList[zones[n].link];
+	}
+
+	delete[] sampList;
+	delete[] zoneList;
+
+	if (pre)
+		bnk->PreloadSamples(SoundBank::preloadThreads, cb, usr);
+	bnk->Optimize();
+	return bnk;
+}
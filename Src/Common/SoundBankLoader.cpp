@@ -0,0 +1,469 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file SoundBankLoader.cpp Background loading of soundbank instruments.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SynthDefs.h>
+#include <SynthString.h>
+#include <SynthList.h>
+#include <SynthThread.h>
+#include <SynthMutex.h>
+#include <SoundBank.h>
+#include <SoundBankLoader.h>
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#if UNIX
+#include <time.h>
+#endif
+
+// Time in seconds for latency measurement.
+static double LoaderTime()
+{
+#if _WIN32
+	LARGE_INTEGER cnt;
+	LARGE_INTEGER frq;
+	QueryPerformanceCounter(&cnt);
+	QueryPerformanceFrequency(&frq);
+	return (double) cnt.QuadPart / (double) frq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + ((double) ts.tv_nsec * 1.0e-9);
+#endif
+}
+
+SoundBankLoader::SoundBankLoader()
+{
+	queueHead = 0;
+	queueCount = 0;
+	latencySum = 0;
+	running = 0;
+	memset(banks, 0, sizeof(banks));
+	queueLock.Create();
+	loadLock.Create();
+	wakeup.Create();
+}
+
+SoundBankLoader::~SoundBankLoader()
+{
+	Stop();
+	for (int n = 0; n < SBLOADER_BANKS; n++)
+	{
+		if (banks[n])
+			Detach(banks[n]);
+	}
+}
+
+int SoundBankLoader::Start()
+{
+	if (running)
+		return 0;
+	running = 1;
+	if (StartThread(0))
+	{
+		running = 0;
+		return -1;
+	}
+	return 0;
+}
+
+void SoundBankLoader::Stop()
+{
+	if (!running)
+		return;
+	SynthThread::AtomicCAS(&running, 1, 0);
+	wakeup.Wakeup();
+	WaitThread();
+	queueLock.Enter();
+	queueHead = 0;
+	queueCount = 0;
+	queueLock.Leave();
+}
+
+int SoundBankLoader::Attach(SoundBank *bnk)
+{
+	int err = -1;
+	queueLock.Enter();
+	for (int n = 0; n < SBLOADER_BANKS; n++)
+	{
+		if (banks[n] == 0)
+		{
+			banks[n] = bnk;
+			err = 0;
+			break;
+		}
+	}
+	queueLock.Leave();
+	if (err == 0)
+	{
+		bnk->Lock();
+		bnk->loader = this;
+	}
+	return err;
+}
+
+void SoundBankLoader::Detach(SoundBank *bnk)
+{
+	int found = 0;
+	queueLock.Enter();
+	for (int n = 0; n < SBLOADER_BANKS; n++)
+	{
+		if (banks[n] == bnk)
+		{
+			banks[n] = 0;
+			found = 1;
+		}
+	}
+	// remove queued requests for this bank
+	int cnt = queueCount;
+	int ndx = queueHead;
+	queueCount = 0;
+	while (--cnt >= 0)
+	{
+		LoadRequest& req = queue[ndx];
+		if (req.bnk != bnk)
+			queue[(queueHead + queueCount++) % SBLOADER_QUEUE] = req;
+		ndx = (ndx + 1) % SBLOADER_QUEUE;
+	}
+	stats.queueDepth = queueCount;
+	queueLock.Leave();
+	if (!found)
+		return;
+
+	// wait for a load in progress to finish
+	loadLock.Enter();
+	bnk->loader = 0;
+	loadLock.Leave();
+	bnk->Unlock();
+}
+
+int SoundBankLoader::Enqueue(SoundBank *bnk, bsInt16 bank, bsInt16 prog)
+{
+	int err = 0;
+	queueLock.Enter();
+	int ndx = queueHead;
+	int cnt;
+	for (cnt = queueCount; cnt > 0; cnt--)
+	{
+		LoadRequest& req = queue[ndx];
+		if (req.bnk == bnk && req.bank == bank && req.prog == prog)
+			break;
+		ndx = (ndx + 1) % SBLOADER_QUEUE;
+	}
+	if (cnt == 0)
+	{
+		if (queueCount < SBLOADER_QUEUE)
+		{
+			LoadRequest& req = queue[(queueHead + queueCount) % SBLOADER_QUEUE];
+			req.bnk = bnk;
+			req.bank = bank;
+			req.prog = prog;
+			req.time = LoaderTime();
+			stats.requests++;
+			stats.queueDepth = ++queueCount;
+			if (queueCount > stats.queuePeak)
+				stats.queuePeak = queueCount;
+		}
+		else
+		{
+			stats.dropped++;
+			err = -1;
+		}
+	}
+	queueLock.Leave();
+	if (err == 0)
+		wakeup.Wakeup();
+	return err;
+}
+
+int SoundBankLoader::Dequeue(LoadRequest& req)
+{
+	int found = 0;
+	queueLock.Enter();
+	if (queueCount > 0)
+	{
+		req = queue[queueHead];
+		queueHead = (queueHead + 1) % SBLOADER_QUEUE;
+		stats.queueDepth = --queueCount;
+		found = 1;
+	}
+	queueLock.Leave();
+	return found;
+}
+
+int SoundBankLoader::Request(SoundBank *bnk, bsInt16 bank, bsInt16 prog)
+{
+	return Enqueue(bnk, bank, prog);
+}
+
+int SoundBankLoader::Prefetch(bsInt16 bank, bsInt16 prog)
+{
+	return Enqueue(0, bank, prog);
+}
+
+void SoundBankLoader::Load(SoundBank *bnk, bsInt16 bank, bsInt16 prog, double time)
+{
+	// The bank may have been detached after the request was taken
+	// off the queue. Detach waits on the load lock, so the bank is
+	// valid while we hold the lock and it is still attached.
+	loadLock.Enter();
+	int attached = 0;
+	queueLock.Enter();
+	for (int n = 0; n < SBLOADER_BANKS; n++)
+	{
+		if (banks[n] == bnk)
+			attached = 1;
+	}
+	queueLock.Leave();
+
+	int done = 0;
+	if (attached)
+	{
+		SBInstr *in = bnk->GetInstr(bank, prog, 0);
+		if (in && !in->loaded && bnk->OpenSampleFile() == 0)
+		{
+			bnk->LoadInstr(in, bnk->sampleFile);
+			done = 1;
+		}
+	}
+	loadLock.Leave();
+	if (!done)
+		return;
+
+	double latency = LoaderTime() - time;
+	queueLock.Enter();
+	stats.loaded++;
+	latencySum += latency;
+	stats.latencyAvg = latencySum / (double) stats.loaded;
+	if (latency > stats.latencyMax)
+		stats.latencyMax = latency;
+	queueLock.Leave();
+}
+
+void SoundBankLoader::GetStats(SBLoaderStats& st)
+{
+	queueLock.Enter();
+	st = stats;
+	queueLock.Leave();
+}
+
+void SoundBankLoader::ResetStats()
+{
+	queueLock.Enter();
+	stats.requests = 0;
+	stats.loaded = 0;
+	stats.dropped = 0;
+	stats.queuePeak = queueCount;
+	stats.latencyAvg = 0;
+	stats.latencyMax = 0;
+	latencySum = 0;
+	queueLock.Leave();
+}
+
+/////////////////////////// PRELOAD ////////////////////////////
+
+class SBPreload;
+
+class SBPreloadWorker : public SynthThread
+{
+public:
+	SBPreload *job;
+	virtual int ThreadProc();
+};
+
+// Samples to preload. The caller's thread and the workers
+// take the next sample from the list until all are loaded.
+// Each thread has its own file handles, so the reads do not
+// contend for a file position.
+class SBPreload
+{
+public:
+	SoundBank *bnk;
+	SBSample **list;
+	long count;
+	volatile long next;
+	volatile long done;
+	volatile long errs;
+
+	SBPreload(SoundBank *b, long n)
+	{
+		bnk = b;
+		list = new SBSample*[n > 0 ? n : 1];
+		count = 0;
+		next = 0;
+		done = 0;
+		errs = 0;
+	}
+
+	~SBPreload()
+	{
+		delete[] list;
+	}
+
+	// Load samples until the list is empty.
+	// When the callback is set, progress is reported after each sample.
+	void LoadSamples(SBLoadCB cb, Opaque usr, long base, long total, double start)
+	{
+		FileReadAt fpos;
+		FileReadBuf fbuf;
+		int fposOpen = fpos.FileOpen(bnk->file) == 0;
+		int fbufOpen = 0;
+		long n;
+		while ((n = SynthThread::AtomicAdd(&next, 1) - 1) < count)
+		{
+			SBSample *samp = list[n];
+			int err = -1;
+			if (fposOpen)
+				err = bnk->ReadPCM(samp, fpos);
+			if (err)
+			{
+				if (fbufOpen == 0)
+				{
+					fbuf.SetBufSize(8192);
+					fbufOpen = fbuf.FileOpen(bnk->file) == 0 ? 1 : -1;
+				}
+				if (fbufOpen > 0)
+					err = bnk->LoadSample(samp, fbuf);
+				else
+				{
+					bsInt32 samplen = samp->sampleLen + 2;
+					samp->sample = new AmpValue[samplen];
+					memset(samp->sample, 0, samplen * sizeof(AmpValue));
+				}
+			}
+			if (err)
+				SynthThread::AtomicAdd(&errs, 1);
+			long cnt = SynthThread::AtomicAdd(&done, 1);
+			if (cb)
+				cb(base + cnt, total, LoaderTime() - start, usr);
+		}
+	}
+};
+
+int SBPreloadWorker::ThreadProc()
+{
+	job->LoadSamples(0, 0, 0, 0, 0);
+	return 0;
+}
+
+int SoundBank::PreloadSamples(int threads, SBLoadCB cb, Opaque usr)
+{
+	double start = LoaderTime();
+
+	// loads are serialized with the background loader
+	SoundBankLoader *ldr = loader;
+	if (ldr)
+		ldr->LockLoad();
+
+	long total = 0;
+	SBSample *samp;
+	for (samp = samples; samp; samp = samp->next)
+		total++;
+
+	// Mapping is quick and opens the shared map,
+	// so do that here rather than on the workers.
+	SBPreload job(this, total);
+	for (samp = samples; samp; samp = samp->next)
+	{
+		if (!samp->IsLoaded() && MapSample(samp) != 0)
+			job.list[job.count++] = samp;
+	}
+	long base = total - job.count;
+
+	if (threads > job.count)
+		threads = job.count;
+	int numWorkers = 0;
+	SBPreloadWorker *workers = 0;
+	if (threads > 1)
+	{
+		workers = new SBPreloadWorker[threads-1];
+		for (int n = 0; n < threads-1; n++)
+		{
+			workers[numWorkers].job = &job;
+			if (workers[numWorkers].StartThread() == 0)
+				numWorkers++;
+		}
+	}
+
+	job.LoadSamples(cb, usr, base, total, start);
+
+	// report progress for samples finished by the workers
+	if (numWorkers > 0)
+	{
+		long seen = SynthThread::AtomicAdd(&job.done, 0);
+		while (seen < job.count)
+		{
+			workers[0].ShortWait();
+			long cnt = SynthThread::AtomicAdd(&job.done, 0);
+			if (cb && cnt != seen)
+				cb(base + cnt, total, LoaderTime() - start, usr);
+			seen = cnt;
+		}
+		for (int n = 0; n < numWorkers; n++)
+			workers[n].WaitThread();
+	}
+	delete[] workers;
+
+	// Resolve the zones and mark the instruments loaded. For streamed
+	// samples this also makes the loop and any late start resident.
+	if (OpenSampleFile() == 0)
+	{
+		for (int b = 0; b < 129; b++)
+		{
+			SBInstr **instrList = instrBank[b];
+			if (instrList == 0)
+				continue;
+			for (int p = 0; p < 128; p++)
+			{
+				if (instrList[p] && LoadInstr(instrList[p], sampleFile))
+					job.errs++;
+			}
+		}
+	}
+
+	// samples must be visible before another thread plays them
+	SynthThread::MemoryFence();
+	if (ldr)
+		ldr->UnlockLoad();
+
+	if (cb)
+		cb(total, total, LoaderTime() - start, usr);
+	return job.errs ? -1 : 0;
+}
+
+int SoundBankLoader::ThreadProc()
+{
+	LoadRequest req;
+	while (SynthThread::AtomicAdd(&running, 0))
+	{
+		if (!Dequeue(req))
+		{
+			wakeup.Wait();
+			continue;
+		}
+		if (req.bnk)
+			Load(req.bnk, req.bank, req.prog, req.time);
+		else
+		{
+			for (int n = 0; n < SBLOADER_BANKS; n++)
+			{
+				queueLock.Enter();
+				SoundBank *bnk = banks[n];
+				queueLock.Leave();
+				if (bnk)
+					Load(bnk, req.bank, req.prog, req.time);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,223 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file SoundBankStreamer.cpp Disk streaming of soundbank samples.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SynthDefs.h>
+#include <SynthString.h>
+#include <SynthList.h>
+#include <SynthThread.h>
+#include <SynthMutex.h>
+#include <SoundBank.h>
+#include <SoundBankStreamer.h>
+
+// largest single read
+#define STREAM_READ 4096
+// frames kept between the read and write positions,
+// since the oscillator reads two frames at a time.
+#define STREAM_GAP 4
+
+SoundBankStreamer::SoundBankStreamer(int n, bsInt32 frames)
+{
+	bsInt32 size = 1024;
+	while (size < frames)
+		size <<= 1;
+	bufFrames = size;
+	numStreams = n;
+	streams = new SBStream[n];
+	for (int i = 0; i < n; i++)
+	{
+		streams[i].buf = new AmpValue[size];
+		streams[i].mask = size - 1;
+	}
+	running = 0;
+	opened = 0;
+	failed = 0;
+	activePeak = 0;
+	underruns = 0;
+	bytesRead = 0;
+	statLock.Create();
+	wakeup.Create();
+}
+
+SoundBankStreamer::~SoundBankStreamer()
+{
+	Stop();
+	delete[] streams;
+}
+
+int SoundBankStreamer::Start()
+{
+	if (running)
+		return 0;
+	running = 1;
+	if (StartThread(1))
+	{
+		running = 0;
+		return -1;
+	}
+	return 0;
+}
+
+void SoundBankStreamer::Stop()
+{
+	if (!running)
+		return;
+	SynthThread::AtomicCAS(&running, 1, 0);
+	wakeup.Wakeup();
+	WaitThread();
+	for (int i = 0; i < numStreams; i++)
+	{
+		SBStream *s = &streams[i];
+		s->file.FileClose();
+		s->fileBank = 0;
+		s->state = 0;
+	}
+}
+
+SBStream *SoundBankStreamer::Open(SoundBank *bnk, SBSample *samp, bsInt32 start)
+{
+	if (running)
+	{
+		for (int i = 0; i < numStreams; i++)
+		{
+			SBStream *s = &streams[i];
+			if (SynthThread::AtomicCAS(&s->state, 0, 1) == 0)
+			{
+				s->samp = samp;
+				s->bnk = bnk;
+				s->readPos = start;
+				s->fillPos = start;
+				s->avail = start;
+				s->underruns = 0;
+				SynthThread::AtomicCAS(&s->state, 1, 2);
+				SynthThread::AtomicAdd(&opened, 1);
+				wakeup.Wakeup();
+				return s;
+			}
+		}
+	}
+	SynthThread::AtomicAdd(&failed, 1);
+	return 0;
+}
+
+// Read frames ahead of the playback position,
+// skipping the frames that are resident.
+int SoundBankStreamer::Fill(SBStream *s)
+{
+	SBSample *samp = s->samp;
+	SoundBank *bnk = s->bnk;
+	if (s->fileBank != bnk)
+	{
+		s->file.FileClose();
+		s->file.SetBufSize(STREAM_READ * 4);
+		s->fileBank = 0;
+		if (s->file.FileOpen(bnk->file) != 0)
+			return 0;
+		s->fileBank = bnk;
+	}
+
+	bsInt32 n = (bsInt32) s->fillPos;
+	bsInt32 limit = (bsInt32) SynthThread::AtomicAdd(&s->readPos, 0) + bufFrames - STREAM_GAP;
+	if (limit > samp->sampleLen)
+		limit = samp->sampleLen;
+	int bytes = 0;
+	while (n < limit)
+	{
+		if (n < samp->residentLen)
+		{
+			n = samp->residentLen;
+			continue;
+		}
+		bsInt32 cnt = limit - n;
+		SBSampleRange *rng = samp->loopRange;
+		if (rng)
+		{
+			if (n >= rng->first && n < rng->last)
+			{
+				n = rng->last;
+				continue;
+			}
+			if (n < rng->first && rng->first - n < cnt)
+				cnt = rng->first - n;
+		}
+		bsInt32 wrap = bufFrames - (n & s->mask);
+		if (cnt > wrap)
+			cnt = wrap;
+		if (cnt > STREAM_READ)
+			cnt = STREAM_READ;
+		bnk->ReadFrames(samp, s->file, n, cnt, &s->buf[n & s->mask]);
+		bytes += cnt * (samp->format == 0 ? 1 : (samp->format == 2 ? 4 : 2));
+		n += cnt;
+		SynthThread::MemoryFence();
+		s->fillPos = n;
+	}
+	if (n > s->fillPos)
+	{
+		SynthThread::MemoryFence();
+		s->fillPos = n;
+	}
+	return bytes;
+}
+
+void SoundBankStreamer::GetStats(SBStreamStats& st)
+{
+	long active = 0;
+	for (int i = 0; i < numStreams; i++)
+	{
+		if (streams[i].state == 2)
+			active++;
+	}
+	statLock.Enter();
+	st.opened = SynthThread::AtomicAdd(&opened, 0);
+	st.failed = SynthThread::AtomicAdd(&failed, 0);
+	st.active = active;
+	st.activePeak = activePeak;
+	st.underruns = underruns;
+	st.bytesRead = bytesRead;
+	statLock.Leave();
+}
+
+int SoundBankStreamer::ThreadProc()
+{
+	while (SynthThread::AtomicAdd(&running, 0))
+	{
+		long active = 0;
+		long under = 0;
+		int bytes = 0;
+		for (int i = 0; i < numStreams; i++)
+		{
+			SBStream *s = &streams[i];
+			long st = SynthThread::AtomicAdd(&s->state, 0);
+			if (st == 3)
+			{
+				under += s->underruns;
+				SynthThread::AtomicCAS(&s->state, 3, 0);
+			}
+			else if (st == 2)
+			{
+				active++;
+				bytes += Fill(s);
+			}
+		}
+		statLock.Enter();
+		underruns += under;
+		bytesRead += (double) bytes;
+		if (active > activePeak)
+			activePeak = active;
+		statLock.Leave();
+		if (active == 0)
+			wakeup.Wait();
+		else if (bytes == 0)
+			ShortWait();
+	}
+	return 0;
+}
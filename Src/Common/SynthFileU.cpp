@@ -11,7 +11,10 @@
 #include <sys/types.h>
 //#include <sys/uio.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <math.h>
 #include <SynthDefs.h>
@@ -183,6 +186,95 @@ int FileReadBuf::FileClose()
 	return 0;
 }
 
+FileReadMap::FileReadMap()
+{
+	data = 0;
+	size = 0;
+}
+
+FileReadMap::~FileReadMap()
+{
+	FileClose();
+}
+
+int FileReadMap::FileOpen(const char *fname)
+{
+	FileClose();
+	int fd = open(fname, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	// the mapping holds its own reference to the file
+	struct stat info;
+	void *addr = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+		addr = mmap(0, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+		return -1;
+	data = (const bsUint8 *) addr;
+	size = (size_t) info.st_size;
+	return 0;
+}
+
+int FileReadMap::FileClose()
+{
+	if (data)
+	{
+		munmap((void *) data, size);
+		data = 0;
+		size = 0;
+	}
+	return 0;
+}
+
+FileReadAt::FileReadAt()
+{
+	fd = -1;
+}
+
+FileReadAt::~FileReadAt()
+{
+	FileClose();
+}
+
+int FileReadAt::FileOpen(const char *fname)
+{
+	FileClose();
+	if ((fd = open(fname, O_RDONLY)) < 0)
+		return -1;
+	return 0;
+}
+
+int FileReadAt::FileRead(void *rdbuf, int rdsiz, bsUint32 pos)
+{
+	if (fd < 0)
+		return -1;
+	bsUint8 *bp = (bsUint8 *)rdbuf;
+	int nread = 0;
+	while (nread < rdsiz)
+	{
+		ssize_t cnt = pread(fd, &bp[nread], (size_t) (rdsiz - nread), (off_t) pos + nread);
+		if (cnt <= 0)
+		{
+			if (cnt < 0 && nread == 0)
+				return -1;
+			break;
+		}
+		nread += (int) cnt;
+	}
+	return nread;
+}
+
+int FileReadAt::FileClose()
+{
+	if (fd >= 0)
+	{
+		close(fd);
+		fd = -1;
+	}
+	return 0;
+}
+
 int SynthFileExists(const char *fname)
 {
 	struct stat info;
@@ -193,6 +285,16 @@ int SynthFileExists(const char *fname)
 	return 0;
 }
 
+int SynthFileInfo(const char *fname, bsUint32& size, bsUint32& modtime)
+{
+	struct stat info;
+	if (stat(fname, &info) == -1)
+		return -1;
+	size = (bsUint32) info.st_size;
+	modtime = (bsUint32) info.st_mtime;
+	return 0;
+}
+
 int SynthCopyFile(const char *oldName, const char *newName)
 {
 	int fdin = open(oldName, O_RDONLY);
@@ -220,3 +322,13 @@ int SynthCopyFile(const char *oldName, const char *newName)
 	return -1;
 }
 
+int SynthRenameFile(const char *oldName, const char *newName)
+{
+	return rename(oldName, newName) == 0 ? 0 : -1;
+}
+
+int SynthDeleteFile(const char *fname)
+{
+	return unlink(fname) == 0 ? 0 : -1;
+}
+
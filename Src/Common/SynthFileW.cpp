@@ -106,7 +106,7 @@ int FileReadBuf::FileOpen(const char *fname)
 	size_t wlen = bsString::utf16Len(fname) + 1;
 	wchar_t *wbuf = new wchar_t[wlen];
 	bsString::utf16(fname, wbuf, wlen);
-	fh = CreateFileW(wbuf, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	fh = CreateFileW(wbuf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
 	delete wbuf;
 	if (fh == INVALID_HANDLE_VALUE)
 		return -1;
@@ -209,6 +209,119 @@ int FileReadBuf::FileClose()
 	return 0;
 }
 
+FileReadMap::FileReadMap()
+{
+	data = 0;
+	size = 0;
+}
+
+FileReadMap::~FileReadMap()
+{
+	FileClose();
+}
+
+int FileReadMap::FileOpen(const char *fname)
+{
+	FileClose();
+	size_t wlen = bsString::utf16Len(fname) + 1;
+	wchar_t *wbuf = new wchar_t[wlen];
+	bsString::utf16(fname, wbuf, wlen);
+	HANDLE fh = CreateFileW(wbuf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	delete wbuf;
+	if (fh == INVALID_HANDLE_VALUE)
+		return -1;
+	// the view holds its own reference to the file and mapping
+	DWORD hi = 0;
+	DWORD lo = GetFileSize(fh, &hi);
+	HANDLE mh = NULL;
+	if (lo != INVALID_FILE_SIZE && (lo != 0 || hi != 0))
+		mh = CreateFileMapping(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(fh);
+	if (mh == NULL)
+		return -1;
+	void *addr = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mh);
+	if (addr == NULL)
+		return -1;
+	data = (const bsUint8 *) addr;
+	size = (size_t) lo;
+#if defined(_WIN64)
+	size |= ((size_t) hi) << 32;
+#endif
+	return 0;
+}
+
+int FileReadMap::FileClose()
+{
+	if (data)
+	{
+		UnmapViewOfFile((LPCVOID) data);
+		data = 0;
+		size = 0;
+	}
+	return 0;
+}
+
+FileReadAt::FileReadAt()
+{
+	fh = INVALID_HANDLE_VALUE;
+}
+
+FileReadAt::~FileReadAt()
+{
+	FileClose();
+}
+
+int FileReadAt::FileOpen(const char *fname)
+{
+	FileClose();
+	size_t wlen = bsString::utf16Len(fname) + 1;
+	wchar_t *wbuf = new wchar_t[wlen];
+	bsString::utf16(fname, wbuf, wlen);
+	fh = CreateFileW(wbuf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	delete wbuf;
+	if (fh == INVALID_HANDLE_VALUE)
+		return -1;
+	return 0;
+}
+
+// The position is passed in the OVERLAPPED structure. On a
+// synchronous handle ReadFile still waits for completion.
+int FileReadAt::FileRead(void *rdbuf, int rdsiz, bsUint32 pos)
+{
+	if (fh == INVALID_HANDLE_VALUE)
+		return -1;
+	bsUint8 *bp = (bsUint8 *)rdbuf;
+	int nread = 0;
+	while (nread < rdsiz)
+	{
+		OVERLAPPED ov;
+		memset(&ov, 0, sizeof(ov));
+		ov.Offset = pos + (DWORD) nread;
+		DWORD cnt = 0;
+		if (!ReadFile(fh, &bp[nread], (DWORD) (rdsiz - nread), &cnt, &ov))
+		{
+			if (nread == 0 && GetLastError() != ERROR_HANDLE_EOF)
+				return -1;
+			break;
+		}
+		if (cnt == 0)
+			break;
+		nread += (int) cnt;
+	}
+	return nread;
+}
+
+int FileReadAt::FileClose()
+{
+	if (fh != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fh);
+		fh = INVALID_HANDLE_VALUE;
+	}
+	return 0;
+}
+
 int SynthFileExists(const char *fname)
 {
 	DWORD attr = 0;
@@ -227,6 +340,33 @@ int SynthFileExists(const char *fname)
 	return (attr == INVALID_FILE_ATTRIBUTES) ? 0 : 1;
 }
 
+int SynthFileInfo(const char *fname, bsUint32& size, bsUint32& modtime)
+{
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	BOOL res = 0;
+
+	size_t wlen = bsString::utf16Len(fname) + 1;
+	wchar_t *wbuf = new wchar_t[wlen];
+	if (wbuf)
+	{
+		bsString::utf16(fname, wbuf, wlen);
+		res = ::GetFileAttributesExW(wbuf, GetFileExInfoStandard, &info);
+		delete wbuf;
+	}
+	else
+		res = ::GetFileAttributesExA(fname, GetFileExInfoStandard, &info);
+	if (!res)
+		return -1;
+
+	size = info.nFileSizeLow;
+	// seconds since 1601
+	ULARGE_INTEGER tm;
+	tm.LowPart = info.ftLastWriteTime.dwLowDateTime;
+	tm.HighPart = info.ftLastWriteTime.dwHighDateTime;
+	modtime = (bsUint32) (tm.QuadPart / 10000000);
+	return 0;
+}
+
 int SynthCopyFile(const char *oldName, const char *newName)
 {
 	BOOL res = 0;
@@ -251,3 +391,46 @@ int SynthCopyFile(const char *oldName, const char *newName)
 
 	return res ? 0 : -1;
 }
+
+int SynthRenameFile(const char *oldName, const char *newName)
+{
+	BOOL res = 0;
+
+	size_t oldlen = bsString::utf16Len(oldName) + 1;
+	wchar_t *wold = new wchar_t[oldlen];
+
+	size_t newlen = bsString::utf16Len(newName) + 1;
+	wchar_t *wnew = new wchar_t[newlen];
+
+	if (wold && wnew)
+	{
+		bsString::utf16(oldName, wold, oldlen);
+		bsString::utf16(newName, wnew, newlen);
+		res = ::MoveFileExW(wold, wnew, MOVEFILE_REPLACE_EXISTING);
+	}
+	else
+		res = ::MoveFileExA(oldName, newName, MOVEFILE_REPLACE_EXISTING);
+
+	delete[] wold;
+	delete[] wnew;
+
+	return res ? 0 : -1;
+}
+
+int SynthDeleteFile(const char *fname)
+{
+	BOOL res = 0;
+
+	size_t wlen = bsString::utf16Len(fname) + 1;
+	wchar_t *wbuf = new wchar_t[wlen];
+	if (wbuf)
+	{
+		bsString::utf16(fname, wbuf, wlen);
+		res = ::DeleteFileW(wbuf);
+		delete[] wbuf;
+	}
+	else
+		res = ::DeleteFileA(fname);
+
+	return res ? 0 : -1;
+}
@@ -83,10 +83,13 @@ void SynthSignal::Wakeup()
 #include <sys/types.h>
 #include <pthread.h>
 
+// The event is latched, like an auto-reset Windows event,
+// so that a wakeup sent before the wait is not lost.
 struct pthread_event
 {
 	pthread_mutex_t m;
 	pthread_cond_t  c;
+	int set;
 };
 
 void SynthMutex::Create()
@@ -127,6 +130,7 @@ void SynthSignal::Create()
 		pthread_event *e = new pthread_event;
 		pthread_mutex_init(&e->m, NULL);
 		pthread_cond_init(&e->c, NULL);
+		e->set = 0;
 		sig = (void*)e;
 	}
 }
@@ -149,7 +153,9 @@ void SynthSignal::Wait()
 	{
 		pthread_event *e = (pthread_event*)sig;
 		pthread_mutex_lock(&e->m);
-		pthread_cond_wait(&e->c, &e->m);
+		while (!e->set)
+			pthread_cond_wait(&e->c, &e->m);
+		e->set = 0;
 		pthread_mutex_unlock(&e->m);
 	}
 }
@@ -160,6 +166,7 @@ void SynthSignal::Wakeup()
 	{
 		pthread_event *e = (pthread_event*)sig;
 		pthread_mutex_lock(&e->m);
+		e->set = 1;
 		pthread_cond_signal(&e->c);
 		pthread_mutex_unlock(&e->m);
 	}
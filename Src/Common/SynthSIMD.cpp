@@ -0,0 +1,781 @@
+/////////////////////////////////////////////////////
+/// @file SynthSIMD.cpp Vector (SIMD) kernels for block processing
+//
+// Copyright 2010 Daniel R. Mitchell, All Rights Reserved
+// License: Creative Commons/GNU-GPL 
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////
+
+#include <math.h>
+#include <SynthDefs.h>
+#include <SynthSIMD.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SIMD_X86 1
+#include <emmintrin.h>
+// AVX2 intrinsics are available beginning with VS2013.
+#if !defined(_MSC_VER) || _MSC_VER >= 1800
+#define SIMD_X86_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/CLANG only generate vector instructions
+// beyond the command line -m option for functions
+// that are explicitly marked.
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+SynthSIMD synthSIMD;
+
+/////////////////////////////////////////////////////
+// Scalar kernels
+/////////////////////////////////////////////////////
+
+static void LookupScalar(AmpValue *dst, const AmpValue *wt, const bsInt32 *ndx, int n)
+{
+	while (--n >= 0)
+		*dst++ = wt[*ndx++];
+}
+
+static void LookupIScalar(AmpValue *dst, const AmpValue *wt, const bsInt32 *ndx, const PhsAccum *fr, int n)
+{
+	while (--n >= 0)
+	{
+		const AmpValue *wp = &wt[*ndx++];
+		AmpValue2 v1 = (AmpValue2) wp[0];
+		AmpValue2 v2 = (AmpValue2) wp[1];
+		*dst++ = (AmpValue) (v1 + ((v2 - v1) * *fr++));
+	}
+}
+
+static bsInt32 Lookup32Scalar(AmpValue *dst, const AmpValue *wt, bsInt32 ndx, bsInt32 incr, bsInt32 mask, int n)
+{
+	while (--n >= 0)
+	{
+		*dst++ = wt[(ndx + 0x8000) >> 16];
+		ndx = (ndx + incr) & mask;
+	}
+	return ndx;
+}
+
+static void MulScalar(AmpValue *dst, const AmpValue *src, AmpValue g, int n)
+{
+	while (--n >= 0)
+		*dst++ = *src++ * g;
+}
+
+static void MulAddScalar(AmpValue *dst, const AmpValue *src, AmpValue g, int n)
+{
+	while (--n >= 0)
+		*dst++ += *src++ * g;
+}
+
+static void AddMulScalar(AmpValue *dst, const AmpValue *a, const AmpValue *b, AmpValue g, int n)
+{
+	while (--n >= 0)
+		*dst++ = (*a++ + *b++) * g;
+}
+
+static void CombScalar(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	while (--n >= 0)
+	{
+		AmpValue out = *buf * g;
+		*buf++ = *in++ + out;
+		*dst++ = out;
+	}
+}
+
+static void CombAddScalar(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	while (--n >= 0)
+	{
+		AmpValue out = *buf * g;
+		*buf++ = *in++ + out;
+		*dst++ += out;
+	}
+}
+
+static void AllPassScalar(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	while (--n >= 0)
+	{
+		AmpValue vm = *buf;
+		AmpValue vn = *in++ - (vm * g);
+		*buf++ = vn;
+		*dst++ = vm + (vn * g);
+	}
+}
+
+// Apply the PhaseMod3 routing for one lane.
+static inline void PhaseMod3Route(AmpValue *out, AmpValue *mod, int route)
+{
+	if (route & SIMD_PM_32)
+		mod[1] += out[2];
+	if ((route & (SIMD_PM_21|SIMD_PM_31)) == (SIMD_PM_21|SIMD_PM_31))
+		mod[0] += out[1] + out[2];
+	else if (route & SIMD_PM_21)
+		mod[0] += out[1];
+	else if (route & SIMD_PM_31)
+		mod[0] += out[2];
+	if (route & SIMD_PM_ADD2)
+		out[0] += out[1];
+}
+
+static void PhaseMod3Scalar(AmpValue *dst, SynthPM3Lanes *st, const AmpValue *amp, const AmpValue *phs, int route, int n)
+{
+	PhsAccum len = synthParams.ftableLength;
+	AmpValue out[3];
+	AmpValue mod[3];
+	while (--n >= 0)
+	{
+		for (int l = 0; l < SIMD_LANES; l++)
+		{
+			int k;
+			for (k = 0; k < 3; k++)
+			{
+				PhsAccum index = st->index[k][l];
+				while (index >= len)
+					index -= len;
+				while (index < 0)
+					index += len;
+				out[k] = st->wt[k][l][(bsInt32) (index + 0.5)] * amp[k*SIMD_LANES];
+				st->index[k][l] = index + st->incr[k][l];
+				mod[k] = *phs * st->mult[k][l];
+			}
+			PhaseMod3Route(out, mod, route);
+			for (k = 0; k < 3; k++)
+				st->index[k][l] += mod[k];
+			*dst++ = out[0];
+			amp++;
+			phs++;
+		}
+		amp += 2*SIMD_LANES;
+	}
+}
+
+static void Pcm16Scalar(AmpValue *dst, const bsInt16 *src, const bsUint8 *lsb, int n)
+{
+	if (lsb)
+	{
+		while (--n >= 0)
+			*dst++ = (AmpValue) (((bsInt32) *src++ * 256) + *lsb++) / 8388608.0;
+	}
+	else
+	{
+		while (--n >= 0)
+			*dst++ = (AmpValue) *src++ / 32768.0;
+	}
+}
+
+#if SIMD_X86
+/////////////////////////////////////////////////////
+// SSE2 kernels. SSE2 has no gather, so the table
+// loads are scalar and the arithmetic is vectorized.
+/////////////////////////////////////////////////////
+
+TARGET_SSE2
+static void LookupISSE2(AmpValue *dst, const AmpValue *wt, const bsInt32 *ndx, const PhsAccum *fr, int n)
+{
+	while (n >= 4)
+	{
+		const AmpValue *w0 = &wt[ndx[0]];
+		const AmpValue *w1 = &wt[ndx[1]];
+		const AmpValue *w2 = &wt[ndx[2]];
+		const AmpValue *w3 = &wt[ndx[3]];
+		__m128 v1 = _mm_set_ps(w3[0], w2[0], w1[0], w0[0]);
+		__m128 v2 = _mm_set_ps(w3[1], w2[1], w1[1], w0[1]);
+		__m128d a1 = _mm_cvtps_pd(v1);
+		__m128d a2 = _mm_cvtps_pd(v2);
+		__m128d b1 = _mm_cvtps_pd(_mm_movehl_ps(v1, v1));
+		__m128d b2 = _mm_cvtps_pd(_mm_movehl_ps(v2, v2));
+		a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_sub_pd(a2, a1), _mm_loadu_pd((const double*)fr)));
+		b1 = _mm_add_pd(b1, _mm_mul_pd(_mm_sub_pd(b2, b1), _mm_loadu_pd((const double*)fr+2)));
+		_mm_storeu_ps(dst, _mm_movelh_ps(_mm_cvtpd_ps(a1), _mm_cvtpd_ps(b1)));
+		dst += 4;
+		ndx += 4;
+		fr += 4;
+		n -= 4;
+	}
+	LookupIScalar(dst, wt, ndx, fr, n);
+}
+
+TARGET_SSE2
+static bsInt32 Lookup32SSE2(AmpValue *dst, const AmpValue *wt, bsInt32 ndx, bsInt32 incr, bsInt32 mask, int n)
+{
+	if (n < 8)
+		return Lookup32Scalar(dst, wt, ndx, incr, mask, n);
+	// The first index may not be masked (see GenWave32::PhaseModWT)
+	*dst++ = wt[(ndx + 0x8000) >> 16];
+	ndx = (ndx + incr) & mask;
+	n--;
+	// Since the index is masked, (ndx + k*incr) & mask produces
+	// the same value as k successive increments.
+	__m128i offs = _mm_set_epi32(incr*3, incr*2, incr, 0);
+	__m128i vmsk = _mm_set1_epi32(mask);
+	__m128i rnd = _mm_set1_epi32(0x8000);
+	bsInt32 incr4 = incr * 4;
+	int ix[4];
+	while (n >= 4)
+	{
+		__m128i vi = _mm_and_si128(_mm_add_epi32(_mm_set1_epi32(ndx), offs), vmsk);
+		_mm_storeu_si128((__m128i*)ix, _mm_srai_epi32(_mm_add_epi32(vi, rnd), 16));
+		_mm_storeu_ps(dst, _mm_set_ps(wt[ix[3]], wt[ix[2]], wt[ix[1]], wt[ix[0]]));
+		ndx = (ndx + incr4) & mask;
+		dst += 4;
+		n -= 4;
+	}
+	return Lookup32Scalar(dst, wt, ndx, incr, mask, n);
+}
+
+// The mixing kernels assume AmpValue is float.
+
+TARGET_SSE2
+static void MulSSE2(AmpValue *dst, const AmpValue *src, AmpValue g, int n)
+{
+	__m128 vg = _mm_set1_ps(g);
+	while (n >= 4)
+	{
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_loadu_ps(src), vg));
+		dst += 4;
+		src += 4;
+		n -= 4;
+	}
+	MulScalar(dst, src, g, n);
+}
+
+TARGET_SSE2
+static void MulAddSSE2(AmpValue *dst, const AmpValue *src, AmpValue g, int n)
+{
+	__m128 vg = _mm_set1_ps(g);
+	while (n >= 4)
+	{
+		_mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(_mm_loadu_ps(src), vg)));
+		dst += 4;
+		src += 4;
+		n -= 4;
+	}
+	MulAddScalar(dst, src, g, n);
+}
+
+TARGET_SSE2
+static void AddMulSSE2(AmpValue *dst, const AmpValue *a, const AmpValue *b, AmpValue g, int n)
+{
+	__m128 vg = _mm_set1_ps(g);
+	while (n >= 4)
+	{
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)), vg));
+		dst += 4;
+		a += 4;
+		b += 4;
+		n -= 4;
+	}
+	AddMulScalar(dst, a, b, g, n);
+}
+
+TARGET_SSE2
+static void CombSSE2(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	__m128 vg = _mm_set1_ps(g);
+	while (n >= 4)
+	{
+		__m128 out = _mm_mul_ps(_mm_loadu_ps(buf), vg);
+		_mm_storeu_ps(buf, _mm_add_ps(_mm_loadu_ps(in), out));
+		_mm_storeu_ps(dst, out);
+		dst += 4;
+		buf += 4;
+		in += 4;
+		n -= 4;
+	}
+	CombScalar(dst, buf, in, g, n);
+}
+
+TARGET_SSE2
+static void CombAddSSE2(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	__m128 vg = _mm_set1_ps(g);
+	while (n >= 4)
+	{
+		__m128 out = _mm_mul_ps(_mm_loadu_ps(buf), vg);
+		_mm_storeu_ps(buf, _mm_add_ps(_mm_loadu_ps(in), out));
+		_mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), out));
+		dst += 4;
+		buf += 4;
+		in += 4;
+		n -= 4;
+	}
+	CombAddScalar(dst, buf, in, g, n);
+}
+
+TARGET_SSE2
+static void AllPassSSE2(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	__m128 vg = _mm_set1_ps(g);
+	while (n >= 4)
+	{
+		__m128 vm = _mm_loadu_ps(buf);
+		__m128 vn = _mm_sub_ps(_mm_loadu_ps(in), _mm_mul_ps(vm, vg));
+		_mm_storeu_ps(buf, vn);
+		_mm_storeu_ps(dst, _mm_add_ps(vm, _mm_mul_ps(vn, vg)));
+		dst += 4;
+		buf += 4;
+		in += 4;
+		n -= 4;
+	}
+	AllPassScalar(dst, buf, in, g, n);
+}
+
+// Scaling by a power of two is exact in single precision.
+TARGET_SSE2
+static void Pcm16SSE2(AmpValue *dst, const bsInt16 *src, const bsUint8 *lsb, int n)
+{
+	__m128i zero = _mm_setzero_si128();
+	while (n >= 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)src);
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		__m128 scl;
+		if (lsb)
+		{
+			__m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)lsb), zero);
+			lo = _mm_add_epi32(_mm_slli_epi32(lo, 8), _mm_unpacklo_epi16(b, zero));
+			hi = _mm_add_epi32(_mm_slli_epi32(hi, 8), _mm_unpackhi_epi16(b, zero));
+			scl = _mm_set1_ps(1.0f / 8388608.0f);
+			lsb += 8;
+		}
+		else
+			scl = _mm_set1_ps(1.0f / 32768.0f);
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(lo), scl));
+		_mm_storeu_ps(dst+4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scl));
+		dst += 8;
+		src += 8;
+		n -= 8;
+	}
+	Pcm16Scalar(dst, src, lsb, n);
+}
+#endif
+
+#if SIMD_X86_AVX2
+/////////////////////////////////////////////////////
+// AVX2 kernels. These use gather for table loads.
+// N.B. - FMA is intentionally not enabled so that
+// results match the scalar code.
+/////////////////////////////////////////////////////
+
+TARGET_AVX2
+static void LookupAVX2(AmpValue *dst, const AmpValue *wt, const bsInt32 *ndx, int n)
+{
+	while (n >= 8)
+	{
+		__m256i vi = _mm256_loadu_si256((const __m256i*)ndx);
+		_mm256_storeu_ps(dst, _mm256_i32gather_ps(wt, vi, 4));
+		dst += 8;
+		ndx += 8;
+		n -= 8;
+	}
+	LookupScalar(dst, wt, ndx, n);
+}
+
+TARGET_AVX2
+static void LookupIAVX2(AmpValue *dst, const AmpValue *wt, const bsInt32 *ndx, const PhsAccum *fr, int n)
+{
+	while (n >= 8)
+	{
+		__m256i vi = _mm256_loadu_si256((const __m256i*)ndx);
+		__m256 v1 = _mm256_i32gather_ps(wt, vi, 4);
+		__m256 v2 = _mm256_i32gather_ps(wt+1, vi, 4);
+		__m256d a1 = _mm256_cvtps_pd(_mm256_castps256_ps128(v1));
+		__m256d a2 = _mm256_cvtps_pd(_mm256_castps256_ps128(v2));
+		__m256d b1 = _mm256_cvtps_pd(_mm256_extractf128_ps(v1, 1));
+		__m256d b2 = _mm256_cvtps_pd(_mm256_extractf128_ps(v2, 1));
+		a1 = _mm256_add_pd(a1, _mm256_mul_pd(_mm256_sub_pd(a2, a1), _mm256_loadu_pd((const double*)fr)));
+		b1 = _mm256_add_pd(b1, _mm256_mul_pd(_mm256_sub_pd(b2, b1), _mm256_loadu_pd((const double*)fr+4)));
+		_mm_storeu_ps(dst, _mm256_cvtpd_ps(a1));
+		_mm_storeu_ps(dst+4, _mm256_cvtpd_ps(b1));
+		dst += 8;
+		ndx += 8;
+		fr += 8;
+		n -= 8;
+	}
+	LookupIScalar(dst, wt, ndx, fr, n);
+}
+
+TARGET_AVX2
+static bsInt32 Lookup32AVX2(AmpValue *dst, const AmpValue *wt, bsInt32 ndx, bsInt32 incr, bsInt32 mask, int n)
+{
+	if (n < 16)
+		return Lookup32Scalar(dst, wt, ndx, incr, mask, n);
+	*dst++ = wt[(ndx + 0x8000) >> 16];
+	ndx = (ndx + incr) & mask;
+	n--;
+	__m256i offs = _mm256_set_epi32(incr*7, incr*6, incr*5, incr*4, incr*3, incr*2, incr, 0);
+	__m256i vmsk = _mm256_set1_epi32(mask);
+	__m256i rnd = _mm256_set1_epi32(0x8000);
+	bsInt32 incr8 = incr * 8;
+	while (n >= 8)
+	{
+		__m256i vi = _mm256_and_si256(_mm256_add_epi32(_mm256_set1_epi32(ndx), offs), vmsk);
+		vi = _mm256_srai_epi32(_mm256_add_epi32(vi, rnd), 16);
+		_mm256_storeu_ps(dst, _mm256_i32gather_ps(wt, vi, 4));
+		ndx = (ndx + incr8) & mask;
+		dst += 8;
+		n -= 8;
+	}
+	return Lookup32Scalar(dst, wt, ndx, incr, mask, n);
+}
+
+TARGET_AVX2
+static void MulAVX2(AmpValue *dst, const AmpValue *src, AmpValue g, int n)
+{
+	__m256 vg = _mm256_set1_ps(g);
+	while (n >= 8)
+	{
+		_mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_loadu_ps(src), vg));
+		dst += 8;
+		src += 8;
+		n -= 8;
+	}
+	MulScalar(dst, src, g, n);
+}
+
+TARGET_AVX2
+static void MulAddAVX2(AmpValue *dst, const AmpValue *src, AmpValue g, int n)
+{
+	__m256 vg = _mm256_set1_ps(g);
+	while (n >= 8)
+	{
+		_mm256_storeu_ps(dst, _mm256_add_ps(_mm256_loadu_ps(dst), _mm256_mul_ps(_mm256_loadu_ps(src), vg)));
+		dst += 8;
+		src += 8;
+		n -= 8;
+	}
+	MulAddScalar(dst, src, g, n);
+}
+
+TARGET_AVX2
+static void AddMulAVX2(AmpValue *dst, const AmpValue *a, const AmpValue *b, AmpValue g, int n)
+{
+	__m256 vg = _mm256_set1_ps(g);
+	while (n >= 8)
+	{
+		_mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b)), vg));
+		dst += 8;
+		a += 8;
+		b += 8;
+		n -= 8;
+	}
+	AddMulScalar(dst, a, b, g, n);
+}
+
+TARGET_AVX2
+static void CombAVX2(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	__m256 vg = _mm256_set1_ps(g);
+	while (n >= 8)
+	{
+		__m256 out = _mm256_mul_ps(_mm256_loadu_ps(buf), vg);
+		_mm256_storeu_ps(buf, _mm256_add_ps(_mm256_loadu_ps(in), out));
+		_mm256_storeu_ps(dst, out);
+		dst += 8;
+		buf += 8;
+		in += 8;
+		n -= 8;
+	}
+	CombScalar(dst, buf, in, g, n);
+}
+
+TARGET_AVX2
+static void CombAddAVX2(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	__m256 vg = _mm256_set1_ps(g);
+	while (n >= 8)
+	{
+		__m256 out = _mm256_mul_ps(_mm256_loadu_ps(buf), vg);
+		_mm256_storeu_ps(buf, _mm256_add_ps(_mm256_loadu_ps(in), out));
+		_mm256_storeu_ps(dst, _mm256_add_ps(_mm256_loadu_ps(dst), out));
+		dst += 8;
+		buf += 8;
+		in += 8;
+		n -= 8;
+	}
+	CombAddScalar(dst, buf, in, g, n);
+}
+
+TARGET_AVX2
+static void AllPassAVX2(AmpValue *dst, AmpValue *buf, const AmpValue *in, AmpValue g, int n)
+{
+	__m256 vg = _mm256_set1_ps(g);
+	while (n >= 8)
+	{
+		__m256 vm = _mm256_loadu_ps(buf);
+		__m256 vn = _mm256_sub_ps(_mm256_loadu_ps(in), _mm256_mul_ps(vm, vg));
+		_mm256_storeu_ps(buf, vn);
+		_mm256_storeu_ps(dst, _mm256_add_ps(vm, _mm256_mul_ps(vn, vg)));
+		dst += 8;
+		buf += 8;
+		in += 8;
+		n -= 8;
+	}
+	AllPassScalar(dst, buf, in, g, n);
+}
+
+TARGET_AVX2
+static void Pcm16AVX2(AmpValue *dst, const bsInt16 *src, const bsUint8 *lsb, int n)
+{
+	while (n >= 8)
+	{
+		__m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)src));
+		__m256 scl;
+		if (lsb)
+		{
+			__m256i b = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)lsb));
+			v = _mm256_add_epi32(_mm256_slli_epi32(v, 8), b);
+			scl = _mm256_set1_ps(1.0f / 8388608.0f);
+			lsb += 8;
+		}
+		else
+			scl = _mm256_set1_ps(1.0f / 32768.0f);
+		_mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scl));
+		dst += 8;
+		src += 8;
+		n -= 8;
+	}
+	Pcm16Scalar(dst, src, lsb, n);
+}
+
+// Wrap and look up one oscillator for four lanes.
+// The table addresses are gathered as byte offsets from the first
+// table. Most samples don't need a wrap, and testing for it with
+// a branch keeps the wrap out of the dependency chain from one sample
+// to the next. The wrap is done with scalar code, the same as
+// GenWaveWT::PhaseWrapWT().
+TARGET_AVX2
+static inline __m128 PhaseMod3Osc(__m256d& ndx, __m256d incr, __m256i offs, const char *wt0)
+{
+	__m256d len = _mm256_set1_pd(synthParams.ftableLength);
+	__m256d x = ndx;
+	if (_mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(x, len, _CMP_GE_OQ), _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_LT_OQ))))
+	{
+		double v[4];
+		_mm256_storeu_pd(v, x);
+		for (int l = 0; l < 4; l++)
+		{
+			while (v[l] >= synthParams.ftableLength)
+				v[l] -= synthParams.ftableLength;
+			while (v[l] < 0)
+				v[l] += synthParams.ftableLength;
+		}
+		x = _mm256_loadu_pd(v);
+	}
+	__m256i vi = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(_mm256_add_pd(x, _mm256_set1_pd(0.5))));
+	vi = _mm256_add_epi64(offs, _mm256_slli_epi64(vi, 2));
+	ndx = _mm256_add_pd(x, incr);
+	return _mm256_i64gather_ps((const float *) wt0, vi, 1);
+}
+
+// Table byte offsets for four lanes.
+TARGET_AVX2
+static inline __m256i PhaseMod3Offs(const AmpValue **wt, const char *wt0)
+{
+	return _mm256_set_epi64x((const char *) wt[3] - wt0, (const char *) wt[2] - wt0,
+	                         (const char *) wt[1] - wt0, (const char *) wt[0] - wt0);
+}
+
+// Join two groups of four lanes.
+TARGET_AVX2
+static inline __m256 PhaseMod3Join(__m128 lo, __m128 hi)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+// The lanes are done as two groups of four since the phase is double precision.
+TARGET_AVX2
+static void PhaseMod3AVX2(AmpValue *dst, SynthPM3Lanes *st, const AmpValue *amp, const AmpValue *phs, int route, int n)
+{
+	const char *wt0 = (const char *) st->wt[0][0];
+	__m256d ndx1a = _mm256_loadu_pd(&st->index[0][0]);
+	__m256d ndx1b = _mm256_loadu_pd(&st->index[0][4]);
+	__m256d ndx2a = _mm256_loadu_pd(&st->index[1][0]);
+	__m256d ndx2b = _mm256_loadu_pd(&st->index[1][4]);
+	__m256d ndx3a = _mm256_loadu_pd(&st->index[2][0]);
+	__m256d ndx3b = _mm256_loadu_pd(&st->index[2][4]);
+	__m256d inc1a = _mm256_loadu_pd(&st->incr[0][0]);
+	__m256d inc1b = _mm256_loadu_pd(&st->incr[0][4]);
+	__m256d inc2a = _mm256_loadu_pd(&st->incr[1][0]);
+	__m256d inc2b = _mm256_loadu_pd(&st->incr[1][4]);
+	__m256d inc3a = _mm256_loadu_pd(&st->incr[2][0]);
+	__m256d inc3b = _mm256_loadu_pd(&st->incr[2][4]);
+	__m256i wt1a = PhaseMod3Offs(&st->wt[0][0], wt0);
+	__m256i wt1b = PhaseMod3Offs(&st->wt[0][4], wt0);
+	__m256i wt2a = PhaseMod3Offs(&st->wt[1][0], wt0);
+	__m256i wt2b = PhaseMod3Offs(&st->wt[1][4], wt0);
+	__m256i wt3a = PhaseMod3Offs(&st->wt[2][0], wt0);
+	__m256i wt3b = PhaseMod3Offs(&st->wt[2][4], wt0);
+	__m256 mul1 = _mm256_loadu_ps(st->mult[0]);
+	__m256 mul2 = _mm256_loadu_ps(st->mult[1]);
+	__m256 mul3 = _mm256_loadu_ps(st->mult[2]);
+	bool add32 = (route & SIMD_PM_32) != 0;
+	bool add21 = (route & SIMD_PM_21) != 0;
+	bool add31 = (route & SIMD_PM_31) != 0;
+	bool add2 = (route & SIMD_PM_ADD2) != 0;
+	while (--n >= 0)
+	{
+		__m256 out1 = PhaseMod3Join(PhaseMod3Osc(ndx1a, inc1a, wt1a, wt0), PhaseMod3Osc(ndx1b, inc1b, wt1b, wt0));
+		__m256 out2 = PhaseMod3Join(PhaseMod3Osc(ndx2a, inc2a, wt2a, wt0), PhaseMod3Osc(ndx2b, inc2b, wt2b, wt0));
+		__m256 out3 = PhaseMod3Join(PhaseMod3Osc(ndx3a, inc3a, wt3a, wt0), PhaseMod3Osc(ndx3b, inc3b, wt3b, wt0));
+		out1 = _mm256_mul_ps(out1, _mm256_loadu_ps(amp));
+		out2 = _mm256_mul_ps(out2, _mm256_loadu_ps(amp + SIMD_LANES));
+		out3 = _mm256_mul_ps(out3, _mm256_loadu_ps(amp + 2*SIMD_LANES));
+		__m256 p = _mm256_loadu_ps(phs);
+		__m256 mod1 = _mm256_mul_ps(p, mul1);
+		__m256 mod2 = _mm256_mul_ps(p, mul2);
+		__m256 mod3 = _mm256_mul_ps(p, mul3);
+		if (add32)
+			mod2 = _mm256_add_ps(mod2, out3);
+		if (add21 && add31)
+			mod1 = _mm256_add_ps(mod1, _mm256_add_ps(out2, out3));
+		else if (add21)
+			mod1 = _mm256_add_ps(mod1, out2);
+		else if (add31)
+			mod1 = _mm256_add_ps(mod1, out3);
+		if (add2)
+			out1 = _mm256_add_ps(out1, out2);
+		ndx1a = _mm256_add_pd(ndx1a, _mm256_cvtps_pd(_mm256_castps256_ps128(mod1)));
+		ndx1b = _mm256_add_pd(ndx1b, _mm256_cvtps_pd(_mm256_extractf128_ps(mod1, 1)));
+		ndx2a = _mm256_add_pd(ndx2a, _mm256_cvtps_pd(_mm256_castps256_ps128(mod2)));
+		ndx2b = _mm256_add_pd(ndx2b, _mm256_cvtps_pd(_mm256_extractf128_ps(mod2, 1)));
+		ndx3a = _mm256_add_pd(ndx3a, _mm256_cvtps_pd(_mm256_castps256_ps128(mod3)));
+		ndx3b = _mm256_add_pd(ndx3b, _mm256_cvtps_pd(_mm256_extractf128_ps(mod3, 1)));
+		_mm256_storeu_ps(dst, out1);
+		dst += SIMD_LANES;
+		amp += 3*SIMD_LANES;
+		phs += SIMD_LANES;
+	}
+	_mm256_storeu_pd(&st->index[0][0], ndx1a);
+	_mm256_storeu_pd(&st->index[0][4], ndx1b);
+	_mm256_storeu_pd(&st->index[1][0], ndx2a);
+	_mm256_storeu_pd(&st->index[1][4], ndx2b);
+	_mm256_storeu_pd(&st->index[2][0], ndx3a);
+	_mm256_storeu_pd(&st->index[2][4], ndx3b);
+}
+#endif
+
+/////////////////////////////////////////////////////
+
+SynthSIMD::SynthSIMD()
+{
+	SetLevel(Detect());
+}
+
+int SynthSIMD::Detect()
+{
+#if SIMD_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxId = info[0];
+	__cpuid(info, 1);
+	int lvl = SIMD_NONE;
+	if (info[3] & (1 << 26))
+		lvl = SIMD_SSE2;
+#if SIMD_X86_AVX2
+	// AVX2 requires OS support for saving the YMM registers (OSXSAVE + AVX)
+	if (maxId >= 7 && (info[2] & (1 << 27)) && (info[2] & (1 << 28)))
+	{
+		if ((_xgetbv(0) & 6) == 6)
+		{
+			__cpuidex(info, 7, 0);
+			if (info[1] & (1 << 5))
+				lvl = SIMD_AVX2;
+		}
+	}
+#endif
+	return lvl;
+#elif defined(__GNUC__)
+	__builtin_cpu_init();
+#if SIMD_X86_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return SIMD_AVX2;
+#endif
+	if (__builtin_cpu_supports("sse2"))
+		return SIMD_SSE2;
+#endif
+#endif
+	return SIMD_NONE;
+}
+
+int SynthSIMD::SetLevel(int lvl)
+{
+	int max = Detect();
+	if (lvl > max)
+		lvl = max;
+	if (lvl < SIMD_NONE)
+		lvl = SIMD_NONE;
+	level = lvl;
+
+	Lookup = LookupScalar;
+	LookupI = LookupIScalar;
+	Lookup32 = Lookup32Scalar;
+	Mul = MulScalar;
+	MulAdd = MulAddScalar;
+	AddMul = AddMulScalar;
+	Comb = CombScalar;
+	CombAdd = CombAddScalar;
+	AllPass = AllPassScalar;
+	Pcm16 = Pcm16Scalar;
+	PhaseMod3 = PhaseMod3Scalar;
+#if SIMD_X86
+	// The interpolating kernels assume double precision phase and amplitude.
+	bool dbl = sizeof(PhsAccum) == sizeof(double) && sizeof(AmpValue2) == sizeof(double);
+	bool flt = sizeof(AmpValue) == sizeof(float);
+	if (lvl >= SIMD_SSE2)
+	{
+		if (dbl)
+			LookupI = LookupISSE2;
+		Lookup32 = Lookup32SSE2;
+		if (flt)
+		{
+			Mul = MulSSE2;
+			MulAdd = MulAddSSE2;
+			AddMul = AddMulSSE2;
+			Comb = CombSSE2;
+			CombAdd = CombAddSSE2;
+			AllPass = AllPassSSE2;
+			Pcm16 = Pcm16SSE2;
+		}
+	}
+#if SIMD_X86_AVX2
+	if (lvl >= SIMD_AVX2)
+	{
+		Lookup = LookupAVX2;
+		if (dbl)
+			LookupI = LookupIAVX2;
+		Lookup32 = Lookup32AVX2;
+		if (flt)
+		{
+			Mul = MulAVX2;
+			MulAdd = MulAddAVX2;
+			AddMul = AddMulAVX2;
+			Comb = CombAVX2;
+			CombAdd = CombAddAVX2;
+			AllPass = AllPassAVX2;
+			Pcm16 = Pcm16AVX2;
+			if (dbl)
+				PhaseMod3 = PhaseMod3AVX2;
+		}
+	}
+#endif
+#endif
+	return level;
+}
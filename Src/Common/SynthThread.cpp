@@ -77,12 +77,41 @@ void SynthThread::ShortWait()
 	Sleep(1);
 }
 
+void SynthThread::YieldThread()
+{
+	SwitchToThread();
+}
+
+long SynthThread::AtomicAdd(volatile long *val, long n)
+{
+	return InterlockedExchangeAdd(val, n) + n;
+}
+
+long SynthThread::AtomicCAS(volatile long *val, long cmp, long n)
+{
+	return InterlockedCompareExchange(val, n, cmp);
+}
+
+void SynthThread::MemoryFence()
+{
+	volatile long fence = 0;
+	InterlockedExchange(&fence, 1);
+}
+
+int SynthThread::CPUCount()
+{
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors > 0 ? (int) si.dwNumberOfProcessors : 1;
+}
+
 #endif
 
 #ifdef UNIX
 #include <unistd.h>
 #include <sys/types.h>
 #include <pthread.h>
+#include <sched.h>
 
 class ThreadInfo
 {
@@ -148,6 +177,32 @@ void SynthThread::ShortWait()
 	usleep(1000);
 }
 
+void SynthThread::YieldThread()
+{
+	sched_yield();
+}
+
+long SynthThread::AtomicAdd(volatile long *val, long n)
+{
+	return __sync_add_and_fetch(val, n);
+}
+
+long SynthThread::AtomicCAS(volatile long *val, long cmp, long n)
+{
+	return __sync_val_compare_and_swap(val, cmp, n);
+}
+
+void SynthThread::MemoryFence()
+{
+	__sync_synchronize();
+}
+
+int SynthThread::CPUCount()
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int) n : 1;
+}
+
 #endif
 
 SynthThread::SynthThread()
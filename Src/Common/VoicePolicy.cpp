@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file VoicePolicy.cpp Voice allocation policy for the sequencer.
+//
+// Copyright 2010, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SynthDefs.h>
+#include <SynthString.h>
+#include <SynthMutex.h>
+#include <SynthThread.h>
+#include <SynthQueue.h>
+#include <WaveTable.h>
+#include <WaveFile.h>
+#include <SynthSIMD.h>
+#include <Mixer.h>
+#include <SynthList.h>
+#include <XmlWrap.h>
+#include <SeqEvent.h>
+#include <MIDIDefs.h>
+#include <MIDIControl.h>
+#include <Instrument.h>
+#include <Sequencer.h>
+#include <VoicePolicy.h>
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#if UNIX
+#include <time.h>
+#endif
+
+// Time in seconds for render time measurement.
+static double PolicyTime()
+{
+#if _WIN32
+	LARGE_INTEGER cnt;
+	LARGE_INTEGER frq;
+	QueryPerformanceCounter(&cnt);
+	QueryPerformanceFrequency(&frq);
+	return (double) cnt.QuadPart / (double) frq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + ((double) ts.tv_nsec * 1.0e-9);
+#endif
+}
+
+VoicePolicy::VoicePolicy()
+{
+	maxVoices = 32;
+	minVoices = 8;
+	cpuLimit = maxVoices;
+	stolen = 0;
+	steal = VOICE_STEAL_RELEASE;
+	budget = 0;
+	voiceCost = 0;
+	renderStart = 0;
+	for (int n = 0; n < VOICE_CHANNELS; n++)
+	{
+		chnlLimit[n] = 0;
+		chnlPri[n] = 0;
+	}
+}
+
+void VoicePolicy::Reset()
+{
+	cpuLimit = maxVoices;
+	stolen = 0;
+	voiceCost = 0;
+}
+
+ActiveEvent *VoicePolicy::Select(ActiveEvent *head, ActiveEvent *tail, ActiveEvent *act, bsInt32 count)
+{
+	ActiveEvent *vp;
+
+	// Check the channel limit first. When the channel
+	// is over, only notes on that channel are candidates.
+	int chnl = act->chnl;
+	int sameChnl = 0;
+	if (chnl >= 0 && chnl < VOICE_CHANNELS && chnlLimit[chnl] > 0)
+	{
+		bsInt32 n = 0;
+		for (vp = head; vp != tail; vp = vp->next)
+		{
+			if (vp->chnl == chnl)
+				n++;
+		}
+		sameChnl = n > chnlLimit[chnl];
+	}
+	if (!sameChnl && count <= GetLimit())
+		return 0;
+
+	int excl = -1;
+	if ((steal & VOICE_STEAL_EXCL) && act->ip)
+		excl = act->ip->GetExclGroup();
+
+	ActiveEvent *best = 0;
+	int bestExcl = 0;
+	int bestPri = 0;
+	int bestRel = 0;
+	AmpValue bestLvl = 0;
+	for (vp = head; vp != tail; vp = vp->next)
+	{
+		if (vp == act || vp->ip == 0 || (sameChnl && vp->chnl != chnl))
+			continue;
+		int vExcl = excl >= 0 && vp->ip->GetExclGroup() == excl;
+		int vPri = Priority(vp->chnl);
+		int vRel = (steal & VOICE_STEAL_RELEASE) && vp->ison == SEQ_AE_REL;
+		AmpValue vLvl = 0;
+		if (steal & VOICE_STEAL_LEVEL)
+			vLvl = vp->ip->GetLevel();
+		if (best)
+		{
+			// on a tie, keep the older note
+			if (vExcl != bestExcl)
+			{
+				if (vExcl < bestExcl)
+					continue;
+			}
+			else if (vPri != bestPri)
+			{
+				if (vPri > bestPri)
+					continue;
+			}
+			else if (vRel != bestRel)
+			{
+				if (vRel < bestRel)
+					continue;
+			}
+			else if (vLvl >= bestLvl)
+				continue;
+		}
+		best = vp;
+		bestExcl = vExcl;
+		bestPri = vPri;
+		bestRel = vRel;
+		bestLvl = vLvl;
+	}
+	if (best)
+		stolen++;
+	return best;
+}
+
+int VoicePolicy::Timed()
+{
+	return budget > 0;
+}
+
+void VoicePolicy::StartRender()
+{
+	renderStart = PolicyTime();
+}
+
+// The cost per voice is averaged over several blocks so that
+// one slow block (e.g., a page fault or preemption) does not
+// cut the polyphony.
+void VoicePolicy::EndRender(bsInt32 frames, bsInt32 voices)
+{
+	if (frames <= 0 || voices <= 0)
+		return;
+	double cost = (PolicyTime() - renderStart) / ((double) frames * (double) voices);
+	if (voiceCost == 0)
+		voiceCost = cost;
+	else
+		voiceCost += (cost - voiceCost) * 0.1;
+
+	bsInt32 fit = maxVoices;
+	if (voiceCost > 0)
+	{
+		double n = budget / (voiceCost * synthParams.sampleRate);
+		if (n < (double) maxVoices)
+			fit = (bsInt32) n;
+	}
+	if (fit < minVoices)
+		fit = minVoices;
+	if (fit < cpuLimit)
+		cpuLimit = fit;
+	else if (fit > cpuLimit)
+		cpuLimit++;
+}
@@ -20,6 +20,7 @@
 #include "EnvGen.h"
 #include "EnvGenSeg.h"
 #include "GenWaveWT.h"
+#include "SynthSIMD.h"
 #include "Mixer.h"
 
 int main(int argc, char *argv[])
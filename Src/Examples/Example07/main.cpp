@@ -21,6 +21,7 @@
 #include "WaveFile.h"
 #include "GenWaveWT.h"
 #include "EnvGen.h"
+#include "SynthSIMD.h"
 #include "Mixer.h"
 #include "DelayLine.h"
 
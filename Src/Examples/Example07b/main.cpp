@@ -18,6 +18,7 @@
 #include "GenWaveWT.h"
 #include "GenWaveX.h"
 #include "EnvGen.h"
+#include "SynthSIMD.h"
 #include "Mixer.h"
 #include "DelayLine.h"
 #include "AllPass.h"
@@ -26,6 +26,7 @@
 #include "GenNoise.h"
 #include "BiQuad.h"
 #include "DelayLine.h"
+#include "SynthSIMD.h"
 #include "Mixer.h"
 #include "SynthList.h"
 #include "XmlWrap.h"
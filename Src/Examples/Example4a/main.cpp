@@ -23,6 +23,7 @@
 #include "EnvGenSeg.h"
 #include "GenWaveWT.h"
 #include "Filter.h"
+#include "SynthSIMD.h"
 #include "Mixer.h"
 #include "SFFile.h"
 #include "DLSFile.h"
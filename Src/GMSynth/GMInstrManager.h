@@ -21,10 +21,9 @@
 /// by the MIDI CC# 7 on a per-channel basis. The mixer inputs
 /// are, therefore, redunant.
 ///
-/// This implementation adds/destroys instruments on each
-/// note. A possible improvement is to maintain a cache
-/// of instruments, much the same way a keyboard synth
-/// has a fixed number of voices.
+/// Finished GMPlayer instances are kept by the instrument
+/// configuration and reused for later notes, much the same
+/// way a keyboard synth has a fixed number of voices.
 class GMInstrManager : public InstrManager
 {
 protected:
@@ -70,11 +69,13 @@ public:
 
 	virtual Instrument *Allocate(bsInt16 inum)
 	{
-		return GMPlayer::InstrFactory(this, gm);
+		return Allocate(FindInstr(inum));
 	}
 
 	virtual Instrument *Allocate(InstrConfig *in)
 	{
+		if (in)
+			return in->Allocate(this);
 		return GMPlayer::InstrFactory(this, gm);
 	}
 
@@ -21,6 +21,14 @@ typedef struct _GUID
 #endif
 #endif
 
+/// Maximum number of notes
+#define GMSYNTH_MAXVOICES 64
+/// Fraction of real time for rendering notes during live playback
+#define GMSYNTH_BUDGET 0.5
+/// Level (-80dB) and time after which a released note is silent
+#define GMSYNTH_SILENCE 0.0001
+#define GMSYNTH_SILENT_TIME 0.05
+
 static const GUID GMSYNTH_MAGIC  =
 { 0x2d257162, 0x432b, 0x438d, { 0xbd, 0x5e, 0x86, 0x9a, 0xbb, 0x7, 0x3a, 0x3c } };
 
@@ -31,9 +39,11 @@ class GMSynthDLL : public SynthThread
 private:
 	GMInstrManager inmgr;
 	SequencerCB seq;
+	VoicePolicy voices;
 	SeqState seqMode;
 	WaveFile wvf;
 	SoundBank *sbnk;
+	SoundBankLoader loader;
 	SMFFile midFile;
 	MIDIInput kbd;
 	GMSYNTHCB usrCB;
@@ -66,7 +76,14 @@ public:
 		magic = GMSYNTH_MAGIC;
 		sbnk = 0;
 		seqMode = seqOff;
-		seq.SetMaxNotes(32);
+		// Polyphony is limited by render time during live playback.
+		// Drums are kept over melodic notes.
+		voices.SetMaxVoices(GMSYNTH_MAXVOICES);
+		voices.SetSteal(VOICE_STEAL_RELEASE|VOICE_STEAL_LEVEL|VOICE_STEAL_EXCL);
+		voices.SetChannelPriority(9, 1);
+		seq.SetMaxNotes(GMSYNTH_MAXVOICES);
+		seq.SetVoicePolicy(&voices);
+		seq.SetSilence(GMSYNTH_SILENCE, GMSYNTH_SILENT_TIME);
 		kbd.SetSequenceInfo(&seq, &inmgr);
 		wvf.SetBufSize(30);
 		ldTm = 0.5;
@@ -488,6 +505,9 @@ void GMSynthDLL::OnEvent(bsInt16 evtid, const SeqEvent *evt)
 int GMSynthDLL::Unload()
 {
 	midFile.Reset();
+	SoundBank *bnk;
+	for (bnk = SoundBank::SoundBankList.next; bnk; bnk = bnk->next)
+		loader.Detach(bnk);
 	SoundBank::SoundBankList.DeleteBankList();
 	return GMSYNTH_NOERROR;
 }
@@ -498,19 +518,12 @@ int GMSynthDLL::LoadSoundBank(const char *alias, const char *fileName, int prelo
 	sb = SoundBank::SoundBankList.FindBank(alias);
 	if (sb != NULL)
 	{
+		loader.Detach(sb);
 		sb->Unlock();
 		sb = 0;
 	}
-	if (SFFile::IsSF2File(fileName))
-	{
-		SFFile file;
-		sb = file.LoadSoundBank(fileName, preload);
-	}
-	else if (DLSFile::IsDLSFile(fileName))
-	{
-		DLSFile file;
-		sb = file.LoadSoundBank(fileName, preload);
-	}
+	if (SFFile::IsSF2File(fileName) || DLSFile::IsDLSFile(fileName))
+		sb = SoundBankCache::LoadSoundBank(fileName, preload);
 	else
 		return GMSYNTH_ERR_FILETYPE;
 
@@ -522,6 +535,9 @@ int GMSynthDLL::LoadSoundBank(const char *alias, const char *fileName, int prelo
 	SoundBank::SoundBankList.Insert(sb);
 	inmgr.SetSoundBank(sb, scl);
 	sbnk = sb;
+	// load instruments for live input in the background
+	if (loader.Attach(sb) == 0 && loader.Start() == 0)
+		inmgr.SetPrefetch(&loader);
 	return GMSYNTH_NOERROR;
 }
 
@@ -633,9 +649,11 @@ int GMSynthDLL::ThreadProc()
 			ldTm = 0.20;
 		OpenWaveDevice();
 		inmgr.SetWaveOut(&wvd);
+		voices.SetTimeBudget(GMSYNTH_BUDGET);
 	}
 	else
 	{
+		voices.SetTimeBudget(0);
 		if (wvf.OpenWaveFile(outFileName, 2))
 		{
 			OnEvent(SEQEVT_SEQSTOP, NULL);
@@ -644,6 +662,7 @@ int GMSynthDLL::ThreadProc()
 		inmgr.SetWaveOut(&wvf);
 	}
 	inmgr.Reset();
+	voices.Reset();
 	seq.SequenceMulti(inmgr, stTime, endTime, seqMode);
 	if (live)
 	{
@@ -782,7 +801,12 @@ int GMSynthDLL::GetPreset(short bank, short preset, char *txt, size_t len)
 void GMSynthDLL::ImmediateEvent(short mmsg, short val1, short val2)
 {
 	if ((mmsg & 0xf0) == MIDI_PRGCHG && sbnk != 0)
-		sbnk->GetInstr(inmgr.GetBank(mmsg&0x0f), val1, 1);
+	{
+		if (loader.IsRunning())
+			loader.Prefetch(inmgr.GetBank(mmsg&0x0f), val1);
+		else
+			sbnk->GetInstr(inmgr.GetBank(mmsg&0x0f), val1, 1);
+	}
 	if (seq.GetState() != seqOff)
 		kbd.MIDIInput::ReceiveMessage(mmsg, val1, val2, 0);
 	else if (mmsg <= MIDI_SYSEX && (mmsg & 0xF0) > MIDI_NOTEON)
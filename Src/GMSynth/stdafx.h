@@ -32,7 +32,9 @@
 #include <SynthThread.h>
 #include <Instruments.h>
 #include <SFFile.h>
+#include <SoundBankLoader.h>
 #include <DLSFile.h>
+#include <SoundBankCache.h>
 #include <SMFFile.h>
 #include <GMPlayer.h>
 #ifdef _WIN32
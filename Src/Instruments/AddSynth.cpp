@@ -53,6 +53,7 @@ static InstrParamMap addsynthParams[] =
 	{ "lfowt", 17 },
 	{ "lvl", 6 },
 	{ "mul", 0 },
+	{ "rsin", 21 },
 	{ "rt",  5 },
 	{ "son", 4 },
 	{ "st",  3 },
@@ -122,6 +123,7 @@ AddSynth::AddSynth()
 	vol = 1.0;
 	numParts = 0;
 	parts = NULL;
+	rsOn = 0;
 }
 
 AddSynth::AddSynth(AddSynth *tp)
@@ -141,6 +143,8 @@ int AddSynth::SetNumParts(int n)
 {
 	if (n < 1)
 		return -1;
+	if (n == numParts)
+		return 0;
 	AddSynthPart *newParts = new AddSynthPart[n];
 	if (newParts == NULL)
 		return -1;
@@ -151,6 +155,7 @@ int AddSynth::SetNumParts(int n)
 	delete[] parts;
 	parts = newParts;
 	numParts = n;
+	bank.Alloc(n);
 	return 0;
 }
 
@@ -171,6 +176,7 @@ void AddSynth::Copy(AddSynth *tp)
 	frq = tp->frq;
 	vol = tp->vol;
 	chnl = tp->chnl;
+	rsOn = tp->rsOn;
 	SetNumParts(tp->GetNumParts());
 	for (int n = 0; n < numParts; n++)
 		parts[n].Copy(&tp->parts[n]);
@@ -193,20 +199,79 @@ void AddSynth::UpdateParams(SeqEvent *evt, float initPhs)
 {
 	SetParams((VarParamEvent *)evt);
 
+	int p;
+	if (initPhs < 0)
+	{
+		for (p = 0; p < numParts; p++)
+		{
+			if (bank.rs[p] >= 0)
+				bank.ndx[p] = PhaseRS(p);
+		}
+	}
+
+	// The resonator is only used for sine waves, and
+	// cannot be modulated by the LFO.
+	AmpValue *rsWT = NULL;
+	if (rsOn && !lfoGen.On())
+		rsWT = wtSet.GetWavetable(WT_SIN);
+
 	FrqValue nyquist = synthParams.sampleRate / 2;
-	AddSynthPart *pEnd = &parts[numParts];
-	AddSynthPart *pSig = parts;
-	for (pSig = parts; pSig < pEnd; pSig++)
+	bank.numTab = 0;
+	bank.numRS = 0;
+	for (p = 0; p < numParts; p++)
 	{
+		AddSynthPart *pSig = &parts[p];
 		FrqValue f = frq * pSig->mul;
 		if (f >= nyquist)
 			f = 0;
 		pSig->osc.SetFrequency(f);
 		pSig->osc.Reset(initPhs);
 		pSig->env.Reset(initPhs);
+		if (initPhs >= 0)
+			bank.ndx[p] = pSig->osc.index;
+		bank.incr[p] = pSig->osc.indexIncr;
+		bank.wt[p] = pSig->osc.waveTable;
+		if (bank.wt[p] == rsWT)
+		{
+			// y[n] = 2cos(w)y[n-1] - y[n-2], set so that
+			// the next output is the sine of the current phase.
+			int j = bank.numRS++;
+			PhsAccum w = bank.incr[p] / synthParams.radTI;
+			PhsAccum phs = bank.ndx[p] / synthParams.radTI;
+			bank.rsCoef[j] = 2.0 * cos(w);
+			bank.rsY1[j] = sin(phs - w);
+			bank.rsY2[j] = sin(phs - w - w);
+			bank.rs[p] = j;
+		}
+		else
+		{
+			bank.tab[bank.numTab++] = p;
+			bank.rs[p] = -1;
+		}
 	}
 	lfoGen.SetSigFrq(frq);
+	if (initPhs == 0)
+		lfoGen.SetCtlRate(synthParams.ctlRate);
 	lfoGen.Reset(initPhs);
+	if (initPhs == 0)
+	{
+		lfoCtl.Init(synthParams.ctlRate);
+		lfoCtl.Start(lfoGen);
+	}
+}
+
+// Recover the phase of a recursive sine part from the last two outputs.
+// With y1 = sin(a) and y2 = sin(a-w), cos(a) = (y1cos(w) - y2) / sin(w).
+PhsAccum AddSynth::PhaseRS(int p)
+{
+	int j = bank.rs[p];
+	PhsAccum w = bank.incr[p] / synthParams.radTI;
+	PhsAccum sw = sin(w);
+	if (sw == 0)
+		return bank.ndx[p];
+	PhsAccum ca = ((bank.rsY1[j] * cos(w)) - bank.rsY2[j]) / sw;
+	PhsAccum phs = atan2(bank.rsY1[j], ca) + w;
+	return parts[p].osc.PhaseWrapWT(phs * synthParams.radTI);
 }
 
 void AddSynth::Stop()
@@ -225,22 +290,165 @@ void AddSynth::Tick()
 	PhsAccum phs = 0;
 	int lfoOn = lfoGen.On();
 	if (lfoOn)
-		phs = lfoGen.Gen() * synthParams.frqTI;
+		phs = lfoCtl.Gen(lfoGen) * synthParams.frqTI;
 
 	AmpValue sigVal = 0;
-	AddSynthPart *pSig = parts;
-	AddSynthPart *pEnd = &parts[numParts];
-	while (pSig < pEnd)
+	for (int p = 0; p < numParts; p++)
 	{
-		if (lfoOn)
-			pSig->osc.PhaseModWT(phs * pSig->mul);
-		sigVal += pSig->env.Gen() * pSig->osc.Gen();
-		pSig++;
+		AddSynthPart *pSig = &parts[p];
+		AmpValue oscVal;
+		int j = bank.rs[p];
+		if (j >= 0)
+		{
+			PhsAccum y = (bank.rsCoef[j] * bank.rsY1[j]) - bank.rsY2[j];
+			bank.rsY2[j] = bank.rsY1[j];
+			bank.rsY1[j] = y;
+			oscVal = (AmpValue) y;
+		}
+		else
+		{
+			// same as GenWaveWT::PhaseModWT() and Gen()
+			PhsAccum index = bank.ndx[p];
+			if (lfoOn)
+				index += phs * pSig->mul;
+			index = pSig->osc.PhaseWrapWT(index);
+			AmpValue *wt = bank.wt[p];
+#ifdef USE_OSCILI
+			int intIndex = (int) index;
+			PhsAccum fract = index - (PhsAccum) intIndex;
+			AmpValue2 v1 = (AmpValue2) wt[intIndex];
+			AmpValue2 v2 = (AmpValue2) wt[intIndex+1];
+			oscVal = (AmpValue) (v1 + ((v2 - v1) * fract));
+#else
+			oscVal = wt[(int) (index + 0.5)];
+#endif
+			bank.ndx[p] = index + bank.incr[p];
+		}
+		sigVal += pSig->env.Gen() * oscVal;
 	}
 
 	im->Output(chnl, sigVal * vol);
 }
 
+// Block version of Tick(). The block is generated in pieces
+// of SIMD_BLKSIZE, the size of the bank output arrays.
+int AddSynth::TickBlock(int frames)
+{
+	AmpValue out[MAX_TICKBLOCK];
+	for (int n = 0; n < frames; n += SIMD_BLKSIZE)
+	{
+		int cnt = frames - n;
+		if (cnt > SIMD_BLKSIZE)
+			cnt = SIMD_BLKSIZE;
+		GenBlock(&out[n], cnt);
+	}
+	synthSIMD.Mul(out, out, vol, frames);
+	im->OutputBlock(chnl, out, frames);
+	return 1;
+}
+
+// Sum the parts for up to SIMD_BLKSIZE samples. All oscillators
+// in the bank are stepped together, one sample at a time, so the
+// calculations for different parts can overlap. The parts are then
+// added to the sum in the same order as Tick().
+void AddSynth::GenBlock(AmpValue *sig, int frames)
+{
+	PhsAccum phs[SIMD_BLKSIZE];
+	AmpValue eg[SIMD_BLKSIZE];
+	AmpValue osc[SIMD_BLKSIZE];
+	PhsAccum len = synthParams.ftableLength;
+	int n, j, p, t;
+
+	int lfoOn = lfoGen.On();
+	if (lfoOn)
+	{
+		for (n = 0; n < frames; n++)
+			phs[n] = lfoCtl.Gen(lfoGen) * synthParams.frqTI;
+	}
+
+	// same as Tick(), including the phase wrap from GenWaveWT.
+	int numTab = bank.numTab;
+	for (n = 0; n < frames; n++)
+	{
+		for (t = 0; t < numTab; t++)
+		{
+			p = bank.tab[t];
+			PhsAccum index = bank.ndx[p];
+			if (lfoOn)
+				index += phs[n] * parts[p].mul;
+			if (index >= len)
+			{
+				do
+					index -= len;
+				while (index >= len);
+			}
+			else if (index < 0)
+			{
+				do
+					index += len;
+				while (index < 0);
+			}
+#ifdef USE_OSCILI
+			bsInt32 intIndex = (bsInt32) index;
+			bank.tabNdx[t*SIMD_BLKSIZE + n] = intIndex;
+			bank.tabFr[t*SIMD_BLKSIZE + n] = index - (PhsAccum) intIndex;
+#else
+			bank.tabNdx[t*SIMD_BLKSIZE + n] = (bsInt32) (index + 0.5);
+#endif
+			bank.ndx[p] = index + bank.incr[p];
+		}
+	}
+
+	int numRS = bank.numRS;
+	AmpValue *rs = bank.rsOut;
+	for (n = 0; n < frames; n++)
+	{
+		for (j = 0; j < numRS; j++)
+		{
+			PhsAccum y = (bank.rsCoef[j] * bank.rsY1[j]) - bank.rsY2[j];
+			bank.rsY2[j] = bank.rsY1[j];
+			bank.rsY1[j] = y;
+			rs[j] = (AmpValue) y;
+		}
+		rs += numRS;
+	}
+
+	for (n = 0; n < frames; n++)
+		sig[n] = 0;
+
+	t = 0;
+	for (p = 0; p < numParts; p++)
+	{
+		AddSynthPart *pSig = &parts[p];
+		j = bank.rs[p];
+		int k = j < 0 ? t++ : -1;
+		// A finished part adds nothing, and the phase
+		// is reset before it is heard again.
+		if (pSig->env.IsFinished() && pSig->env.GetValue() == 0)
+			continue;
+		if (k >= 0)
+		{
+#ifdef USE_OSCILI
+			synthSIMD.LookupI(osc, bank.wt[p], &bank.tabNdx[k*SIMD_BLKSIZE], &bank.tabFr[k*SIMD_BLKSIZE], frames);
+#else
+			synthSIMD.Lookup(osc, bank.wt[p], &bank.tabNdx[k*SIMD_BLKSIZE], frames);
+#endif
+		}
+		else
+		{
+			rs = &bank.rsOut[j];
+			for (n = 0; n < frames; n++)
+			{
+				osc[n] = *rs;
+				rs += numRS;
+			}
+		}
+		pSig->env.GenBlock(eg, frames);
+		for (n = 0; n < frames; n++)
+			sig[n] += eg[n] * osc[n];
+	}
+}
+
 int  AddSynth::IsFinished()
 {
 	AddSynthPart *pSig = parts;
@@ -260,8 +468,21 @@ void AddSynth::Destroy()
 	delete this;
 }
 
+int AddSynth::Recycle()
+{
+	return 1;
+}
+
+int AddSynth::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((AddSynth*)tmplt);
+	return 0;
+}
+
 /*************
-<instr parts="n">
+<instr parts="n" rsin="n">
  <part pn="n"  mul="n" frq="n" wt="n" />
    <env segs="n" st="n" son="n">
     <seg sn="n" rt="n" lvl="n" ty="t" />
@@ -280,6 +501,8 @@ int AddSynth::Load(XmlSynthElem *parent)
 
 	if (parent->GetAttribute("parts", ival) == 0)
 		SetNumParts(ival);
+	if (parent->GetAttribute("rsin", ival) == 0)
+		rsOn = (int) ival;
 
 	XmlSynthElem *elem;
 	XmlSynthElem *next = parent->FirstChild();
@@ -355,6 +578,7 @@ int AddSynth::Save(XmlSynthElem *parent)
 	XmlSynthElem *segElem;
 
 	parent->SetAttribute("parts", (short)numParts);
+	parent->SetAttribute("rsin", (short)rsOn);
 	AddSynthPart *p = parts;
 	for (int n = 0; n < numParts; n++, p++)
 	{
@@ -451,7 +675,10 @@ int AddSynth::SetParam(bsInt16 idval, float val)
 			break;
 		case 20:
 			// num parts not settable
-			//break;
+			return 1;
+		case 21:
+			rsOn = (int) val;
+			break;
 		default:
 			return 1;
 		}
@@ -510,6 +737,7 @@ int AddSynth::GetParams(VarParamEvent *params)
 	params->SetParam(18, (float)lfoGen.GetAttack());
 	params->SetParam(19, (float)lfoGen.GetLevel());
 	params->SetParam(20, (float)numParts);
+	params->SetParam(21, (float)rsOn);
 
 	int pn, sn, segs, idval;
 	for (pn = 0; pn < numParts; pn++)
@@ -559,6 +787,9 @@ int AddSynth::GetParam(bsInt16 idval, float* val)
 		case 20:
 			*val = (float) numParts;
 			break;
+		case 21:
+			*val = (float) rsOn;
+			break;
 		default:
 			return 1;
 		}
@@ -45,6 +45,100 @@ struct AddSynthPart
 	}
 };
 
+/// @brief Oscillator bank for the AddSynth parts.
+/// @details The oscillator phase for each part is kept in
+/// parallel arrays, indexed by part number. Parts that use a
+/// wavetable are listed in tab. Parts generated by the recursive
+/// sine are assigned a slot in the rs arrays. The tabNdx and
+/// rsOut arrays hold one block of values for each part.
+struct AddSynthBank
+{
+	PhsAccum *ndx;    ///< table index (phase) of each part
+	PhsAccum *incr;   ///< table index increment
+	AmpValue **wt;    ///< wavetable
+	int *rs;          ///< recursive sine slot, or -1 for the wavetable
+	int *tab;         ///< parts that use the wavetable
+	int numTab;       ///< number of parts in tab
+	PhsAccum *rsCoef; ///< 2cos(w) for each slot
+	PhsAccum *rsY1;   ///< last output
+	PhsAccum *rsY2;   ///< output before the last
+	int numRS;        ///< number of recursive sine slots
+	bsInt32 *tabNdx;  ///< [tab][SIMD_BLKSIZE] table indexes
+	PhsAccum *tabFr;  ///< [tab][SIMD_BLKSIZE] fraction of index (USE_OSCILI)
+	AmpValue *rsOut;  ///< [SIMD_BLKSIZE][rs] outputs
+
+	AddSynthBank()
+	{
+		ndx = NULL;
+		incr = NULL;
+		wt = NULL;
+		rs = NULL;
+		tab = NULL;
+		rsCoef = NULL;
+		rsY1 = NULL;
+		rsY2 = NULL;
+		tabNdx = NULL;
+		tabFr = NULL;
+		rsOut = NULL;
+		numTab = 0;
+		numRS = 0;
+	}
+
+	~AddSynthBank()
+	{
+		Free();
+	}
+
+	/// Release the arrays.
+	void Free()
+	{
+		delete[] ndx;
+		delete[] incr;
+		delete[] wt;
+		delete[] rs;
+		delete[] tab;
+		delete[] rsCoef;
+		delete[] rsY1;
+		delete[] rsY2;
+		delete[] tabNdx;
+		delete[] tabFr;
+		delete[] rsOut;
+	}
+
+	/// Allocate the arrays for n parts.
+	/// All parts are set to the sine wavetable.
+	/// @param n number of parts
+	void Alloc(int n)
+	{
+		Free();
+		ndx = new PhsAccum[n];
+		incr = new PhsAccum[n];
+		wt = new AmpValue*[n];
+		rs = new int[n];
+		tab = new int[n];
+		rsCoef = new PhsAccum[n];
+		rsY1 = new PhsAccum[n];
+		rsY2 = new PhsAccum[n];
+		tabNdx = new bsInt32[n*SIMD_BLKSIZE];
+#ifdef USE_OSCILI
+		tabFr = new PhsAccum[n*SIMD_BLKSIZE];
+#else
+		tabFr = NULL;
+#endif
+		rsOut = new AmpValue[n*SIMD_BLKSIZE];
+		for (int p = 0; p < n; p++)
+		{
+			ndx[p] = 0;
+			incr[p] = 0;
+			wt[p] = wtSet.GetWavetable(WT_SIN);
+			rs[p] = -1;
+			tab[p] = p;
+		}
+		numTab = n;
+		numRS = 0;
+	}
+};
+
 /// @brief Implements an additive synthesis instrument.
 /// @details AddSynth contains a dynamic array of AddSynthPart
 /// objects, each of which functions as a semi-independent
@@ -55,6 +149,16 @@ struct AddSynthPart
 /// to cross-fade between waveforms, implementing a form
 /// of wavetable synthesis.
 ///
+/// The phase of each part is kept in an oscillator bank,
+/// a set of parallel arrays, so that TickBlock() can step
+/// each oscillator through a block with a tight loop and
+/// do the table lookups with the \ref synthSIMD kernels.
+/// When the recursive sine option is set, parts that use
+/// the sine wavetable are generated with a two-pole
+/// resonator instead of the table. This is faster, but
+/// the partials cannot be modulated by the LFO, and it is
+/// only used when the LFO is off.
+///
 /// Parameter ids for AddSynth contain 3 fields:
 /// @code
 /// [pn(6)][sn(4)][val(4)]
@@ -70,6 +174,9 @@ struct AddSynthPart
 /// PN+SN+7	Segment curve type: 1=linear 2=exponential 3=log 4=squared.
 /// PN+SN+8 Fixed (1) or relative (0) time
 /// @endcode
+/// Parameters 16-19 are the LFO, 20 is the number of parts (read-only)
+/// and 21 is the recursive sine option, 1 or 0.
+///
 /// For example, to set the wavetable on oscillator 2, use
 /// @code
 /// SetParam((2 << 8)+2, index)
@@ -83,11 +190,19 @@ private:
 	AddSynthPart *parts;
 	int numParts;
 	LFO lfoGen;
+	GenCtl lfoCtl;
+
+	AddSynthBank bank;
+	int rsOn;
 
 	InstrManager *im;
 
 	/// Internal function used to update instrument parameters during playback.
 	void UpdateParams(SeqEvent *evt, float initPhs);
+	/// Get the table index for the next sample of a recursive sine part.
+	PhsAccum PhaseRS(int p);
+	/// Generate up to SIMD_BLKSIZE samples for TickBlock().
+	void GenBlock(AmpValue *sig, int frames);
 
 public:
 	AddSynth();
@@ -114,10 +229,16 @@ public:
 	virtual void Stop();
 	/// @copydoc Instrument::Tick
 	virtual void Tick();
+	/// @copydoc Instrument::TickBlock
+	virtual int  TickBlock(int frames);
 	/// @copydoc Instrument::IsFinished
 	virtual int  IsFinished();
 	/// @copydoc Instrument::Destroy
 	virtual void Destroy();
+	/// @copydoc Instrument::Recycle
+	virtual int  Recycle();
+	/// @copydoc Instrument::Reinit
+	virtual int  Reinit(Opaque tmplt);
 
 	/// @copydoc Instrument::Load
 	int Load(XmlSynthElem *parent);
@@ -241,6 +241,19 @@ void BuzzSynth::Destroy()
 	delete this;
 }
 
+int BuzzSynth::Recycle()
+{
+	return 1;
+}
+
+int BuzzSynth::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((BuzzSynth*)tmplt);
+	return 0;
+}
+
 int BuzzSynth::SetParams(VarParamEvent *evt)
 {
 	int err = 0;
@@ -236,6 +236,8 @@ public:
 	virtual void Tick();
 	virtual int  IsFinished();
 	virtual void Destroy();
+	virtual int  Recycle();
+	virtual int  Reinit(Opaque tmplt);
 
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
@@ -206,6 +206,23 @@ void Chuffer::Destroy()
 	delete this;
 }
 
+int Chuffer::Recycle()
+{
+	return 1;
+}
+
+// Copy takes the template's instrument manager,
+// keep the one this instance was made for.
+int Chuffer::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	InstrManager *m = im;
+	Copy((Chuffer*)tmplt);
+	im = m;
+	return 0;
+}
+
 void Chuffer::Start(SeqEvent *evt)
 {
 	SetParams((VarParamEvent*)evt);
@@ -119,14 +119,22 @@ FMSynth::FMSynth()
 	dlyTim = 0.01;
 	dlyDec = 0.1;
 	dlySamps = 0;
+	dlyLeft = 0;
+	released = 0;
 	panOn  = 0;
 	pbOn = 0;
+	blkReady = 0;
+	blkMute = 0;
 }
 
 FMSynth::FMSynth(FMSynth *tp)
 {
 	im = 0;
 	maxPhs = synthParams.ftableLength / 2;
+	dlyLeft = 0;
+	released = 0;
+	blkReady = 0;
+	blkMute = 0;
 	Copy(tp);
 }
 
@@ -191,6 +199,9 @@ AmpValue FMSynth::CalcPhaseMod(AmpValue amp, FrqValue mult)
 void FMSynth::Start(SeqEvent *evt)
 {
 	SetParams((VarParamEvent*)evt);
+	blkReady = 0;
+	dlyLeft = dlySamps;
+	released = 0;
 	FrqValue mul1 = gen2Mult * frq;
 	FrqValue mul2 = gen3Mult * frq;
 	gen1Osc.InitWT(frq*gen1Mult, gen1Wt);
@@ -808,6 +819,7 @@ int FMSynth::GetParam(bsInt16 id, float *val)
 
 void FMSynth::Stop()
 {
+	released = 1;
 	gen1EG.Release();
 	gen2EG.Release();
 	gen3EG.Release();
@@ -816,17 +828,244 @@ void FMSynth::Stop()
 }
 
 
+// The delay tail is counted as the samples are generated,
+// so that tick and block output stop on the same sample.
+// The voice is finished when the next sample would be silent.
 int FMSynth::IsFinished()
 {
 	if (gen1EG.IsFinished())
+		return !dlyOn || (released && dlyLeft <= 1);
+	return 0;
+}
+
+// Count one sample of the delay tail. The tail starts when the note
+// has been released and the carrier envelope is finished. Once the
+// tail is done, the output is silent until IsFinished() is checked.
+int FMSynth::TailDone()
+{
+	if (dlyOn && released && gen1EG.IsFinished() && --dlyLeft <= 0)
 	{
-		if (!dlyOn || --dlySamps <= 0)
-			return 1;
+		dlyLeft = 0;
+		return 1;
 	}
 	return 0;
 }
 
 void FMSynth::Tick()
+{
+	AmpValue sigOut = GenSample();
+	if (panOn)
+		im->Output2(chnl, sigOut * panSet.panlft, sigOut * panSet.panrgt);
+	else
+		im->Output(chnl, sigOut);
+}
+
+int FMSynth::TickBlock(int frames)
+{
+	if (blkReady != frames)
+	{
+		for (int n = 0; n < frames; n++)
+			blkOut[n] = GenSample();
+	}
+	blkReady = 0;
+	if (panOn)
+	{
+		AmpValue sigLft[MAX_TICKBLOCK];
+		AmpValue sigRgt[MAX_TICKBLOCK];
+		synthSIMD.Mul(sigLft, blkOut, panSet.panlft, frames);
+		synthSIMD.Mul(sigRgt, blkOut, panSet.panrgt, frames);
+		im->Output2Block(chnl, sigLft, sigRgt, frames);
+	}
+	else
+		im->OutputBlock(chnl, blkOut, frames);
+	return 1;
+}
+
+// One key for each algorithm. Voices with the same algorithm
+// run the same code for each sample and can be batched.
+static int fmBatchKeys[ALG_DELTA+1];
+
+Opaque FMSynth::BatchKey()
+{
+#ifdef USE_OSCILI
+	// PhaseMod3 does not interpolate
+	return 0;
+#else
+	// Without gather, batching is no faster than one voice at a time.
+	if (synthSIMD.GetLevel() < SIMD_AVX2)
+		return 0;
+	if (algorithm < ALG_STACK || algorithm > ALG_DELTA)
+		return 0;
+	return (Opaque) &fmBatchKeys[algorithm];
+#endif
+}
+
+// With half the lanes or less in use, the batch is no faster than
+// generating each voice separately, and those voices are left for TickBlock().
+int FMSynth::TickBatch(Instrument **voices, int count, int frames)
+{
+	int done = 0;
+	while (count > SIMD_LANES/2)
+	{
+		int lanes = count > SIMD_LANES ? SIMD_LANES : count;
+		GenBatch((FMSynth **) voices, lanes, frames);
+		voices += lanes;
+		count -= lanes;
+		done = 1;
+	}
+	return done;
+}
+
+// Generate a block for up to SIMD_LANES voices with the same algorithm.
+// The envelopes and LFO are generated for each voice, then the
+// oscillators for all voices are calculated together with one voice
+// in each lane. Last, the noise and delay are added for each voice.
+// Each voice does the same calculations in the same order as GenSample().
+void FMSynth::GenBatch(FMSynth **lanes, int count, int frames)
+{
+	AmpValue amp[MAX_TICKBLOCK*3*SIMD_LANES];
+	AmpValue phs[MAX_TICKBLOCK*SIMD_LANES];
+	AmpValue car[MAX_TICKBLOCK*SIMD_LANES];
+	SynthPM3Lanes st;
+	int l;
+
+	int route = 0;
+	switch (lanes[0]->algorithm)
+	{
+	case ALG_STACK:
+		route = SIMD_PM_21;
+		break;
+	case ALG_STACK2:
+		route = SIMD_PM_21|SIMD_PM_32;
+		break;
+	case ALG_WYE:
+		route = SIMD_PM_21|SIMD_PM_31;
+		break;
+	case ALG_DELTA:
+		route = SIMD_PM_31|SIMD_PM_32|SIMD_PM_ADD2;
+		break;
+	}
+
+	for (l = 0; l < SIMD_LANES; l++)
+	{
+		if (l < count)
+			lanes[l]->BatchIn(&st, l, &amp[l], &phs[l], frames, 1);
+		else
+			lanes[0]->BatchIn(&st, l, &amp[l], &phs[l], frames, 0);
+	}
+	synthSIMD.PhaseMod3(car, &st, amp, phs, route, frames);
+	for (l = 0; l < count; l++)
+		lanes[l]->BatchOut(&st, l, &car[l], frames);
+}
+
+// Set up lane l for GenBatch(). Successive amplitude and
+// phase values are 3*SIMD_LANES and SIMD_LANES apart.
+// An unused lane (on == 0) repeats this voice with no output.
+void FMSynth::BatchIn(SynthPM3Lanes *st, int l, AmpValue *amp, AmpValue *phs, int frames, int on)
+{
+	st->index[0][l] = gen1Osc.index;
+	st->incr[0][l] = gen1Osc.indexIncr;
+	st->wt[0][l] = gen1Osc.waveTable;
+	st->mult[0][l] = gen1Mult;
+	st->index[1][l] = gen2Osc.index;
+	st->incr[1][l] = gen2Osc.indexIncr;
+	st->wt[1][l] = gen2Osc.waveTable;
+	st->mult[1][l] = gen2Mult;
+	st->index[2][l] = gen3Osc.index;
+	st->incr[2][l] = gen3Osc.indexIncr;
+	st->wt[2][l] = gen3Osc.waveTable;
+	st->mult[2][l] = gen3Mult;
+
+	int n;
+	AmpValue *ap = amp;
+	if (!on)
+	{
+		for (n = 0; n < frames; n++)
+		{
+			ap[0] = 0;
+			ap[SIMD_LANES] = 0;
+			ap[2*SIMD_LANES] = 0;
+			ap += 3*SIMD_LANES;
+			phs[n*SIMD_LANES] = 0;
+		}
+		return;
+	}
+
+	blkMute = frames;
+	for (n = 0; n < frames; n++)
+	{
+		if (blkMute == frames && TailDone())
+			blkMute = n;
+		ap[0] = gen1EG.Gen();
+		ap[SIMD_LANES] = gen2EG.Gen();
+		ap[2*SIMD_LANES] = gen3EG.Gen();
+		ap += 3*SIMD_LANES;
+	}
+	if (lfoGen.On() || pbOn || pbWT.On())
+	{
+		for (n = 0; n < frames; n++)
+		{
+			AmpValue lfoOut = 0;
+			if (lfoGen.On())
+				lfoOut = lfoGen.Gen() * synthParams.frqTI;
+			if (pbOn)
+				lfoOut += pbGen.Gen() * synthParams.frqTI;
+			if (pbWT.On())
+				lfoOut += pbWT.Gen() * synthParams.frqTI;
+			phs[n*SIMD_LANES] = lfoOut;
+		}
+	}
+	else
+	{
+		for (n = 0; n < frames; n++)
+			phs[n*SIMD_LANES] = 0;
+	}
+}
+
+// Finish lane l after GenBatch() and keep the output for TickBlock().
+// Successive values of car are SIMD_LANES apart.
+void FMSynth::BatchOut(SynthPM3Lanes *st, int l, const AmpValue *car, int frames)
+{
+	gen1Osc.index = st->index[0][l];
+	gen2Osc.index = st->index[1][l];
+	gen3Osc.index = st->index[2][l];
+
+	int n;
+	if (!nzOn && !dlyOn)
+	{
+		for (n = 0; n < frames; n++)
+			blkOut[n] = (car[n*SIMD_LANES] * fmMix) * vol;
+	}
+	else
+	{
+		for (n = 0; n < frames; n++)
+		{
+			AmpValue gen1Out = car[n*SIMD_LANES];
+			AmpValue sigOut = gen1Out * fmMix;
+			AmpValue nzOut = 0;
+			if (nzOn)
+			{
+				nzOut = nzi.Gen() * nzEG.Gen();
+				if (nzFrqo)
+					nzOut *= nzo.Gen();
+				sigOut += nzOut * nzMix;
+			}
+			if (dlyOn)
+			{
+				AmpValue dlyIn = gen1Out * fmDly;
+				dlyIn += nzOut * nzDly;
+				sigOut += apd.Sample(dlyIn) * dlyMix;
+			}
+			blkOut[n] = sigOut * vol;
+		}
+		for (n = blkMute; n < frames; n++)
+			blkOut[n] = 0;
+	}
+	blkReady = frames;
+}
+
+// Generate one sample with volume applied.
+AmpValue FMSynth::GenSample()
 {
 	AmpValue sigOut;
 	AmpValue gen1Out;
@@ -839,6 +1078,9 @@ void FMSynth::Tick()
 	AmpValue gen2Mod;
 	AmpValue gen3Mod;
 
+	if (TailDone())
+		return 0;
+
 	if (lfoGen.On())
 		lfoOut = lfoGen.Gen() * synthParams.frqTI;
 	if (pbOn)
@@ -891,11 +1133,7 @@ void FMSynth::Tick()
 		sigOut += dlyOut * dlyMix;
 	}
 
-	sigOut *= vol;
-	if (panOn)
-		im->Output2(chnl, sigOut * panSet.panlft, sigOut * panSet.panrgt);
-	else
-		im->Output(chnl, sigOut);
+	return sigOut * vol;
 }
 
 void FMSynth::Destroy()
@@ -903,6 +1141,19 @@ void FMSynth::Destroy()
 	delete this;
 }
 
+int FMSynth::Recycle()
+{
+	return 1;
+}
+
+int FMSynth::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((FMSynth*)tmplt);
+	return 0;
+}
+
 void FMSynth::LoadEG(XmlSynthElem *elem, EnvDef& eg)
 {
 	float rt = 0;
@@ -71,6 +71,8 @@ private:
 	FrqValue   dlyDec;
 	AmpValue   dlyMix;
 	long dlySamps;
+	long dlyLeft;   // delay tail samples left after release
+	int released;   // Stop() has been called
 
 	LFO lfoGen;
 	PitchBend pbGen;
@@ -88,7 +90,16 @@ private:
 
 	InstrManager *im;
 
+	AmpValue blkOut[MAX_TICKBLOCK]; // samples generated by TickBatch
+	int blkReady;                   // number of samples in blkOut
+	int blkMute;                    // first sample of blkOut after the delay tail
+
 	AmpValue CalcPhaseMod(AmpValue amp, FrqValue mult);
+	AmpValue GenSample();
+	int TailDone();
+	void BatchIn(SynthPM3Lanes *st, int l, AmpValue *amp, AmpValue *phs, int frames, int on);
+	void BatchOut(SynthPM3Lanes *st, int l, const AmpValue *car, int frames);
+	static void GenBatch(FMSynth **lanes, int count, int frames);
 	void LoadEG(XmlSynthElem *elem, EnvDef& eg);
 	XmlSynthElem *SaveEG(XmlSynthElem *parent, const char *tag, EnvDef& eg);
 
@@ -106,8 +117,13 @@ public:
 	void Param(SeqEvent *evt);
 	void Stop();
 	void Tick();
+	int  TickBlock(int frames);
+	Opaque BatchKey();
+	int  TickBatch(Instrument **voices, int count, int frames);
 	int  IsFinished();
 	void Destroy();
+	int  Recycle();
+	int  Reinit(Opaque tmplt);
 
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
@@ -30,6 +30,8 @@
 #include "Includes.h"
 #include "GMPlayer.h"
 
+bsInt32 GMPlayer::filterRate = 0;
+
 /// Create an instance of the GMPlayer instrument
 Instrument *GMPlayer::InstrFactory(InstrManager *m, Opaque tmplt)
 {
@@ -210,8 +212,10 @@ GMPlayer::GMPlayer()
 	chnl = 0;
 	mkey = 69;
 	novel = 0;
+	exclNote = 0;
 	sostenuto = 0;
 	zoneList = 0;
+	freeZones = 0;
 	pendingStop = 0;
 	sndbnk = 0;
 	pitchBend = 0;
@@ -230,8 +234,10 @@ GMPlayer::GMPlayer(GMPlayer *tmplt, InstrManager *m)
 	chnl = 0;
 	mkey = 69;
 	novel = 0;
+	exclNote = 0;
 	sostenuto = 0;
 	zoneList = 0;
+	freeZones = 0;
 	pendingStop = 0;
 	pitchBend = 0;
 	ctrlAtten = 0;
@@ -264,14 +270,27 @@ GMPlayer::~GMPlayer()
 }
 
 void GMPlayer::ClearZones()
+{
+	RecycleZones();
+	GMPlayerZone *pz;
+	while ((pz = freeZones) != 0)
+	{
+		freeZones = pz->next;
+		delete pz;
+	}
+}
+
+// Move the zones to the free list for the next note.
+void GMPlayer::RecycleZones()
 {
 	GMPlayerZone *pz;
 	while ((pz = zoneList) != 0)
 	{
 		zoneList = pz->next;
-		delete pz;
+		pz->osc.CloseStream();
+		pz->next = freeZones;
+		freeZones = pz;
 	}
-	zoneList = 0;
 }
 
 /// Start playing a note.
@@ -302,8 +321,10 @@ void GMPlayer::Start(SeqEvent *se)
 	SetVolume();
 	rvrbAmnt = (AmpValue) im->GetCCN(chnl, MIDI_CTRL_FX1) / 127.0;
 
+	// With a background loader attached, this returns NULL until
+	// the samples are loaded and the note is silent.
 	if (sndbnk)
-		instr = sndbnk->GetInstr(bnk, prg);
+		instr = sndbnk->RequestInstr(bnk, prg);
 	if (instr)
 	{
 		SBZoneGroup *grp = 0;
@@ -318,9 +339,15 @@ void GMPlayer::Start(SeqEvent *se)
 					zone = ref->zone;
 					if (zone->Match(mkey, novel))
 					{
-						GMPlayerZone *pz = new GMPlayerZone(zone, im, this);
-						if (zoneList)
-							pz->next = zoneList;
+						GMPlayerZone *pz = freeZones;
+						if (pz)
+						{
+							freeZones = pz->next;
+							pz->zone = zone;
+						}
+						else
+							pz = new GMPlayerZone(zone, im, this);
+						pz->next = zoneList;
 						zoneList = pz;
 						pz->Initialize(chnl, mkey, novel);
 						exclNote |= zone->exclNote;
@@ -392,7 +419,7 @@ void GMPlayer::Param(SeqEvent *se)
 		VarParamEvent *evt = (VarParamEvent *)se;
 		if (mkey != (evt->pitch + 12))
 		{
-			ClearZones();
+			RecycleZones();
 			Start(se);
 		}
 	}
@@ -448,6 +475,31 @@ int  GMPlayer::IsFinished()
 	return 1;
 }
 
+// Level of the loudest zone, including the
+// envelope and the initial attenuation.
+AmpValue GMPlayer::GetLevel()
+{
+	AmpValue lvl = 0;
+	GMPlayerZone *pz = zoneList;
+	while (pz)
+	{
+		AmpValue eg = pz->volEnv.GetLevel();
+		if (pz->volEnv.GetSegment() > 2)
+			eg = SoundBank::Attenuation((1.0 - eg) * 960);
+		eg *= SoundBank::Attenuation(pz->initAtten + ctrlAtten);
+		if (eg > lvl)
+			lvl = eg;
+		pz = pz->next;
+	}
+	return lvl;
+}
+
+int GMPlayer::GetExclGroup()
+{
+	if (exclNote)
+		return ((chnl << 4) | (exclNote & 0xf)) & 0xff;
+	return -1;
+}
 
 /// Produce the next sample.
 void GMPlayer::Tick()
@@ -470,6 +522,46 @@ void GMPlayer::Destroy()
 	delete this;
 }
 
+int GMPlayer::Recycle()
+{
+	if (exclNote)
+	{
+		im->ExclNoteOff((chnl << 4) | (exclNote & 0xf), this);
+		exclNote = 0;
+	}
+	RecycleZones();
+	return 1;
+}
+
+int GMPlayer::Reinit(Opaque tmplt)
+{
+	GMPlayer *tp = (GMPlayer *)tmplt;
+	if (tp == 0)
+		return -1;
+	if (sndbnk != tp->sndbnk)
+	{
+		if (sndbnk)
+			sndbnk->Unlock();
+		sndbnk = tp->sndbnk;
+		if (sndbnk)
+			sndbnk->Lock();
+	}
+	instr = 0;
+	chnl = 0;
+	mkey = 69;
+	novel = 0;
+	sostenuto = 0;
+	pendingStop = 0;
+	pitchBend = 0;
+	ctrlAtten = 0;
+	rvrbAmnt = 0;
+	localVals = tp->localVals;
+	bankValue = tp->bankValue;
+	progValue = tp->progValue;
+	attnScale = tp->attnScale;
+	return 0;
+}
+
 void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 {
 	chnl = ch;
@@ -490,6 +582,11 @@ void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 	else
 		localVol = 0;
 
+	// The derived values are calculated when the sound bank
+	// is built. This only repeats that if the sample rate changed.
+	if (zone->derivedRate != synthParams.sampleRate)
+		zone->Precompute();
+
 	genFlags = zone->genFlags;
 
 	// Initialize parameter values
@@ -500,26 +597,33 @@ void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 
 	// Initialize oscillator.
 	// Calculate cents ratio for phase increment updates.
-	FrqValue smpl;
-	if (zone->rate != synthParams.isampleRate)
-	{
-		double wsrCents = 1200.0 * SoundBank::log2((double)zone->rate/440.0);
-		double srCents = 1200.0 * SoundBank::log2((double)synthParams.sampleRate/440.0);
-		smpl = FrqValue(wsrCents - srCents);
-	}
-	else
-		smpl = 0;
 	FrqValue adjKey = FrqValue(noKey + zone->coarseTune - zone->keyNum);
 	FrqValue adjCents = FrqValue(zone->fineTune) * 0.01;
-	initPitch = (FrqValue(zone->scaleTune) * (adjKey + adjCents)) - zone->cents + smpl;
+	initPitch = (FrqValue(zone->scaleTune) * (adjKey + adjCents)) - zone->cents + zone->rateCents;
 	osc.InitSB(zone, SoundBank::GetPow2n1200(initPitch));
+	if (zone->sample->IsStreamed() && player->sndbnk)
+		osc.SetStream(player->sndbnk->OpenStream(zone->sample, osc.GetStartFrame()));
 
 	// Initialize LFO
-	vibLfo.InitWT(SoundBank::Frequency(zone->vibLfo.rate), WT_SIN);
-	vibDelay = (bsInt32) (SoundBank::EnvRate(zone->vibLfo.delay) * synthParams.sampleRate);
-
-	modLfo.InitWT(SoundBank::Frequency(zone->modLfo.rate), WT_SIN);
-	modDelay = (bsInt32) (SoundBank::EnvRate(zone->modLfo.delay) * synthParams.sampleRate);
+	// At a control rate above 1, the LFOs and EG2 advance
+	// ctlRate samples per call and the ramps fill in between.
+	bsInt32 ctlRate = synthParams.ctlRate;
+	if (ctlRate < 1)
+		ctlRate = 1;
+	vibLfo.InitWT(zone->vibLfoHz, WT_SIN);
+	vibDelay = zone->vibDelayN;
+	vibCtl.Init(ctlRate);
+
+	modLfo.InitWT(zone->modLfoHz, WT_SIN);
+	modDelay = zone->modDelayN;
+	lfoCtl.Init(ctlRate);
+	if (ctlRate > 1)
+	{
+		vibLfo.Modulate(zone->vibLfoHz * (FrqValue) (ctlRate - 1));
+		modLfo.Modulate(zone->modLfoHz * (FrqValue) (ctlRate - 1));
+	}
+	vibCtl.Start(vibLfo);
+	lfoCtl.Start(modLfo);
 
 	// Initialize volume envelope
 	FrqValue km;
@@ -530,65 +634,62 @@ void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 	else
 		km = 0;
 
-	volEnv.SetDelay(SoundBank::EnvRate(zone->volEg.delay));
-	volEnv.SetAttack(SoundBank::EnvRate(zone->volEg.attack + (veln * zone->volEg.velAttack)));
-	volEnv.SetHold(SoundBank::EnvRate(zone->volEg.hold + (km * zone->volEg.keyHold)));
-	volEnv.SetDecay(SoundBank::EnvRate(zone->volEg.decay + (km * zone->volEg.keyDecay)));
-	if (genFlags & SBGEN_SF2)
-	{
-		if (zone->volEg.sustain <= 0)
-			volEnv.SetSustain(1.0);
-		else if (zone->volEg.sustain < 960.0)
-			volEnv.SetSustain((960.0 - zone->volEg.sustain) / 960.0);
-		else
-			volEnv.SetSustain(0.0);
-	}
+	volEnv.SetDelay(zone->volRt.delay);
+	if (zone->volEg.velAttack != 0)
+		volEnv.SetAttack(SoundBank::EnvRate(zone->volEg.attack + (veln * zone->volEg.velAttack)));
+	else
+		volEnv.SetAttack(zone->volRt.attack);
+	if (zone->volEg.keyHold != 0)
+		volEnv.SetHold(SoundBank::EnvRate(zone->volEg.hold + (km * zone->volEg.keyHold)));
+	else
+		volEnv.SetHold(zone->volRt.hold);
+	if (zone->volEg.keyDecay != 0)
+		volEnv.SetDecay(SoundBank::EnvRate(zone->volEg.decay + (km * zone->volEg.keyDecay)));
 	else
-		volEnv.SetSustain(zone->volEg.sustain * 0.001);
-	volEnv.SetRelease(SoundBank::EnvRate(zone->volEg.release));
+		volEnv.SetDecay(zone->volRt.decay);
+	volEnv.SetSustain(zone->volRt.sustain);
+	volEnv.SetRelease(zone->volRt.release);
 	volEnv.Reset(0);
 
 	// Initialize modulation envelope
 	if (genFlags & SBGEN_EG2X)
 	{
-		modEnv.SetDelay(SoundBank::EnvRate(zone->modEg.delay));
-		modEnv.SetAttack(SoundBank::EnvRate(zone->modEg.attack + (veln * zone->modEg.velAttack)));
-		modEnv.SetHold(SoundBank::EnvRate(zone->modEg.hold + (km * zone->modEg.keyHold)));
-		modEnv.SetDecay(SoundBank::EnvRate(zone->modEg.decay + (km * zone->modEg.keyDecay)));
-		if (genFlags & SBGEN_SF2)
-		{
-			if (zone->modEg.sustain <= 0)
-				modEnv.SetSustain(1.0);
-			else if (zone->modEg.sustain >= 1000.0)
-				modEnv.SetSustain(0.0);
-			else
-				modEnv.SetSustain(1.0f - (zone->modEg.sustain * 0.001));
-		}
+		FrqValue ctlTime = 1.0 / (FrqValue) ctlRate;
+		modEnv.SetDelay(zone->modRt.delay * ctlTime);
+		if (zone->modEg.velAttack != 0)
+			modEnv.SetAttack(SoundBank::EnvRate(zone->modEg.attack + (veln * zone->modEg.velAttack)) * ctlTime);
+		else
+			modEnv.SetAttack(zone->modRt.attack * ctlTime);
+		if (zone->modEg.keyHold != 0)
+			modEnv.SetHold(SoundBank::EnvRate(zone->modEg.hold + (km * zone->modEg.keyHold)) * ctlTime);
+		else
+			modEnv.SetHold(zone->modRt.hold * ctlTime);
+		if (zone->modEg.keyDecay != 0)
+			modEnv.SetDecay(SoundBank::EnvRate(zone->modEg.decay + (km * zone->modEg.keyDecay)) * ctlTime);
 		else
-			modEnv.SetSustain(zone->modEg.sustain * 0.001);
-		modEnv.SetRelease(SoundBank::EnvRate(zone->modEg.release));
+			modEnv.SetDecay(zone->modRt.decay * ctlTime);
+		modEnv.SetSustain(zone->modRt.sustain);
+		modEnv.SetRelease(zone->modRt.release * ctlTime);
 		modEnv.Reset(0);
+		egCtl.Init(ctlRate);
+		egCtl.Start(modEnv);
 	}
 
 	// Initialize filter
 	// Filters are "expensive" - only init if used.
-	// the flag gets set if there is a modulator
+	// The zone sets the flag if there is a modulator
 	// applied to the filter and the frequency
-	// is below the maximum.
-	float initFilter = zone->filtFreq;// + (SoundBank::posLinear[127-noVel] * zone->velFlt);
-	float dynFilter = zone->modLfoFlt + zone->modLfoMwFlt + zone->modEnvFlt;
-	if (initFilter > SoundBank::maxFilter)
-		genFlags &= ~SBGEN_FILTERX;
-	else if ((initFilter + dynFilter) > SoundBank::minFilter)
-		genFlags |= SBGEN_FILTERX;
+	// is below the maximum. The coefficients for the
+	// initial cutoff are calculated with the zone.
 	if (genFlags & SBGEN_FILTERX)
 	{
-		if (dynFilter > 0)
-			genFlags |= SBGEN_FILTERD;
-		fcFlt = (bsInt16)initFilter;
-		gainQ = SoundBank::Gain(zone->filtQ)/2.0f;
-		filt.CalcCoef(SoundBank::Frequency((bsInt16)initFilter), gainQ);
+		fcFlt = (bsInt16)zone->filtFreq;
+		fcCount = 0;
+		fcRate = filterRate > 0 ? filterRate : ctlRate;
+		gainQ = zone->filtGainQ;
+		// Reset first, it finishes a move left from the last note.
 		filt.Reset();
+		filt.InitFilter(zone->filtCoef[0], zone->filtCoef[1], zone->filtCoef[2]);
 		// Reduce amplitude for High 'Q' values.
 		// See DLS 2.2, sec 1.5.2
 		initAtten += zone->filtQ / 2.0f;
@@ -637,19 +738,19 @@ void GMPlayer::GMPlayerZone::Gen()
 
 	if (genFlags & SBGEN_EG2X)
 	{
-		float eg2 = modEnv.Gen();
+		float eg2 = egCtl.Gen(modEnv);
 		pitchVal += eg2 * zone->modEnvFrq;
 		filtVal += eg2 * zone->modEnvFlt;
 	}
 
 	if (vibDelay == 0 || --vibDelay == 0)
 	{
-		pitchVal += vibLfo.Gen() * vibLfoFrq;
+		pitchVal += vibCtl.Gen(vibLfo) * vibLfoFrq;
 	}
 
 	if (genFlags & SBGEN_LFO2X && (modDelay == 0 || --modDelay == 0))
 	{
-		float lfo = modLfo.Gen();
+		float lfo = lfoCtl.Gen(modLfo);
 		pitchVal += lfo * modLfoFrq;
 		filtVal += lfo * modLfoFlt;
 		attenVal += (1.0 + lfo) * 0.5 * modLfoVol;
@@ -670,15 +771,18 @@ void GMPlayer::GMPlayerZone::Gen()
 	// filter
 	if (genFlags & SBGEN_FILTERX)
 	{
-		if (genFlags & SBGEN_FILTERD)
+		// A modulated cutoff is checked at the control rate,
+		// and the filter moves to the new cutoff until the next check.
+		if ((genFlags & SBGEN_FILTERD) && --fcCount <= 0)
 		{
+			fcCount = fcRate;
 			if (filtVal > SoundBank::maxFilter)
 				filtVal = SoundBank::maxFilter;
 			bsInt32 fcCents = (bsInt32)filtVal;
 			if (fcCents != fcFlt)
 			{
 				fcFlt = fcCents;
-				filt.CalcCoef(SoundBank::Frequency(filtVal), gainQ);
+				filt.MoveCoef(SoundBank::Frequency(filtVal), gainQ, fcRate);
 			}
 		}
 		out = filt.Sample(out);
@@ -63,11 +63,16 @@ private:
 		EnvGenSB  modEnv;   ///< modulation envelope (EG2)
 		GenWaveWT vibLfo;   ///< LF pitch variation
 		GenWaveWT modLfo;   ///< LF amplitude variation
-		FilterIIR2p filt;   ///< Filter
+		GenCtl egCtl;       ///< control rate ramp for EG2
+		GenCtl vibCtl;      ///< control rate ramp for vibrato
+		GenCtl lfoCtl;      ///< control rate ramp for modulator
+		FilterIIR2pI filt;  ///< Filter
 		bsInt32 genFlags;   ///< map of generators that are operational
 		bsInt32 vibDelay;   ///< delay before vibrato begins to affect output
 		bsInt32 modDelay;   ///< delay before modulator begins to affect output
 		bsInt32 fcFlt;     ///< Last filter fc in cents
+		bsInt32 fcCount;   ///< samples until the next filter fc update
+		bsInt32 fcRate;    ///< samples between filter fc updates
 
 		bsInt16 chnl;       ///< Playback channel
 		bsInt16 noKey;      ///< Note-on key number
@@ -99,6 +104,7 @@ private:
 	};
 
 	GMPlayerZone *zoneList;
+	GMPlayerZone *freeZones; ///< zones kept for the next note
 
 	bsInt16 chnl;       ///< MIDI channel
 	bsInt16 mkey;       ///< MIDI key number
@@ -119,10 +125,18 @@ private:
 	bsString sndFile;    ///< sound file name
 
 	void ClearZones();
+	void RecycleZones();
 	void SetVolume();
 
 	friend class GMPlayerZone;
 public:
+	/// Number of samples between updates of a modulated filter cutoff.
+	/// The filter coefficients are interpolated between updates.
+	/// A value of 1 updates the filter whenever the cutoff changes by
+	/// one cent. The default, 0, uses synthParams.ctlRate, so the
+	/// filter is exact unless a control rate is selected.
+	static bsInt32 filterRate;
+
 	static Instrument *InstrFactory(InstrManager *m, Opaque tmplt);
 	static SeqEvent *EventFactory(Opaque tmplt);
 	static bsInt16 MapParamID(const char *name, Opaque tmplt);
@@ -144,7 +158,11 @@ public:
 	virtual void Cancel();
 	virtual void Tick();
 	virtual int  IsFinished();
+	virtual AmpValue GetLevel();
+	virtual int GetExclGroup();
 	virtual void Destroy();
+	virtual int  Recycle();
+	virtual int  Reinit(Opaque tmplt);
 
 	virtual VarParamEvent *AllocParams();
 	virtual int GetParams(VarParamEvent *params);
@@ -26,6 +26,7 @@ LFO::LFO()
 	depth = 0;
 	sigFrq = 0;
 	ampLvl = 1.0;
+	ctlRate = 1;
 	lfoOn = 0;
 }
 
@@ -72,7 +73,7 @@ void LFO::Init(int n, float *f)
 void LFO::Reset(float initPhs)
 {
 	if (initPhs == 0)
-		atk.InitSeg(atkRt, 0.0, 1.0);
+		atk.InitSeg(atkRt / (FrqValue) ctlRate, 0.0, 1.0);
 	else
 		atk.Reset(initPhs);
 	if (sigFrq != 0)
@@ -84,6 +85,8 @@ void LFO::Reset(float initPhs)
 	else
 		ampLvl = depth;
 	osc.Reset(initPhs);
+	if (ctlRate > 1)
+		osc.Modulate(osc.GetFrequency() * (FrqValue) (ctlRate - 1));
 }
 
 int LFO::Load(XmlSynthElem *elem)
@@ -23,6 +23,7 @@ private:
 	AmpValue ampLvl;
 	FrqValue sigFrq;
 	FrqValue atkRt;
+	bsInt32 ctlRate;
 	int lfoOn;
 
 public:
@@ -35,6 +36,9 @@ public:
 	void SetAttack(FrqValue val)    { atkRt = val; }
 	void SetLevel(AmpValue val)     { depth = val; lfoOn = depth > 0; }
 	void SetSigFrq(FrqValue val)    { sigFrq = val; }
+	/// Set the number of samples that each call to Gen() advances.
+	/// This is used with GenCtl and takes effect on the next Reset().
+	void SetCtlRate(bsInt32 k)      { ctlRate = k < 1 ? 1 : k; }
 	FrqValue GetFrequency() { return osc.GetFrequency(); }
 	int GetWavetable() { return osc.GetWavetable(); }
 	FrqValue GetAttack() { return atkRt; }
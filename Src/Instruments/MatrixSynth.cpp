@@ -164,6 +164,9 @@ MatrixSynth::MatrixSynth()
 	panOn = 0;
 	allFlags = 0;
 	envUsed = 0;
+	blkOff = 0;
+	blkCount = 0;
+	blkOK = 0;
 	for (int n = 0; n < MATGEN; n++)
 		envs[n].SetSegs(1);
 }
@@ -172,6 +175,9 @@ MatrixSynth::MatrixSynth(MatrixSynth *tp)
 {
 	im = NULL;
 	maxPhs = synthParams.ftableLength/2;
+	blkOff = 0;
+	blkCount = 0;
+	blkOK = 0;
 	Copy(tp);
 }
 
@@ -248,15 +254,96 @@ void MatrixSynth::Start(SeqEvent *evt)
 	fx3On = (allFlags & TONE_FX3OUT) ? 1 : 0;
 	fx4On = (allFlags & TONE_FX4OUT) ? 1 : 0;
 	panOn = (allFlags & TONE_PAN) ? 1 : 0;
+	bsInt32 ctlRate = synthParams.ctlRate;
 	if (lfoOn)
+	{
+		lfoGen.SetCtlRate(ctlRate);
 		lfoGen.Reset(0);
+		lfoCtl.Init(ctlRate);
+		lfoCtl.Start(lfoGen);
+	}
 	if (pbOn)
+	{
+		pbGen.SetCtlRate(ctlRate);
 		pbGen.Reset(0);
+		pbCtl.Init(ctlRate);
+		pbCtl.Start(pbGen);
+	}
 	if (pbWTOn)
 	{
 		pbWT.SetDurationS(evt->duration);
+		pbWT.SetCtlRate(ctlRate);
 		pbWT.Reset(0);
+		pbWTCtl.Init(ctlRate);
+		pbWTCtl.Start(pbWT);
+	}
+	BuildPlan();
+}
+
+// Build the order for block evaluation. A generator's phase
+// modulation for the next sample uses the current sample of
+// each modulator, so a block can be generated once the blocks
+// for all modulators are complete. A generator that modulates
+// itself, directly or through others, must be run one sample
+// at a time.
+void MatrixSynth::BuildPlan()
+{
+	bsUint16 deps[MATGEN];
+	bsUint16 onMask = 0;
+	int t, m;
+
+	for (t = 0; t < MATGEN; t++)
+	{
+		if (gens[t].toneFlags & TONE_ON)
+			onMask |= 1 << t;
+	}
+	blkOff = ~onMask & ((1 << MATGEN) - 1);
+
+	for (t = 0; t < MATGEN; t++)
+	{
+		bsUint32 flgs = gens[t].toneFlags;
+		blkNumMods[t] = 0;
+		deps[t] = 0;
+		for (m = 0; m < MATGEN; m++)
+		{
+			if (flgs & (TONE_MOD1IN << m))
+			{
+				blkMods[t][blkNumMods[t]++] = m;
+				deps[t] |= (1 << m) & onMask;
+			}
+		}
+	}
+
+	blkCount = 0;
+	bsUint16 done = 0;
+	bsUint16 left = onMask;
+	while (left)
+	{
+		bsUint16 ready = 0;
+		for (t = 0; t < MATGEN; t++)
+		{
+			if ((left & (1 << t)) && (deps[t] & ~done) == 0)
+			{
+				ready |= 1 << t;
+				blkOrder[blkCount++] = t;
+			}
+		}
+		if (ready == 0)
+		{
+			blkOK = 0;
+			return;
+		}
+		done |= ready;
+		left &= ~ready;
+	}
+
+	// Generators that are off still have the phase modulated.
+	for (t = 0; t < MATGEN; t++)
+	{
+		if ((blkOff & (1 << t)) && (gens[t].toneFlags & TONE_MODANY))
+			blkOrder[blkCount++] = t;
 	}
+	blkOK = 1;
 }
 
 void MatrixSynth::Param(SeqEvent *evt)
@@ -278,6 +365,7 @@ void MatrixSynth::Param(SeqEvent *evt)
 		pbGen.Reset(-1);
 	if (pbWTOn)
 		pbWT.Reset(-1);
+	BuildPlan();
 }
 
 int MatrixSynth::SetParams(VarParamEvent *params)
@@ -789,13 +877,13 @@ void MatrixSynth::Tick()
 
 	if (lfoOn)
 	{
-		lfoAmp = lfoGen.Gen();
+		lfoAmp = lfoCtl.Gen(lfoGen);
 		lfoRad = lfoAmp * synthParams.frqTI;
 	}
 	if (pbOn)
-		pbRad = pbGen.Gen() * synthParams.frqTI;
+		pbRad = pbCtl.Gen(pbGen) * synthParams.frqTI;
 	if (pbWTOn)
-		pbRad = pbWT.Gen() * synthParams.frqTI;
+		pbRad = pbWTCtl.Gen(pbWT) * synthParams.frqTI;
 
 	// Run the envelope generators
 	envFlgs = envUsed;
@@ -892,6 +980,183 @@ void MatrixSynth::Tick()
 	im->Output(chnl, sigOut * vol);
 }
 
+// Block version of Tick(). Each generator produces a block
+// of samples in the order set by BuildPlan(), then the outputs
+// are summed in generator order, the same as Tick().
+int MatrixSynth::TickBlock(int frames)
+{
+	if (!blkOK)
+		return 0;
+
+	AmpValue lfoAmp[MAX_TICKBLOCK];
+	AmpValue lfoRad[MAX_TICKBLOCK];
+	AmpValue pbRad[MAX_TICKBLOCK];
+	AmpValue egVal[MATGEN][MAX_TICKBLOCK];
+	AmpValue outVal[MATGEN][MAX_TICKBLOCK];
+	PhsAccum phm[MAX_TICKBLOCK+1];
+	int n, t;
+
+	for (n = 0; n < frames; n++)
+	{
+		AmpValue amp = 0;
+		AmpValue rad = 0;
+		AmpValue pb = 0;
+		if (lfoOn)
+		{
+			amp = lfoCtl.Gen(lfoGen);
+			rad = amp * synthParams.frqTI;
+		}
+		if (pbOn)
+			pb = pbCtl.Gen(pbGen) * synthParams.frqTI;
+		if (pbWTOn)
+			pb = pbWTCtl.Gen(pbWT) * synthParams.frqTI;
+		lfoAmp[n] = amp;
+		lfoRad[n] = rad;
+		pbRad[n] = pb;
+	}
+
+	bsUint16 envFlgs = envUsed;
+	for (t = 0; t < MATGEN; t++)
+	{
+		if (envFlgs & 1)
+		{
+			EnvGenSegSus *envPtr = &envs[t];
+			AmpValue *eg = egVal[t];
+			for (n = 0; n < frames; n++)
+				eg[n] = envPtr->Gen();
+		}
+		envFlgs >>= 1;
+		if (blkOff & (1 << t))
+			memset(outVal[t], 0, frames*sizeof(AmpValue));
+	}
+
+	bsUint32 modAny = allFlags & TONE_MODANY;
+	int k;
+	for (k = 0; k < blkCount; k++)
+	{
+		t = blkOrder[k];
+		MatrixTone *tSig = &gens[t];
+		bsUint32 flgs = tSig->toneFlags;
+		int pm = modAny && (flgs & TONE_MODANY);
+		if (pm)
+		{
+			// phm[n+1] is applied after sample n
+			const bsInt16 *mods = blkMods[t];
+			int numMods = blkNumMods[t];
+			phm[0] = 0;
+			for (n = 0; n < frames; n++)
+			{
+				PhsAccum phs;
+				if (flgs & TONE_LFOIN)
+					phs = lfoRad[n] * tSig->lfoLvl;
+				else
+					phs = 0;
+				if (flgs & TONE_PBIN)
+					phs += pbRad[n] * tSig->frqMult;
+				for (int j = 0; j < numMods; j++)
+					phs += outVal[mods[j]][n] * gens[mods[j]].modRad;
+				phm[n+1] = phs;
+			}
+		}
+		if (flgs & TONE_ON)
+		{
+			AmpValue *out = outVal[t];
+			AmpValue *eg = egVal[tSig->envIndex];
+			if (pm)
+				tSig->osc.GenBlockPM(out, phm, frames);
+			else
+				tSig->osc.GenBlock(out, frames);
+			if (flgs & TONE_TREM)
+			{
+				for (n = 0; n < frames; n++)
+					out[n] = (out[n] * eg[n]) + lfoAmp[n];
+			}
+			else
+			{
+				for (n = 0; n < frames; n++)
+					out[n] *= eg[n];
+			}
+			if (pm)
+				tSig->PhaseModWT(phm[frames]);
+		}
+		else if (pm)
+		{
+			for (n = 1; n <= frames; n++)
+				tSig->PhaseModWT(phm[n]);
+		}
+	}
+
+	AmpValue sig[MAX_TICKBLOCK];
+	AmpValue sigOut[MAX_TICKBLOCK];
+	AmpValue sigLft[MAX_TICKBLOCK];
+	AmpValue sigRgt[MAX_TICKBLOCK];
+	AmpValue fx1Out[MAX_TICKBLOCK];
+	AmpValue fx2Out[MAX_TICKBLOCK];
+	AmpValue fx3Out[MAX_TICKBLOCK];
+	AmpValue fx4Out[MAX_TICKBLOCK];
+	size_t blkSize = frames*sizeof(AmpValue);
+	memset(sigOut, 0, blkSize);
+	if (panOn)
+	{
+		memset(sigLft, 0, blkSize);
+		memset(sigRgt, 0, blkSize);
+	}
+	if (fx1On)
+		memset(fx1Out, 0, blkSize);
+	if (fx2On)
+		memset(fx2Out, 0, blkSize);
+	if (fx3On)
+		memset(fx3Out, 0, blkSize);
+	if (fx4On)
+		memset(fx4Out, 0, blkSize);
+
+	for (t = 0; t < MATGEN; t++)
+	{
+		MatrixTone *tSig = &gens[t];
+		bsUint32 flgs = tSig->toneFlags;
+		if ((flgs & (TONE_ON|TONE_OUT)) != (TONE_ON|TONE_OUT))
+			continue;
+		synthSIMD.Mul(sig, outVal[t], tSig->volLvl, frames);
+		if (flgs & TONE_PAN)
+		{
+			synthSIMD.MulAdd(sigLft, sig, tSig->panSet.panlft, frames);
+			synthSIMD.MulAdd(sigRgt, sig, tSig->panSet.panrgt, frames);
+		}
+		else
+		{
+			for (n = 0; n < frames; n++)
+				sigOut[n] += sig[n];
+		}
+		if (flgs & TONE_FX1OUT)
+			synthSIMD.MulAdd(fx1Out, sig, tSig->fx1Lvl, frames);
+		if (flgs & TONE_FX2OUT)
+			synthSIMD.MulAdd(fx2Out, sig, tSig->fx2Lvl, frames);
+		if (flgs & TONE_FX3OUT)
+			synthSIMD.MulAdd(fx3Out, sig, tSig->fx3Lvl, frames);
+		if (flgs & TONE_FX4OUT)
+			synthSIMD.MulAdd(fx4Out, sig, tSig->fx4Lvl, frames);
+	}
+
+	if (fx1On)
+		im->FxSendBlock(0, fx1Out, frames);
+	if (fx2On)
+		im->FxSendBlock(1, fx2Out, frames);
+	if (fx3On)
+		im->FxSendBlock(2, fx3Out, frames);
+	if (fx4On)
+		im->FxSendBlock(3, fx4Out, frames);
+
+	if (panOn)
+	{
+		synthSIMD.Mul(sigLft, sigLft, vol, frames);
+		synthSIMD.Mul(sigRgt, sigRgt, vol, frames);
+		im->Output2Block(chnl, sigLft, sigRgt, frames);
+	}
+	synthSIMD.Mul(sigOut, sigOut, vol, frames);
+	im->OutputBlock(chnl, sigOut, frames);
+	return 1;
+}
+
 int  MatrixSynth::IsFinished()
 {
 	// Test envelope generators on signal outputs...
@@ -912,6 +1177,19 @@ void MatrixSynth::Destroy()
 	delete this;
 }
 
+int MatrixSynth::Recycle()
+{
+	return 1;
+}
+
+int MatrixSynth::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((MatrixSynth*)tmplt);
+	return 0;
+}
+
 int MatrixSynth::LoadEnv(XmlSynthElem *elem)
 {
 	short en = -1;
@@ -105,6 +105,9 @@ private:
 	LFO lfoGen;
 	PitchBend pbGen;
 	PitchBendWT pbWT;
+	GenCtl lfoCtl;
+	GenCtl pbCtl;
+	GenCtl pbWTCtl;
 
 	int lfoOn;
 	int panOn;
@@ -116,10 +119,19 @@ private:
 	int fx4On;
 	bsUint32 allFlags;
 
+	// Block evaluation plan, built on Start and Param.
+	bsInt16 blkOrder[MATGEN];         // generators, each after its modulators
+	bsInt16 blkMods[MATGEN][MATGEN];  // modulators of each generator
+	bsInt16 blkNumMods[MATGEN];       // number of modulators
+	bsUint16 blkOff;                  // generators that are not on
+	int blkCount;                     // entries in blkOrder
+	int blkOK;                        // no feedback in the matrix
+
 	InstrManager *im;
 
 	int LoadEnv(XmlSynthElem *elem);
 	int SaveEnv(XmlSynthElem *elem, int en);
+	void BuildPlan();
 
 public:
 	MatrixSynth();
@@ -144,10 +156,16 @@ public:
 	void Stop();
 	/// Generate the next sample sending output to the instrument manager
 	void Tick();
+	/// Generate a block of samples; returns 0 when modulation has feedback
+	int  TickBlock(int frames);
 	/// Return true if all envelopes are complete
 	int  IsFinished();
 	/// Destroy this instance
 	void Destroy();
+	/// Keep this instance for reuse
+	int  Recycle();
+	/// Reinitialize a recycled instance from the template
+	int  Reinit(Opaque tmplt);
 
 	/// Load parameters from the project file
 	int Load(XmlSynthElem *parent);
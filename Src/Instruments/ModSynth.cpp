@@ -5,7 +5,11 @@
 //
 // Maintains a list of unit generators and scans the list on each tick.
 // In general, each ug implements a wrapper around one of the BasicSynth
-// library GenUnit classes.
+// library GenUnit classes. The list is compiled into an array
+// when the instrument is loaded or copied, and each ug compiles its
+// connections so that values are stored directly into the inputs
+// of the destination ug. The order of the list is kept since a
+// connection to a ug earlier in the list is delayed one sample.
 //
 // Type          Use
 //--------------------------------------------------
@@ -414,6 +418,13 @@ ModSynth::ModSynth()
 	chnl = 0;
 	frq = 0;
 	im = 0;
+	plan = 0;
+	planLen = -1;
+	blkIn = 0;
+	blkFirst = 0;
+	blkVal = 0;
+	blkSent = 0;
+	blkOK = 0;
 	head.Insert(&tail);
 	head.SetName("@sr");
 	head.SetInput(0, synthParams.sampleRate);
@@ -437,15 +448,113 @@ ModSynth::~ModSynth()
 		ug->Remove();
 		delete ug;
 	}
+	delete[] plan;
+	delete[] blkIn;
+	delete[] blkFirst;
+	delete[] blkVal;
+	delete[] blkSent;
+}
+
+void ModSynth::Compile()
+{
+	delete[] plan;
+	planLen = 0;
+	ModSynthUG *ug;
+	for (ug = head.next; ug; ug = ug->next)
+		planLen++;
+	plan = new ModSynthUG*[planLen];
+	planLen = 0;
+	for (ug = head.next; ug; ug = ug->next)
+		plan[planLen++] = ug;
+	CompileBlock();
+}
+
+// If every unit sends only to units later in the list, each
+// unit can run for a whole block before the next one. Build the
+// block links for each unit in the order the sources would send
+// the values during Tick(). Patches with feedback use Tick().
+void ModSynth::CompileBlock()
+{
+	delete[] blkIn;
+	delete[] blkFirst;
+	delete[] blkVal;
+	delete[] blkSent;
+	blkIn = 0;
+	blkFirst = 0;
+	blkVal = 0;
+	blkSent = 0;
+	blkOK = 0;
+
+	// the out unit must be last, and its output is not sent
+	if (planLen < 1 || plan[planLen-1] != &tail)
+		return;
+
+	int total = 0;
+	int src, dst;
+	ModSynthConn *conn;
+	blkFirst = new int[planLen+1];
+	memset(blkFirst, 0, (planLen+1)*sizeof(int));
+	for (src = 0; src < planLen; src++)
+	{
+		conn = 0;
+		while ((conn = plan[src]->ConnectList(conn)) != 0)
+		{
+			if (!(conn->when & UGP_GEN))
+				continue;
+			for (dst = src+1; dst < planLen; dst++)
+			{
+				if (plan[dst] == conn->ug)
+					break;
+			}
+			if (dst >= planLen)
+				return; // feedback, or not in the plan
+			// panning in the out unit changes the output method
+			if (conn->ug == &tail && conn->index == UGOUT_PON)
+				return;
+			blkFirst[dst+1]++;
+			total++;
+		}
+	}
+	for (dst = 0; dst < planLen; dst++)
+		blkFirst[dst+1] += blkFirst[dst];
+
+	int *fill = new int[planLen];
+	memcpy(fill, blkFirst, planLen*sizeof(int));
+	blkIn = new ModSynthBlkIn[total > 0 ? total : 1];
+	blkVal = new AmpValue[planLen*MAX_TICKBLOCK];
+	blkSent = new bsInt32[planLen*MAX_TICKBLOCK];
+	for (src = 0; src < planLen; src++)
+	{
+		conn = 0;
+		while ((conn = plan[src]->ConnectList(conn)) != 0)
+		{
+			if (!(conn->when & UGP_GEN))
+				continue;
+			for (dst = src+1; plan[dst] != conn->ug; dst++)
+				;
+			ModSynthBlkIn *bp = &blkIn[fill[dst]++];
+			bp->val = &blkVal[src*MAX_TICKBLOCK];
+			bp->sent = &blkSent[src*MAX_TICKBLOCK];
+			bp->lnk.ug = conn->ug;
+			bp->lnk.index = conn->index;
+			conn->ug->GetInputLink(conn->index, &bp->lnk);
+		}
+	}
+	delete[] fill;
+	blkOK = 1;
 }
 
 void ModSynth::Start(SeqEvent *evt)
 {
+	if (planLen < 0)
+		Compile();
+
 	SetParams((VarParamEvent *)evt);
 
-	ModSynthUG *ug;
-	for (ug = head.next; ug; ug = ug->next)
-		ug->Start();
+	ModSynthUG **pp = plan;
+	ModSynthUG **pe = pp + planLen;
+	while (pp < pe)
+		(*pp++)->Start();
 }
 
 void ModSynth::Param(SeqEvent *evt)
@@ -457,32 +566,75 @@ void ModSynth::Param(SeqEvent *evt)
 
 void ModSynth::Stop()
 {
-	ModSynthUG *ug = head.next;
-	do
-		ug->Stop();
-	while ((ug = ug->next) != 0);
+	ModSynthUG **pp = plan;
+	ModSynthUG **pe = pp + planLen;
+	while (pp < pe)
+		(*pp++)->Stop();
 }
 
 int ModSynth::IsFinished()
 {
-	ModSynthUG *ug = head.next;
-	do
+	ModSynthUG **pp = plan;
+	ModSynthUG **pe = pp + planLen;
+	while (pp < pe)
 	{
-		if (!ug->IsFinished())
+		if (!(*pp++)->IsFinished())
 			return 0;
-	} while ((ug = ug->next) != 0);
+	}
 	return 1;
 }
 
 void ModSynth::Tick()
 {
-	ModSynthUG *ug = head.next;
-	do
-		ug->Tick();
-	while ((ug = ug->next) != 0);
+	ModSynthUG **pp = plan;
+	ModSynthUG **pe = pp + planLen;
+	while (pp < pe)
+		(*pp++)->Tick();
 	tail.Output(im, chnl);
 }
 
+// Block version of Tick(). Each unit runs for the whole block
+// in list order, then the out unit mixes the block.
+int ModSynth::TickBlock(int frames)
+{
+	if (!blkOK)
+		return 0;
+
+	int last = planLen - 1;
+	int k;
+	for (k = 0; k < last; k++)
+	{
+		plan[k]->TickBlock(&blkIn[blkFirst[k]], blkFirst[k+1] - blkFirst[k],
+			&blkVal[k*MAX_TICKBLOCK], &blkSent[k*MAX_TICKBLOCK], frames);
+	}
+
+	AmpValue lft[MAX_TICKBLOCK];
+	AmpValue rgt[MAX_TICKBLOCK];
+	ModSynthBlkIn *in = &blkIn[blkFirst[last]];
+	ModSynthBlkIn *ie = &blkIn[blkFirst[last+1]];
+	for (int n = 0; n < frames; n++)
+	{
+		for (ModSynthBlkIn *ip = in; ip < ie; ip++)
+		{
+			if (ip->sent[n])
+				ip->lnk.Apply(ip->val[n]);
+		}
+		tail.Tick();
+		if (tail.panOn)
+		{
+			lft[n] = tail.lftOut;
+			rgt[n] = tail.rgtOut;
+		}
+		else
+			lft[n] = tail.out;
+	}
+	if (tail.panOn)
+		im->Output2Block(chnl, lft, rgt, frames);
+	else
+		im->OutputBlock(chnl, lft, frames);
+	return 1;
+}
+
 int ModSynth::SetParams(VarParamEvent *vp)
 {
 	chnl = vp->chnl;
@@ -561,9 +713,8 @@ int ModSynth::GetParam(bsInt16 idval, float *val)
 // pass and then it won't be necessary to search
 // for each ug and parameter by name in the second
 // pass.
-// Even better, we should probably keep a cache
-// of instances so that we only need to reset the
-// configured parameters.
+// Instances started by the sequencer are recycled,
+// see Reinit, so this only runs for new instances.
 void ModSynth::Copy(ModSynth *tp)
 {
 	// First copy all unit generators
@@ -584,6 +735,7 @@ void ModSynth::Copy(ModSynth *tp)
 	// Now copy all connections
 	for (ugOld = &tp->head; ugOld; ugOld = ugOld->next)
 		CopyConn(ugOld);
+	Compile();
 }
 
 void ModSynth::CopyConn(ModSynthUG *ugOld)
@@ -606,6 +758,69 @@ void ModSynth::CopyConn(ModSynthUG *ugOld)
 	}
 }
 
+// Next connection that Copy would have made.
+static ModSynthConn *NextConn(ModSynthUG *ug, ModSynthConn *con)
+{
+	while ((con = ug->ConnectList(con)) != 0 && con->ug == 0)
+		;
+	return con;
+}
+
+// Check that two units send to the same inputs.
+static int SameConnect(ModSynthUG *ug1, ModSynthUG *ug2)
+{
+	ModSynthConn *c1 = NextConn(ug1, 0);
+	ModSynthConn *c2 = NextConn(ug2, 0);
+	while (c1 && c2)
+	{
+		if (c1->ug->GetID() != c2->ug->GetID()
+		 || c1->index != c2->index
+		 || c1->when != c2->when)
+			return 0;
+		c1 = NextConn(ug1, c1);
+		c2 = NextConn(ug2, c2);
+	}
+	return c1 == c2;
+}
+
+int ModSynth::Recycle()
+{
+	return 1;
+}
+
+// A recycled instance was copied from the template and
+// already has the same units and connections. Only the
+// inputs need to be restored. If the template was edited
+// since, the units no longer match and the instance
+// is discarded.
+int ModSynth::Reinit(Opaque tmplt)
+{
+	ModSynth *tp = (ModSynth *)tmplt;
+	if (tp == 0)
+		return -1;
+
+	ModSynthUG *ugOld = &tp->head;
+	ModSynthUG *ugNew = &head;
+	while (ugOld && ugNew)
+	{
+		if (ugOld->GetID() != ugNew->GetID()
+		 || strcmp(ugOld->GetType(), ugNew->GetType()) != 0
+		 || !SameConnect(ugOld, ugNew))
+			return -1;
+		if (ugOld != &tp->head && ugOld != &tp->tail && *ugOld->GetName() != '@')
+			ugNew->CopyInputs(ugOld);
+		ugOld = ugOld->next;
+		ugNew = ugNew->next;
+	}
+	if (ugOld || ugNew)
+		return -1;
+
+	tail.SetInput(3, tp->tail.GetInput(3)); // volume
+	tail.SetInput(4, tp->tail.GetInput(4)); // pan set
+	tail.SetInput(5, tp->tail.GetInput(5)); // pan on/off
+	return 0;
+}
+
 int ModSynth::GetNumUnits()
 {
 	if (numUnits == 0)
@@ -640,6 +855,7 @@ ModSynthUG *ModSynth::AddUnit(const char *type, const char *name, ModSynthUG *be
 		ug->SetID(++maxID);
 		ug->SetName(name);
 		numUnits++;
+		planLen = -1;
 		ug->GetNumInputs();
 	}
 	return ug;
@@ -687,6 +903,7 @@ void ModSynth::MoveUnit(ModSynthUG *ug, ModSynthUG *before)
 	{
 		ug->Remove();
 		before->InsertBefore(ug);
+		planLen = -1;
 	}
 }
 
@@ -704,6 +921,7 @@ void ModSynth::RemoveUnit(ModSynthUG *ug, int dodel)
 	{
 		numUnits--;
 		ug->Remove();
+		planLen = -1;
 		if (dodel)
 			delete ug;
 	}
@@ -732,12 +950,14 @@ UGValue *ModSynth::AddParam(const char *name, bsInt16 id)
 	ug->SetID(id);
 	ug->SetName(name);
 	head.Insert(ug);
+	planLen = -1;
 	return ug;
 }
 
 void ModSynth::Connect(ModSynthUG *src, ModSynthUG *dst, int input, int when)
 {
 	src->AddConnect(dst, input, when);
+	planLen = -1;
 }
 
 void ModSynth::Connect(ModSynthUG *ug, const char *dst)
@@ -759,7 +979,10 @@ void ModSynth::Connect(ModSynthUG *ug, const char *dst)
 	{
 		const UGParam *p = dstug->FindParam(inp);
 		if (p)
+		{
 			ug->AddConnect(dstug, p->index, p->when);
+			planLen = -1;
+		}
 	}
 }
 
@@ -771,6 +994,7 @@ void ModSynth::Connect(const char *src, const char *dst)
 void ModSynth::Disconnect(ModSynthUG *src, ModSynthUG *dst, int index)
 {
 	src->RemoveConnect(dst, index);
+	planLen = -1;
 }
 
 int ModSynth::Load(XmlSynthElem *parent)
@@ -823,6 +1047,7 @@ int ModSynth::Load(XmlSynthElem *parent)
 		delete child;
 		child = sib;
 	}
+	Compile();
 	return 0;
 }
 
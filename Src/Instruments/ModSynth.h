@@ -37,6 +37,15 @@ private:
 	UGValue head; // sr
 	UGOut   tail; // out
 
+	ModSynthUG **plan; // units in tick order
+	int planLen;       // number of units in plan, -1 when the list changed
+
+	ModSynthBlkIn *blkIn; // block input links, grouped by destination
+	int *blkFirst;        // first block link for each unit in plan
+	AmpValue *blkVal;     // values sent by each unit during a block
+	bsInt32 *blkSent;     // non-zero where a value was sent
+	int blkOK;            // all connections point forward
+
 	UGValue *frqParam;
 	UGValue *volParam;
 	UGValue *durParam;
@@ -59,6 +68,10 @@ public:
 
 	void Copy(ModSynth *tp);
 	void CopyConn(ModSynthUG *ug);
+	int Recycle();
+	int Reinit(Opaque tmplt);
+	void Compile();
+	void CompileBlock();
 
 	int GetNumUnits();
 	int GetNumParams();
@@ -81,6 +94,7 @@ public:
 	void Param(SeqEvent *evt);
 	void Stop();
 	void Tick();
+	int TickBlock(int frames);
 	int IsFinished();
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
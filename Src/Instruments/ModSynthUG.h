@@ -34,6 +34,11 @@
 #define UGP_RUN  (UGP_INIT|UGP_GEN)
 #define UGP_ALL  (UGP_RUN|UGP_SAVE|UGP_LOAD)
 
+// How a compiled connection writes the destination input
+#define UGI_CALL  0  // call SetInput
+#define UGI_SET   1  // store the value
+#define UGI_ADD   2  // add the value to the input
+
 /// UGParam defines one unit generator parameter.
 /// The index value specifies which parameter.
 /// The when value specifies when the parameter is updated.
@@ -70,6 +75,40 @@ public:
 	}
 };
 
+/// ModSynthLink is a compiled connection.
+/// A UG builds an array of links from the connections that are
+/// updated on each sample (UGP_GEN). When the destination input
+/// is a simple value, the link points directly at the input and
+/// change flags so that Send() can store the value without
+/// a call to SetInput. Links are kept in the same order as the
+/// connection list, so the result is the same as calling SetInput.
+class ModSynthLink
+{
+public:
+	float *ip;       ///< destination input
+	bsInt32 *chg;    ///< destination change flags
+	bsInt32 bit;     ///< change flag for this input
+	ModSynthUG *ug;  ///< destination UG
+	short index;     ///< destination input index
+	short mode;      ///< UGI_CALL, UGI_SET or UGI_ADD
+
+	inline void Apply(float value);
+};
+
+/// ModSynthBlkIn is an input link for block generation.
+/// When every unit sends only to units later in the list, each
+/// unit can generate a block of samples before the next unit runs.
+/// The values a unit sends are kept in a buffer, and the
+/// destination applies them before each of its own samples,
+/// in the same order Send() would have stored them.
+class ModSynthBlkIn
+{
+public:
+	const AmpValue *val;  ///< values from the source unit
+	const bsInt32 *sent;  ///< non-zero where the source sent a value
+	ModSynthLink lnk;     ///< destination input
+};
+
 /// ModSynthUG is the interface to any unit generator
 /// that is part of the ModSynth instrument. This is
 /// a pure-virtual base class.
@@ -88,9 +127,16 @@ public:
 	virtual float GetInput(short index) = 0;
 	/// Return the number of input values
 	virtual short GetNumInputs() = 0;
+	/// Fill in a link for direct access to an input.
+	/// A UG that does more than store the value in SetInput()
+	/// must return UGI_ADD or UGI_CALL for that input.
+	virtual int GetInputLink(short index, ModSynthLink *lnk) = 0;
 	virtual void Start() = 0;
 	virtual void Stop() = 0;
 	virtual void Tick() = 0;
+	/// Generate frames samples, applying the inputs from the
+	/// block links first, and store the values sent in val and sent.
+	virtual void TickBlock(ModSynthBlkIn *in, int numIn, AmpValue *val, bsInt32 *sent, int frames) = 0;
 	virtual void Send(float value, short mask) = 0;
 	virtual int IsFinished() = 0;
 	virtual AmpValue GetOutput() = 0;
@@ -104,6 +150,9 @@ public:
 	virtual void RemoveConnect(ModSynthUG *ug, int index = -1) = 0;
 	virtual ModSynthConn *ConnectList(ModSynthConn *last) = 0;
 	virtual ModSynthUG *Copy() = 0;
+	/// Restore the inputs from a unit of the same type,
+	/// as Copy does for a new unit.
+	virtual void CopyInputs(ModSynthUG *tp) = 0;
 	virtual void InitDefault() = 0;
 	virtual int Load(XmlSynthElem *elem) = 0;
 	virtual int Save(XmlSynthElem *elem) = 0;
@@ -111,6 +160,25 @@ public:
 	virtual void DumpConnect(void (*fn)(const char*)) = 0;
 };
 
+/// Store a value the same way as Send().
+inline void ModSynthLink::Apply(float value)
+{
+	switch (mode)
+	{
+	case UGI_SET:
+		*ip = value;
+		*chg |= bit;
+		break;
+	case UGI_ADD:
+		*ip += value;
+		*chg |= bit;
+		break;
+	default:
+		ug->SetInput(index, value);
+		break;
+	}
+}
+
 /// Template for standard unit generators.
 /// A unit generator typically inhertis from
 /// this implementation class, specifying the
@@ -127,6 +195,8 @@ public:
 	bsString name;
 	ModSynthConn chead;
 	ModSynthConn ctail;
+	ModSynthLink *links;
+	int numLinks;
 
 	static ModSynthUG *Construct()
 	{
@@ -140,6 +210,8 @@ public:
 		anyChange = 0;
 		out = 0;
 		id = -1;
+		links = 0;
+		numLinks = 0;
 		chead.Insert(&ctail);
 	}
 
@@ -151,6 +223,7 @@ public:
 			conn->Remove();
 			delete conn;
 		}
+		delete[] links;
 	}
 
 	ModSynthUG *Copy()
@@ -164,6 +237,13 @@ public:
 		return (ModSynthUG*)p;
 	}
 
+	void CopyInputs(ModSynthUG *tp)
+	{
+		memcpy(inputs, ((DT*)tp)->inputs, IP*sizeof(float));
+		anyChange = 0;
+		out = 0;
+	}
+
 	virtual void SetID(bsInt16 i) { id = i; }
 	virtual bsInt16 GetID() { return id; }
 
@@ -195,6 +275,27 @@ public:
 		return IP;
 	}
 
+	/// Link to an input with the given mode.
+	/// The change flag is set the same as SetInput().
+	int LinkInput(short index, ModSynthLink *lnk, short mode)
+	{
+		if (index < 0 || index >= IP)
+			mode = UGI_CALL;
+		lnk->mode = mode;
+		if (mode != UGI_CALL)
+		{
+			lnk->ip = &inputs[index];
+			lnk->chg = &anyChange;
+			lnk->bit = 1 << index;
+		}
+		return mode;
+	}
+
+	virtual int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		return LinkInput(index, lnk, UGI_SET);
+	}
+
 	virtual const UGParam *FindParam(const char *p)
 	{
 		if (isdigit(*p))
@@ -237,6 +338,7 @@ public:
 	{
 		ModSynthConn *cp = new ModSynthConn(dst, index, when);
 		ctail.InsertBefore(cp);
+		BuildLinks();
 	}
 
 	virtual void RemoveConnect(ModSynthUG *ug, int index = -1)
@@ -248,12 +350,43 @@ public:
 			{
 				conn->Remove();
 				delete conn;
+				BuildLinks();
 				break;
 			}
 			conn = conn->next;
 		}
 	}
 
+	/// Compile the UGP_GEN connections into the links array.
+	void BuildLinks()
+	{
+		delete[] links;
+		links = 0;
+		numLinks = 0;
+
+		int count = 0;
+		ModSynthConn *conn;
+		for (conn = chead.next; conn != &ctail; conn = conn->next)
+		{
+			if (conn->when & UGP_GEN)
+				count++;
+		}
+		if (count == 0)
+			return;
+
+		links = new ModSynthLink[count];
+		for (conn = chead.next; conn != &ctail; conn = conn->next)
+		{
+			if (conn->when & UGP_GEN)
+			{
+				ModSynthLink *lp = &links[numLinks++];
+				lp->ug = conn->ug;
+				lp->index = conn->index;
+				conn->ug->GetInputLink(conn->index, lp);
+			}
+		}
+	}
+
 	virtual void DumpUnit(void (*fn)(const char *))
 	{
 		fn(GetType());
@@ -303,8 +436,22 @@ public:
 		return gen.IsFinished();
 	}
 
+	/// Send a generated value through the compiled links.
+	inline void SendGen(float value)
+	{
+		ModSynthLink *lp = links;
+		ModSynthLink *end = lp + numLinks;
+		while (lp < end)
+			(lp++)->Apply(value);
+	}
+
 	virtual void Send(float value, short mask)
 	{
+		if (mask == UGP_GEN)
+		{
+			SendGen(value);
+			return;
+		}
 		ModSynthConn *conn = chead.next;
 		while (conn != &ctail)
 		{
@@ -325,7 +472,45 @@ public:
 	{
 		// derived class must initialize gen from any changed inputs
 		out = gen.Sample(AmpValue(inputs[0]));
-		Send(out, UGP_GEN);
+		SendGen(out);
+	}
+
+	/// Block version of Tick(). While the block runs, the links
+	/// are replaced by one that records what Tick() sends, so
+	/// that Tick() can be called directly on the derived class.
+	virtual void TickBlock(ModSynthBlkIn *in, int numIn, AmpValue *val, bsInt32 *sent, int frames)
+	{
+		DT *pthis = static_cast<DT*>(this);
+		float sendVal = 0;
+		bsInt32 sendFlg = 0;
+		ModSynthLink rec;
+		rec.ip = &sendVal;
+		rec.chg = &sendFlg;
+		rec.bit = 1;
+		rec.ug = 0;
+		rec.index = 0;
+		rec.mode = UGI_SET;
+		ModSynthLink *saveLinks = links;
+		int saveNum = numLinks;
+		links = &rec;
+		numLinks = 1;
+
+		ModSynthBlkIn *ie = in + numIn;
+		for (int n = 0; n < frames; n++)
+		{
+			for (ModSynthBlkIn *ip = in; ip < ie; ip++)
+			{
+				if (ip->sent[n])
+					ip->lnk.Apply(ip->val[n]);
+			}
+			sendFlg = 0;
+			pthis->DT::Tick();
+			val[n] = sendVal;
+			sent[n] = sendFlg;
+		}
+
+		links = saveLinks;
+		numLinks = saveNum;
 	}
 
 	virtual void InitDefault()
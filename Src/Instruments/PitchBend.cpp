@@ -23,6 +23,7 @@ PitchBend::PitchBend()
 	val = 0;
 	mul = 1.0;
 	frq = 0;
+	ctlRate = 1;
 	int n;
 	for (n = 0; n < PB_RATES; n++)
 		rate[n] = 0;
@@ -42,7 +43,7 @@ void PitchBend::Copy(PitchBend *pb)
 
 void PitchBend::CalcMul()
 {
-	count = (long) (rate[state] * synthParams.sampleRate);
+	count = (long) (rate[state] * synthParams.sampleRate) / ctlRate;
 	beg = frq;
 	end = frq;
 	FrqValue a1 = amnt[state] * 100.0;   // convert semitones to cents
@@ -145,6 +146,7 @@ PitchBendWT::PitchBendWT()
 	lastVal = 0;
 	wave = 0;
 	wtID = WT_TRIP;
+	ctlRate = 1;
 }
 
 PitchBendWT::~PitchBendWT()
@@ -191,13 +193,13 @@ void PitchBendWT::Reset(float initPhs)
 	{
 		if (mode) // absolute
 		{
-			count = (bsInt32) (durSec * synthParams.sampleRate);
-			delay = (bsInt32) (dlySec * synthParams.sampleRate);
+			count = (bsInt32) (durSec * synthParams.sampleRate) / ctlRate;
+			delay = (bsInt32) (dlySec * synthParams.sampleRate) / ctlRate;
 		}
 		else // percent of duration
 		{
-			count = (bsInt32) (durSec * (FrqValue)samples);
-			delay = (bsInt32) (dlySec * (FrqValue)samples);
+			count = (bsInt32) (durSec * (FrqValue)samples) / ctlRate;
+			delay = (bsInt32) (dlySec * (FrqValue)samples) / ctlRate;
 		}
 	}
 	if (sigFrq > 0.0)
@@ -32,6 +32,7 @@ private:
 	FrqValue rate[PB_RATES];
 	FrqValue amnt[PB_AMNTS];
 	long count;
+	bsInt32 ctlRate;
 	int state;
 
 	void CalcMul();
@@ -44,6 +45,10 @@ public:
 	void SetFrequency(FrqValue f) { frq = f; }
 	FrqValue GetFrequency() { return frq; }
 
+	/// Set the number of samples that each call to Gen() advances.
+	/// This is used with GenCtl and takes effect on the next Reset().
+	void SetCtlRate(bsInt32 k) { ctlRate = k < 1 ? 1 : k; }
+
 	void SetAmount(int n, FrqValue a)
 	{
 		if (n < PB_AMNTS)
@@ -115,6 +120,7 @@ private:
 	bsInt32  samples;
 	bsInt32  count;
 	bsInt32  delay;
+	bsInt32  ctlRate;
 	int mode;            ///< 0 = percent, 1 = absolute sec.
 	int wtID;
 	int pbOn;
@@ -131,6 +137,9 @@ public:
 	void SetLevel(AmpValue val)     { depth = val; pbOn = depth > 0; }
 	void SetSigFrq(FrqValue val)    { sigFrq = val; }
 	void SetMode(int m)             { mode = m; }
+	/// Set the number of samples that each call to Gen() advances.
+	/// This is used with GenCtl and takes effect on the next Reset().
+	void SetCtlRate(bsInt32 k)      { ctlRate = k < 1 ? 1 : k; }
 	FrqValue GetDuration()          { return durSec; }
 	FrqValue GetDelay()             { return dlySec; }
 	int GetWavetable()              { return wtID; }
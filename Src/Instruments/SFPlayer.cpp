@@ -69,6 +69,7 @@ SFPlayerInstr::SFPlayerInstr()
 
 	genList = 0;
 	xfdList = 0;
+	freeGen = 0;
 	im = 0;
 }
 
@@ -77,6 +78,7 @@ SFPlayerInstr::SFPlayerInstr(SFPlayerInstr *tp)
 {
 	genList = 0;
 	xfdList = 0;
+	freeGen = 0;
 	im = 0;
 	xfade = 0;
 	monoSet = 1;
@@ -94,6 +96,12 @@ SFPlayerInstr::~SFPlayerInstr()
 		sndbnk->Unlock();
 	ClearZoneList(genList);
 	ClearZoneList(xfdList);
+	SFGen *gen;
+	while ((gen = freeGen) != 0)
+	{
+		freeGen = gen->next;
+		delete gen;
+	}
 }
 
 /// Set the sound bank object directly.
@@ -141,13 +149,16 @@ void SFPlayerInstr::Copy(SFPlayerInstr *tp)
 	pbWT.Copy(&tp->pbWT);
 }
 
+// Generators are moved to the free list for the next note.
 void SFPlayerInstr::ClearZoneList(SFGen *gen)
 {
 	SFGen *g2;
 	while ((g2 = gen) != 0)
 	{
 		gen = g2->next;
-		delete g2;
+		g2->osc.CloseStream();
+		g2->next = freeGen;
+		freeGen = g2;
 	}
 }
 
@@ -166,9 +177,19 @@ SFGen *SFPlayerInstr::BuildZoneList(int pit, int vel)
 				zone = ref->zone;
 				if (zone->Match(pit, vel))
 				{
-					SFGen *gen = new SFGen;
+					SFGen *gen = freeGen;
+					if (gen)
+					{
+						freeGen = gen->next;
+						gen->next = 0;
+						gen->prev = 0;
+					}
+					else
+						gen = new SFGen;
 					gen->CalcPhsIncr(pit, zone);
 					gen->osc.InitSB(zone, SoundBank::GetPow2n1200(gen->phsPC));
+					if (zone->sample->IsStreamed() && sndbnk)
+						gen->osc.SetStream(sndbnk->OpenStream(zone->sample, gen->osc.GetStartFrame()));
 					gen->pan.Set(panSqr, zone->pan);
 					if (list)
 						list->Insert(gen);
@@ -375,11 +396,33 @@ int  SFPlayerInstr::IsFinished()
 	return volEnv.IsFinished();
 }
 
+AmpValue SFPlayerInstr::GetLevel()
+{
+	return vol * volEnv.GetValue();
+}
+
 void SFPlayerInstr::Destroy()
 {
 	delete this;
 }
 
+int SFPlayerInstr::Recycle()
+{
+	ClearZoneList(genList);
+	ClearZoneList(xfdList);
+	genList = 0;
+	xfdList = 0;
+	return 1;
+}
+
+int SFPlayerInstr::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((SFPlayerInstr*)tmplt);
+	return 0;
+}
+
 int SFPlayerInstr::SetParams(VarParamEvent *params)
 {
 	int err = 0;
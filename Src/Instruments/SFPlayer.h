@@ -58,6 +58,7 @@ protected:
 	FrqValue pwFrq;     ///< pitch wheel (pitch cents)
 	SFGen *genList;     ///< primary generator
 	SFGen *xfdList;     ///< cross-fade generator
+	SFGen *freeGen;     ///< generators kept for the next note
 	EnvSegLin fadeEG;   ///< cross-fade interpolator
 	bsInt32 xfade;      ///< flag indicating we are cross-fading
 	EnvGenADSR volEnv;  ///< volume envelope
@@ -105,7 +106,10 @@ public:
 	virtual void Stop();
 	virtual void Tick();
 	virtual int  IsFinished();
+	virtual AmpValue GetLevel();
 	virtual void Destroy();
+	virtual int  Recycle();
+	virtual int  Reinit(Opaque tmplt);
 
 	void SetSoundBank(SoundBank *b);
 	SoundBank *GetSoundBank()       { return sndbnk; }
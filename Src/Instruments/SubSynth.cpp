@@ -96,6 +96,7 @@ SubSynth::~SubSynth()
 
 void SubSynth::Copy(SubSynth *tp)
 {
+	short oldType = fltType;
 	vol = tp->vol;
 	chnl = tp->chnl;
 	osc.SetWavetable(tp->osc.GetWavetable());
@@ -106,13 +107,19 @@ void SubSynth::Copy(SubSynth *tp)
 	fltType = tp->fltType;
 	envSig.Copy(&tp->envSig);
 	envFlt.Copy(&tp->envFlt);
-	CreateFilter();
+	coefRate = tp->coefRate;
+	if (filt == 0 || fltType != oldType)
+		CreateFilter();
+	else
+	{
+		filt->Init(&envFlt, fltGain, fltRes);
+		filt->SetCalcRate(coefRate);
+	}
 	lfoGen.Copy(&tp->lfoGen);
 	nzOn = nzMix > 0;
 	pbOn = tp->pbOn;
 	pbGen.Copy(&tp->pbGen);
 	pbWT.Copy(&tp->pbWT);
-	coefRate = tp->coefRate;
 }
 
 void SubSynth::CreateFilter()
@@ -448,6 +455,39 @@ void SubSynth::Tick()
 	im->Output(chnl, filt->Sample(sigVal) * envSig.Gen() * vol);
 }
 
+int SubSynth::TickBlock(int frames)
+{
+	AmpValue out[MAX_TICKBLOCK];
+	int n;
+	if (pwFrq != 0 || lfoGen.On() || pbOn || pbWT.On())
+	{
+		PhsAccum phm[MAX_TICKBLOCK];
+		for (n = 0; n < frames; n++)
+		{
+			FrqValue phs = pwFrq;
+			if (lfoGen.On())
+				phs += lfoGen.Gen();
+			if (pbOn)
+				phs += pbGen.Gen();
+			if (pbWT.On())
+				phs += pbWT.Gen();
+			phm[n] = phs * synthParams.frqTI;
+		}
+		osc.GenBlockPM(out, phm, frames);
+	}
+	else
+		osc.GenBlock(out, frames);
+	for (n = 0; n < frames; n++)
+	{
+		AmpValue sigVal = out[n];
+		if (nzOn)
+			sigVal = (sigVal * sigMix) + (nz.Gen() * nzMix);
+		out[n] = filt->Sample(sigVal) * envSig.Gen() * vol;
+	}
+	im->OutputBlock(chnl, out, frames);
+	return 1;
+}
+
 int  SubSynth::IsFinished()
 {
 	return envSig.IsFinished();
@@ -458,6 +498,19 @@ void SubSynth::Destroy()
 	delete this;
 }
 
+int SubSynth::Recycle()
+{
+	return 1;
+}
+
+int SubSynth::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((SubSynth*)tmplt);
+	return 0;
+}
+
 int SubSynth::Load(XmlSynthElem *parent)
 {
 	float dvals[7];
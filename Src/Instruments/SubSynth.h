@@ -279,8 +279,11 @@ public:
 	virtual void Param(SeqEvent *evt);
 	virtual void Stop();
 	virtual void Tick();
+	virtual int  TickBlock(int frames);
 	virtual int  IsFinished();
 	virtual void Destroy();
+	virtual int  Recycle();
+	virtual int  Reinit(Opaque tmplt);
 
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
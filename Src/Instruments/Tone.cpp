@@ -111,16 +111,54 @@ void ToneBase::Tick()
 	im->Output(chnl, vol * env.Gen() * osc->Gen());
 }
 
+int ToneBase::TickBlock(int frames)
+{
+	AmpValue out[MAX_TICKBLOCK];
+	int n;
+	if (pwFrq != 0 || lfoGen.On() || pbOn || pbWT.On())
+	{
+		PhsAccum phm[MAX_TICKBLOCK];
+		for (n = 0; n < frames; n++)
+		{
+			FrqValue phs = pwFrq;
+			if (lfoGen.On())
+				phs += lfoGen.Gen();
+			if (pbOn)
+				phs += pbGen.Gen();
+			if (pbWT.On())
+				phs += pbWT.Gen();
+			phm[n] = phs * synthParams.frqTI;
+		}
+		osc->GenBlockPM(out, phm, frames);
+	}
+	else
+		osc->GenBlock(out, frames);
+	for (n = 0; n < frames; n++)
+		out[n] = vol * env.Gen() * out[n];
+	im->OutputBlock(chnl, out, frames);
+	return 1;
+}
+
 int  ToneBase::IsFinished()
 {
 	return env.IsFinished();
 }
 
+AmpValue ToneBase::GetLevel()
+{
+	return vol * env.GetValue();
+}
+
 void ToneBase::Destroy()
 {
 	delete this;
 }
 
+int ToneBase::Recycle()
+{
+	return 1;
+}
+
 int ToneBase::LoadOscil(XmlSynthElem *elem)
 {
 	double dval;
@@ -406,6 +444,14 @@ Instrument *ToneInstr::ToneFactory(InstrManager *m, Opaque tmplt)
 	return ip;
 }
 
+int ToneInstr::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((ToneBase*)tmplt);
+	return 0;
+}
+
 SeqEvent *ToneInstr::ToneEventFactory(Opaque tmplt)
 {
 	VarParamEvent *ep = new VarParamEvent;
@@ -464,6 +510,14 @@ Instrument *ToneFM::ToneFMFactory(InstrManager *m, Opaque tmplt)
 	return ip;
 }
 
+int ToneFM::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((ToneFM*)tmplt);
+	return 0;
+}
+
 SeqEvent *ToneFM::ToneFMEventFactory(Opaque tmplt)
 {
 	VarParamEvent *evt = new VarParamEvent;
@@ -40,8 +40,11 @@ public:
 	virtual void Param(SeqEvent *evt);
 	virtual void Stop();
 	virtual void Tick();
+	virtual int  TickBlock(int frames);
 	virtual int  IsFinished();
+	virtual AmpValue GetLevel();
 	virtual void Destroy();
+	virtual int  Recycle();
 
 	virtual int Load(XmlSynthElem *parent);
 	virtual int Save(XmlSynthElem *parent);
@@ -68,6 +71,7 @@ public:
 	ToneInstr();
 	ToneInstr(ToneInstr *tp);
 	virtual ~ToneInstr();
+	virtual int Reinit(Opaque tmplt);
 	VarParamEvent *AllocParams();
 };
 
@@ -83,6 +87,7 @@ public:
 	ToneFM(ToneFM *tp);
 	virtual ~ToneFM();
 	virtual void Copy(ToneFM *tp);
+	virtual int Reinit(Opaque tmplt);
 	virtual int LoadOscil(XmlSynthElem *elem);
 	virtual int SaveOscil(XmlSynthElem *elem);
 	virtual int SetParam(bsInt16 id, float val);
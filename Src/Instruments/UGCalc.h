@@ -48,7 +48,7 @@ public:
 		if (anyChange)
 		{
 			out = inputs[UGVAL_INP];
-			Send(out, UGP_GEN);
+			SendGen(out);
 			anyChange = 0;
 		}
 	}
@@ -127,6 +127,20 @@ public:
 		}
 	}
 
+	int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		switch (index)
+		{
+		case UGOUT_INP:
+		case UGOUT_LFT:
+		case UGOUT_RGT:
+			return LinkInput(index, lnk, UGI_ADD);
+		case UGOUT_VOL:
+			return LinkInput(index, lnk, UGI_SET);
+		}
+		return LinkInput(index, lnk, UGI_CALL);
+	}
+
 	void Start()
 	{
 		out = 0;
@@ -255,13 +269,19 @@ public:
 		}
 	}
 
+	// val1 depends on the op code, which can change
+	int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		return LinkInput(index, lnk, index == UGCALC_V2 ? UGI_SET : UGI_CALL);
+	}
+
 	void Tick() 
 	{
 		if (anyChange)
 		{
 			anyChange = 0;
 			CalcValue();
-			Send(out, UGP_GEN);
+			SendGen(out);
 		}
 	}
 
@@ -431,7 +451,7 @@ public:
 		if (anyChange)
 		{
 			CalcValue();
-			Send(out, UGP_GEN);
+			SendGen(out);
 		}
 	}
 
@@ -494,7 +514,7 @@ public:
 		{
 			CalcValue();
 			anyChange = 0;
-			Send(out, UGP_GEN);
+			SendGen(out);
 		}
 	}
 
@@ -53,6 +53,11 @@ public:
 		pdt->anyChange |= 1 << index;
 	}
 
+	int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		return this->LinkInput(index, lnk, index == UGDLY_INP ? UGI_ADD : UGI_SET);
+	}
+
 	void Stop()
 	{
 		stopped = 1;
@@ -63,7 +68,7 @@ public:
 		DT *pdt = (DT*)this;
 		pdt->out = pdt->gen.Sample(pdt->inputs[UGDLY_INP] * pdt->inputs[UGDLY_VOL]);
 		pdt->inputs[UGDLY_INP] = 0.0;
-		pdt->Send(pdt->out, UGP_GEN);
+		pdt->SendGen(pdt->out);
 		count -= stopped;
 	}
 };
@@ -202,7 +207,7 @@ public:
 		}
 		out = gen.Sample(inputs[UGDLY_INP] * inputs[UGDLY_VOL]);
 		inputs[UGDLY_INP] = 0.0f;
-		Send(out, UGP_GEN);
+		SendGen(out);
 		count -= stopped;
 	}
 };
@@ -255,6 +260,11 @@ public:
 		anyChange |= 1 << index;
 	}
 
+	int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		return LinkInput(index, lnk, index == UGRVB_INP ? UGI_ADD : UGI_SET);
+	}
+
 	void Start()
 	{
 		gen.InitReverb(inputs[UGRVB_VOL], inputs[UGRVB_RVT]);
@@ -278,7 +288,7 @@ public:
 	{
 		out = gen.Sample(inputs[UGRVB_INP]);
 		inputs[UGRVB_INP] = 0.0f;
-		Send(out, UGP_GEN);
+		SendGen(out);
 		count -= stopped;
 	}
 };
@@ -355,6 +365,11 @@ public:
 		anyChange |= 1 << index;
 	}
 
+	int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		return LinkInput(index, lnk, index == UGFLNG_INP ? UGI_ADD : UGI_SET);
+	}
+
 	int IsFinished()
 	{
 		return count <= 0;
@@ -364,7 +379,7 @@ public:
 	{
 		out = gen.Sample(inputs[UGFLNG_INP]);
 		inputs[UGFLNG_INP] = 0.0f;
-		Send(out, UGP_GEN);
+		SendGen(out);
 		count -= stopped;
 	}
 };
@@ -236,6 +236,11 @@ public:
 		}
 	}
 
+	int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		return LinkInput(index, lnk, UGI_CALL);
+	}
+
 	void Start()
 	{
 		int nsegs = (int) inputs[UGEG_SEGN];
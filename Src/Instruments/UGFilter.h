@@ -50,6 +50,11 @@ public:
 		pdt->anyChange |= 1 << index;
 	}
 
+	int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		return this->LinkInput(index, lnk, index == UGFLT_INP ? UGI_ADD : UGI_SET);
+	}
+
 	virtual void Recalc()
 	{
 	}
@@ -78,7 +83,7 @@ public:
 		}
 		pdt->out = pdt->gen.Sample(pdt->inputs[0]);
 		pdt->inputs[0] = 0;
-		pdt->Send(pdt->out, UGP_GEN);
+		pdt->SendGen(pdt->out);
 	}
 };
 
@@ -283,9 +288,15 @@ public:
 		anyChange |= 1 << index;
 	}
 
+	int GetInputLink(short index, ModSynthLink *lnk)
+	{
+		return LinkInput(index, lnk, index == 0 ? UGI_ADD : UGI_SET);
+	}
+
 	void Start()
 	{
 		gen.InitAP(inputs[1]);
+		gen.Reset();
 		inputs[0] = 0;
 		out = 0;
 	}
@@ -299,7 +310,7 @@ public:
 		}
 		out = gen.Sample(inputs[0]);
 		inputs[0] = 0;
-		Send(out, UGP_GEN);
+		SendGen(out);
 	}
 };
 //@}
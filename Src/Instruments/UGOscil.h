@@ -252,7 +252,7 @@ public:
 			gen.Modulate(inputs[UGOSC_MOD]);
 		anyChange = 0;
 		out = gen.Sample(inputs[0]);
-		Send(out, UGP_GEN);
+		SendGen(out);
 	}
 };
 
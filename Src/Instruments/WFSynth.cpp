@@ -266,6 +266,29 @@ void WFSynth::Tick()
 		eg.Release();
 }
 
+int WFSynth::TickBlock(int frames)
+{
+	AmpValue out[MAX_TICKBLOCK];
+	for (int n = 0; n < frames; n++)
+	{
+		if (sampleNumber >= sampleTotal)
+		{
+			if (!looping)
+			{
+				out[n] = 0;
+				continue;
+			}
+			sampleNumber -= sampleTotal;
+		}
+		out[n] = samples[(int)sampleNumber] * eg.Gen();
+		sampleNumber += sampleIncr;
+		if (!looping && playAll && sampleNumber > sampleRel)
+			eg.Release();
+	}
+	im->OutputBlock(chnl, out, frames);
+	return 1;
+}
+
 int  WFSynth::IsFinished()
 {
 	if (!looping && sampleNumber >= sampleTotal)
@@ -273,11 +296,32 @@ int  WFSynth::IsFinished()
 	return eg.IsFinished();
 }
 
+// The volume is the sustain level of the envelope.
+AmpValue WFSynth::GetLevel()
+{
+	if (!looping && sampleNumber >= sampleTotal)
+		return 0;
+	return eg.GetValue();
+}
+
 void WFSynth::Destroy()
 {
 	delete this;
 }
 
+int WFSynth::Recycle()
+{
+	return 1;
+}
+
+int WFSynth::Reinit(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return -1;
+	Copy((WFSynth *) tmplt);
+	return 0;
+}
+
 int WFSynth::Load(XmlSynthElem *parent)
 {
 	float atk;
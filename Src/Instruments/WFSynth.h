@@ -50,8 +50,12 @@ public:
 	virtual void Param(SeqEvent *evt);
 	virtual void Stop();
 	virtual void Tick();
+	virtual int  TickBlock(int frames);
 	virtual int  IsFinished();
+	virtual AmpValue GetLevel();
 	virtual void Destroy();
+	virtual int  Recycle();
+	virtual int  Reinit(Opaque tmplt);
 
 	int IsUsed(int n)
 	{